@@ -1,15 +1,24 @@
 #include "Application.hpp"
 
 #include <iostream>
+#include <stdexcept>
 
 #include "gloo/utils.hpp"
 #include "gloo/InputManager.hpp"
+#include "gloo/debug/Profiler.hpp"
+#include "gloo/shaders/ShaderProgram.hpp"
 
 namespace GLOO {
-Application::Application(std::string app_name, glm::ivec2 window_size)
-    : app_name_(app_name), window_size_(window_size) {
-  InitializeGLFW();
-  InitializeGUI();
+Application::Application(std::string app_name,
+                         glm::ivec2 window_size,
+                         bool headless)
+    : window_handle_(nullptr), app_name_(app_name), window_size_(window_size) {
+  if (headless) {
+    InitializeHeadless();
+  } else {
+    InitializeGLFW();
+    InitializeGUI();
+  }
 
   scene_ = make_unique<Scene>(make_unique<SceneNode>());
   renderer_ = make_unique<Renderer>(*this);
@@ -19,6 +28,11 @@ Application::~Application() {
   // Release scene resources before destroying everything else.
   scene_.release();
 
+  if (IsHeadless()) {
+    offscreen_target_.reset();
+    headless_context_.reset();
+    return;
+  }
   DestroyGUI();
   glfwDestroyWindow(window_handle_);
   glfwTerminate();
@@ -56,6 +70,7 @@ void Application::InitializeGLFW() {
     std::cerr << "Failed to initialize GLAD!" << std::endl;
     return;
   }
+  ShaderProgram::LoadBinaryFunctions((GLADloadproc)glfwGetProcAddress);
 
   // On retina display, the initial window size will be larger
   // than requested.
@@ -64,6 +79,20 @@ void Application::InitializeGLFW() {
   FramebufferSizeCallback(glm::ivec2(initial_width, initial_height));
 }
 
+void Application::InitializeHeadless() {
+  headless_context_ = make_unique<HeadlessContext>();
+  // Without EGL the context lives in a hidden window that can still serve
+  // input queries.
+  window_handle_ = headless_context_->GetWindow();
+  if (window_handle_ != nullptr) {
+    InputManager::GetInstance().SetWindow(window_handle_);
+  }
+
+  offscreen_target_ = make_unique<Framebuffer>(window_size_);
+  offscreen_target_->Bind();
+  FramebufferSizeCallback(window_size_);
+}
+
 void Application::InitializeGUI() {
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
@@ -82,6 +111,8 @@ void Application::InitializeGUI() {
 }
 
 bool Application::IsFinished() {
+  if (IsHeadless())
+    return true;
   return glfwWindowShouldClose(window_handle_);
 }
 
@@ -110,15 +141,29 @@ void Application::Tick(double delta_time, double current_time) {
   UpdateGUI();
 
   // Logic update before rendering.
-  scene_->Update(delta_time);
+  {
+    ScopedTimer timer("Scene::Update");
+    scene_->Update(delta_time);
+  }
 
   // Rendering scene and GUI.
   renderer_->Render(*scene_);
-  RenderGUI();
+  {
+    ScopedTimer timer("GUI rendering");
+    RenderGUI();
+  }
 
   glfwSwapBuffers(window_handle_);
 }
 
+void Application::RenderOffscreen() {
+  if (!IsHeadless()) {
+    throw std::runtime_error("Offscreen rendering needs a headless app!");
+  }
+  offscreen_target_->Bind();
+  renderer_->Render(*scene_);
+}
+
 void Application::FramebufferSizeCallback(glm::ivec2 window_size) {
   window_size_ = window_size;
   GL_CHECK(glViewport(0, 0, window_size_.x, window_size_.y));
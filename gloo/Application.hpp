@@ -7,11 +7,17 @@
 #include "external.hpp"
 #include "Scene.hpp"
 #include "Renderer.hpp"
+#include "HeadlessContext.hpp"
+#include "gl_wrapper/Framebuffer.hpp"
 
 namespace GLOO {
 class Application {
  public:
-  Application(std::string app_name, glm::ivec2 window_size);
+  // A headless application renders into an offscreen framebuffer of
+  // window_size without opening a window or the GUI; see RenderOffscreen.
+  Application(std::string app_name,
+              glm::ivec2 window_size,
+              bool headless = false);
   virtual ~Application();
   bool IsFinished();
   void Tick(double delta_time, double current_time);
@@ -25,10 +31,20 @@ class Application {
   virtual void DrawGUI() {
   }
   virtual void SetupScene() = 0;
+  Renderer& GetRenderer() {
+    return *renderer_;
+  }
+  bool IsHeadless() const {
+    return headless_context_ != nullptr;
+  }
+  // Renders the scene into the offscreen framebuffer, which stays bound for
+  // reading the pixels back. Headless applications only.
+  void RenderOffscreen();
   std::unique_ptr<Scene> scene_;
 
  private:
   void InitializeGLFW();
+  void InitializeHeadless();
   void InitializeGUI();
   void SetRenderingOptions();
   void UpdateGUI();
@@ -40,6 +56,8 @@ class Application {
   glm::ivec2 window_size_;
 
   std::unique_ptr<Renderer> renderer_;
+  std::unique_ptr<HeadlessContext> headless_context_;
+  std::unique_ptr<Framebuffer> offscreen_target_;
 };
 }  // namespace GLOO
 
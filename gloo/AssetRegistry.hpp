@@ -0,0 +1,102 @@
+#ifndef GLOO_ASSET_REGISTRY_H_
+#define GLOO_ASSET_REGISTRY_H_
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace GLOO {
+// Shares assets between their users by key. The registry only holds weak
+// references: an asset lives as long as someone uses it, and is created
+// again on the next request after the last user let go. Thread-safe.
+template <class T>
+class AssetRegistry {
+ public:
+  using Factory = std::function<std::shared_ptr<T>()>;
+
+  AssetRegistry() = default;
+  AssetRegistry(const AssetRegistry&) = delete;
+  AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+  // Returns the asset registered under key if it is still alive, and
+  // otherwise creates and registers it with create. create runs without
+  // the registry locked, and must not request the same key. Concurrent
+  // requests for a key being created wait for that asset, or rethrow what
+  // create threw, rather than creating their own.
+  std::shared_ptr<T> GetOrCreate(const std::string& key,
+                                 const Factory& create) {
+    std::promise<std::shared_ptr<T>> promise;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      Entry& entry = entries_[key];
+      std::shared_ptr<T> asset = entry.asset.lock();
+      if (asset != nullptr)
+        return asset;
+      if (entry.pending.valid()) {
+        std::shared_future<std::shared_ptr<T>> pending = entry.pending;
+        lock.unlock();
+        return pending.get();
+      }
+      entry.pending = promise.get_future().share();
+      PruneLocked();
+    }
+
+    std::shared_ptr<T> asset;
+    try {
+      asset = create();
+    } catch (...) {
+      Finish(key, nullptr);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+    Finish(key, asset);
+    promise.set_value(asset);
+    return asset;
+  }
+
+  // Assets currently in use, e.g. for statistics.
+  size_t GetNumAlive() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t num_alive = 0;
+    for (const auto& entry : entries_) {
+      if (!entry.second.asset.expired())
+        num_alive++;
+    }
+    return num_alive;
+  }
+
+ private:
+  struct Entry {
+    std::weak_ptr<T> asset;
+    // Valid while the asset is being created.
+    std::shared_future<std::shared_ptr<T>> pending;
+  };
+
+  void Finish(const std::string& key, const std::shared_ptr<T>& asset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[key];
+    entry.asset = asset;
+    entry.pending = std::shared_future<std::shared_ptr<T>>();
+  }
+
+  // Forgets the keys of released assets, so that the map does not grow
+  // with every key ever requested.
+  void PruneLocked() {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.asset.expired() && !it->second.pending.valid())
+        it = entries_.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,62 @@
+#include "BoundingBox.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace GLOO {
+BoundingSphere BoundingSphere::Transform(const glm::mat4& matrix) const {
+  float max_scale_sq = std::max(
+      glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+      std::max(glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])),
+               glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))));
+  BoundingSphere sphere;
+  sphere.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+  sphere.radius = radius * std::sqrt(max_scale_sq);
+  return sphere;
+}
+
+BoundingBox::BoundingBox()
+    : min_(std::numeric_limits<float>::max()),
+      max_(-std::numeric_limits<float>::max()) {
+}
+
+BoundingBox::BoundingBox(const glm::vec3& min_corner,
+                         const glm::vec3& max_corner)
+    : min_(min_corner), max_(max_corner) {
+}
+
+BoundingBox BoundingBox::FromPoints(const std::vector<glm::vec3>& points) {
+  BoundingBox box;
+  for (const glm::vec3& point : points) {
+    box.Expand(point);
+  }
+  return box;
+}
+
+void BoundingBox::Expand(const glm::vec3& point) {
+  min_ = glm::min(min_, point);
+  max_ = glm::max(max_, point);
+}
+
+void BoundingBox::Expand(const BoundingBox& other) {
+  if (other.IsEmpty())
+    return;
+  min_ = glm::min(min_, other.min_);
+  max_ = glm::max(max_, other.max_);
+}
+
+BoundingBox BoundingBox::Transform(const glm::mat4& matrix) const {
+  if (IsEmpty())
+    return *this;
+  // Arvo's method: the transformed extents are the original extents
+  // weighted by the absolute values of the linear part of the matrix.
+  glm::vec3 center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+  glm::vec3 extents = GetExtents();
+  glm::vec3 new_extents(0.0f);
+  for (int col = 0; col < 3; col++) {
+    new_extents += glm::abs(glm::vec3(matrix[col])) * extents[col];
+  }
+  return BoundingBox(center - new_extents, center + new_extents);
+}
+}  // namespace GLOO
@@ -0,0 +1,54 @@
+#ifndef GLOO_BOUNDING_BOX_H_
+#define GLOO_BOUNDING_BOX_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace GLOO {
+struct BoundingSphere {
+  glm::vec3 center;
+  float radius;
+
+  // Bounds the sphere after transforming it by matrix. Non-uniform scales
+  // enlarge the radius by the largest axis scale.
+  BoundingSphere Transform(const glm::mat4& matrix) const;
+};
+
+// Axis-aligned bounding box. A default-constructed box is empty and
+// contains nothing.
+class BoundingBox {
+ public:
+  BoundingBox();
+  BoundingBox(const glm::vec3& min_corner, const glm::vec3& max_corner);
+
+  static BoundingBox FromPoints(const std::vector<glm::vec3>& points);
+
+  bool IsEmpty() const {
+    return min_.x > max_.x;
+  }
+  const glm::vec3& GetMin() const {
+    return min_;
+  }
+  const glm::vec3& GetMax() const {
+    return max_;
+  }
+  glm::vec3 GetCenter() const {
+    return 0.5f * (min_ + max_);
+  }
+  glm::vec3 GetExtents() const {
+    return 0.5f * (max_ - min_);
+  }
+
+  void Expand(const glm::vec3& point);
+  void Expand(const BoundingBox& other);
+  // Bounds the box after transforming it by matrix.
+  BoundingBox Transform(const glm::mat4& matrix) const;
+
+ private:
+  glm::vec3 min_;
+  glm::vec3 max_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,224 @@
+#include "CharacterBundle.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+const char kMagic[8] = {'G', 'L', 'O', 'O', 'C', 'H', 'R', '\0'};
+const uint64_t kAlignment = 16;
+
+enum SectionId : uint32_t {
+  kJointPositions,
+  kJointParents,
+  kBindMatrices,
+  kPositions,
+  kNormals,
+  kIndices,
+  kInfluenceOffsets,
+  kInfluences,
+  kIncidentOffsets,
+  kIncidentTriangles,
+  kNumSections
+};
+
+struct BundleHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_sections;
+};
+
+struct SectionEntry {
+  uint32_t id;
+  // Checked on load, so that a bundle written with a different struct
+  // layout is rejected instead of misread.
+  uint32_t element_size;
+  uint64_t offset;
+  uint64_t count;
+};
+
+struct SectionSource {
+  const void* data;
+  uint32_t element_size;
+  uint64_t count;
+};
+
+template <class T>
+SectionSource MakeSource(const GLOO::ArrayView<T>& view) {
+  return {view.data(), sizeof(T), view.size()};
+}
+
+template <class T>
+GLOO::ArrayView<T> GetSection(const char* data, const SectionEntry& entry) {
+  return GLOO::ArrayView<T>(reinterpret_cast<const T*>(data + entry.offset),
+                            static_cast<size_t>(entry.count));
+}
+
+uint64_t AlignUp(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+void Fail(const std::string& file_path, const std::string& reason) {
+  throw std::runtime_error("Invalid character bundle " + file_path + ": " +
+                           reason);
+}
+
+template <class T>
+void CheckOffsets(const std::string& file_path,
+                  const GLOO::ArrayView<uint32_t>& offsets,
+                  const GLOO::ArrayView<T>& elements,
+                  size_t num_vertices) {
+  if (offsets.size() != num_vertices + 1 || offsets[0] != 0 ||
+      offsets[num_vertices] != elements.size()) {
+    Fail(file_path, "bad offset table");
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    if (offsets[v] > offsets[v + 1])
+      Fail(file_path, "bad offset table");
+  }
+}
+
+// A bundle is trusted as much as the text files, but a truncated or
+// corrupted one must not make the skinning code read out of bounds.
+void Validate(const std::string& file_path,
+              const GLOO::CharacterView& view) {
+  size_t num_joints = view.joint_positions.size();
+  size_t num_bones = num_joints == 0 ? 0 : num_joints - 1;
+  size_t num_vertices = view.positions.size();
+  if (view.joint_parents.size() != num_joints ||
+      view.bind_matrices.size() != num_bones ||
+      view.normals.size() != num_vertices || view.indices.size() % 3 != 0) {
+    Fail(file_path, "inconsistent array sizes");
+  }
+  for (int32_t parent : view.joint_parents) {
+    if (parent < -1 || parent >= static_cast<int32_t>(num_joints))
+      Fail(file_path, "joint parent out of range");
+  }
+  for (unsigned int index : view.indices) {
+    if (index >= num_vertices)
+      Fail(file_path, "vertex index out of range");
+  }
+  CheckOffsets(file_path, view.influence_offsets, view.influences,
+               num_vertices);
+  for (const auto& influence : view.influences) {
+    if (influence.bone >= num_bones)
+      Fail(file_path, "bone index out of range");
+  }
+  CheckOffsets(file_path, view.incident_offsets, view.incident_triangles,
+               num_vertices);
+  for (uint32_t triangle : view.incident_triangles) {
+    if (triangle >= view.indices.size() / 3)
+      Fail(file_path, "triangle index out of range");
+  }
+}
+}  // namespace
+
+namespace GLOO {
+const uint32_t CharacterBundle::kVersion;
+
+bool CharacterBundle::Open(const std::string& file_path,
+                           CharacterView& view) {
+  if (!file_.Open(file_path))
+    return false;
+  const char* data = file_.GetData();
+  size_t size = file_.GetSize();
+  BundleHeader header;
+  if (size < sizeof(header))
+    Fail(file_path, "file too short");
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0)
+    Fail(file_path, "not a character bundle");
+  if (header.version != kVersion)
+    Fail(file_path, "version " + std::to_string(header.version) +
+                        ", expected " + std::to_string(kVersion));
+  if (header.num_sections != kNumSections ||
+      size < sizeof(header) + kNumSections * sizeof(SectionEntry)) {
+    Fail(file_path, "bad section table");
+  }
+
+  SectionEntry entries[kNumSections];
+  uint32_t element_sizes[kNumSections] = {
+      sizeof(glm::vec3), sizeof(int32_t),        sizeof(glm::mat4),
+      sizeof(glm::vec3), sizeof(glm::vec3),      sizeof(unsigned int),
+      sizeof(uint32_t),  sizeof(JointInfluence), sizeof(uint32_t),
+      sizeof(uint32_t)};
+  std::memcpy(entries, data + sizeof(header), sizeof(entries));
+  for (uint32_t i = 0; i < kNumSections; i++) {
+    const SectionEntry& entry = entries[i];
+    if (entry.id != i || entry.element_size != element_sizes[i] ||
+        entry.offset % kAlignment != 0 || entry.offset > size ||
+        entry.count > (size - entry.offset) / entry.element_size) {
+      Fail(file_path, "bad section " + std::to_string(i));
+    }
+  }
+
+  view.joint_positions = GetSection<glm::vec3>(data, entries[kJointPositions]);
+  view.joint_parents = GetSection<int32_t>(data, entries[kJointParents]);
+  view.bind_matrices = GetSection<glm::mat4>(data, entries[kBindMatrices]);
+  view.positions = GetSection<glm::vec3>(data, entries[kPositions]);
+  view.normals = GetSection<glm::vec3>(data, entries[kNormals]);
+  view.indices = GetSection<unsigned int>(data, entries[kIndices]);
+  view.influence_offsets =
+      GetSection<uint32_t>(data, entries[kInfluenceOffsets]);
+  view.influences = GetSection<JointInfluence>(data, entries[kInfluences]);
+  view.incident_offsets =
+      GetSection<uint32_t>(data, entries[kIncidentOffsets]);
+  view.incident_triangles =
+      GetSection<uint32_t>(data, entries[kIncidentTriangles]);
+  Validate(file_path, view);
+  return true;
+}
+
+void CharacterBundle::Close() {
+  file_.Close();
+}
+
+void CharacterBundle::Write(const std::string& file_path,
+                            const CharacterView& character) {
+  SectionSource sources[kNumSections] = {
+      MakeSource(character.joint_positions),
+      MakeSource(character.joint_parents),
+      MakeSource(character.bind_matrices),
+      MakeSource(character.positions),
+      MakeSource(character.normals),
+      MakeSource(character.indices),
+      MakeSource(character.influence_offsets),
+      MakeSource(character.influences),
+      MakeSource(character.incident_offsets),
+      MakeSource(character.incident_triangles)};
+
+  BundleHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.num_sections = kNumSections;
+  SectionEntry entries[kNumSections];
+  uint64_t offset =
+      AlignUp(sizeof(header) + kNumSections * sizeof(SectionEntry));
+  for (uint32_t i = 0; i < kNumSections; i++) {
+    entries[i].id = i;
+    entries[i].element_size = sources[i].element_size;
+    entries[i].offset = offset;
+    entries[i].count = sources[i].count;
+    offset = AlignUp(offset + sources[i].count * sources[i].element_size);
+  }
+
+  std::ofstream fs(file_path, std::ios::binary);
+  if (!fs) {
+    throw std::runtime_error("Unable to write character bundle " +
+                             file_path + "!");
+  }
+  fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fs.write(reinterpret_cast<const char*>(entries), sizeof(entries));
+  const char padding[kAlignment] = {};
+  for (uint32_t i = 0; i < kNumSections; i++) {
+    uint64_t position = static_cast<uint64_t>(fs.tellp());
+    fs.write(padding, entries[i].offset - position);
+    fs.write(static_cast<const char*>(sources[i].data),
+             sources[i].count * sources[i].element_size);
+  }
+  if (!fs) {
+    throw std::runtime_error("Unable to write character bundle " +
+                             file_path + "!");
+  }
+}
+}  // namespace GLOO
@@ -0,0 +1,34 @@
+#ifndef GLOO_CHARACTER_BUNDLE_H_
+#define GLOO_CHARACTER_BUNDLE_H_
+
+#include <string>
+
+#include "CharacterData.hpp"
+#include "MappedFile.hpp"
+
+namespace GLOO {
+// Binary file holding a compiled character: a header, a section table and
+// one 16-byte aligned array per CharacterView member, in native byte
+// order. Opening one maps it into memory and points a CharacterView at the
+// arrays in place, so loading does no parsing and no copying.
+class CharacterBundle {
+ public:
+  // Bumped whenever the layout or the meaning of a section changes;
+  // bundles of other versions are rejected and must be rebuilt.
+  static const uint32_t kVersion = 1;
+
+  // Maps the bundle and fills view with arrays that stay valid until the
+  // bundle is closed or destroyed. Returns false if the file does not
+  // exist; throws if it is not a valid bundle of this version.
+  bool Open(const std::string& file_path, CharacterView& view);
+  void Close();
+
+  static void Write(const std::string& file_path,
+                    const CharacterView& character);
+
+ private:
+  MappedFile file_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,108 @@
+#include "CharacterData.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace GLOO {
+CharacterView CharacterData::GetView() const {
+  CharacterView view;
+  view.joint_positions = joint_positions;
+  view.joint_parents = joint_parents;
+  view.bind_matrices = bind_matrices;
+  view.positions = positions;
+  view.normals = normals;
+  view.indices = indices;
+  view.influence_offsets = influence_offsets;
+  view.influences = influences;
+  view.incident_offsets = incident_offsets;
+  view.incident_triangles = incident_triangles;
+  return view;
+}
+
+namespace {
+// Whether corner c of the triangle is the first one with its vertex, so
+// that degenerate triangles are listed once per vertex.
+bool IsFirstCorner(const unsigned int* triangle, int c) {
+  return (c < 1 || triangle[0] != triangle[c]) &&
+         (c < 2 || triangle[1] != triangle[c]);
+}
+}  // namespace
+
+bool ComputeBindMatrices(const std::vector<glm::vec3>& joint_positions,
+                         const std::vector<int32_t>& joint_parents,
+                         std::vector<glm::mat4>& bind_matrices) {
+  // World matrices of the bind pose are composed from the root down, in
+  // the same order as the scene graph composes them.
+  size_t num_joints = joint_parents.size();
+  std::vector<int> chain;
+  bind_matrices.clear();
+  for (size_t i = 0; i < num_joints; i++) {
+    chain.clear();
+    for (int joint = static_cast<int>(i); joint != -1;
+         joint = joint_parents[joint]) {
+      if (joint < -1 || joint >= static_cast<int>(num_joints) ||
+          chain.size() == num_joints) {
+        return false;
+      }
+      chain.push_back(joint);
+    }
+    glm::mat4 world(1.0f);
+    for (size_t k = chain.size(); k-- > 0;) {
+      world = world * glm::translate(glm::mat4(1.0f),
+                                     joint_positions[chain[k]]);
+    }
+    // The root has no bone.
+    if (i > 0)
+      bind_matrices.push_back(glm::inverse(world));
+  }
+  return true;
+}
+
+void FindIncidentTriangles(const IndexArray& indices,
+                           size_t num_vertices,
+                           std::vector<uint32_t>& offsets,
+                           std::vector<uint32_t>& triangles) {
+  // Counting sort by vertex: count, prefix sum, then scatter in triangle
+  // order so that each list comes out sorted.
+  size_t num_triangles = indices.size() / 3;
+  offsets.assign(num_vertices + 1, 0);
+  for (size_t t = 0; t < num_triangles; t++) {
+    for (int c = 0; c < 3; c++) {
+      if (IsFirstCorner(&indices[3 * t], c))
+        offsets[indices[3 * t + c] + 1]++;
+    }
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    offsets[v + 1] += offsets[v];
+  }
+  triangles.resize(offsets[num_vertices]);
+  std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < num_triangles; t++) {
+    for (int c = 0; c < 3; c++) {
+      if (IsFirstCorner(&indices[3 * t], c))
+        triangles[cursors[indices[3 * t + c]]++] = static_cast<uint32_t>(t);
+    }
+  }
+}
+
+void ComputeVertexNormals(const CharacterView& character,
+                          const glm::vec3* positions,
+                          glm::vec3* normals) {
+  const unsigned int* indices = character.indices.data();
+  size_t num_vertices = character.incident_offsets.size() - 1;
+  for (size_t v = 0; v < num_vertices; v++) {
+    glm::vec3 vertex_normal(0.0f);
+    for (uint32_t i = character.incident_offsets[v];
+         i < character.incident_offsets[v + 1]; i++) {
+      const unsigned int* triangle =
+          indices + 3 * character.incident_triangles[i];
+      glm::vec3 a = positions[triangle[0]];
+      glm::vec3 b = positions[triangle[1]];
+      glm::vec3 c = positions[triangle[2]];
+      glm::vec3 cross = glm::cross(b - a, c - a);
+      // Weighted by triangle area.
+      vertex_normal += glm::normalize(cross) * (glm::length(cross) / 2);
+    }
+    normals[v] = glm::normalize(vertex_normal);
+  }
+}
+}  // namespace GLOO
@@ -0,0 +1,118 @@
+#ifndef GLOO_CHARACTER_DATA_H_
+#define GLOO_CHARACTER_DATA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "alias_types.hpp"
+
+namespace GLOO {
+// Read-only view of a contiguous array owned elsewhere, e.g. by a vector or
+// a memory-mapped file.
+template <class T>
+class ArrayView {
+ public:
+  ArrayView() : data_(nullptr), size_(0) {
+  }
+  ArrayView(const T* data, size_t size) : data_(data), size_(size) {
+  }
+  ArrayView(const std::vector<T>& vector)
+      : data_(vector.data()), size_(vector.size()) {
+  }
+
+  const T* data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  const T* begin() const {
+    return data_;
+  }
+  const T* end() const {
+    return data_ + size_;
+  }
+  const T& operator[](size_t i) const {
+    return data_[i];
+  }
+
+ private:
+  const T* data_;
+  size_t size_;
+};
+
+// One bone's weight on a vertex. Bone j is deformed by the j-th skinning
+// matrix and belongs to joint j + 1, as the root has no bone.
+struct JointInfluence {
+  uint32_t bone;
+  float weight;
+};
+
+// Everything needed to instantiate a skinned character, as views into
+// storage owned by a CharacterData or a CharacterBundle.
+struct CharacterView {
+  // Joint offsets from their parents and parent indices (-1 for roots).
+  ArrayView<glm::vec3> joint_positions;
+  ArrayView<int32_t> joint_parents;
+  // Inverse bind-pose world matrix of each bone.
+  ArrayView<glm::mat4> bind_matrices;
+
+  // Bind-pose mesh. Meshes parsed from .obj files are optimized for the
+  // vertex caches on the way in.
+  ArrayView<glm::vec3> positions;
+  ArrayView<glm::vec3> normals;
+  ArrayView<unsigned int> indices;
+
+  // Nonzero influences of vertex v are influences[influence_offsets[v]]
+  // up to influences[influence_offsets[v + 1]], in increasing bone order.
+  ArrayView<uint32_t> influence_offsets;
+  ArrayView<JointInfluence> influences;
+
+  // Triangles using vertex v, in increasing order, laid out the same way.
+  ArrayView<uint32_t> incident_offsets;
+  ArrayView<uint32_t> incident_triangles;
+};
+
+// Owning storage for a character built from its source files.
+struct CharacterData {
+  std::vector<glm::vec3> joint_positions;
+  std::vector<int32_t> joint_parents;
+  std::vector<glm::mat4> bind_matrices;
+  PositionArray positions;
+  NormalArray normals;
+  IndexArray indices;
+  std::vector<uint32_t> influence_offsets;
+  std::vector<JointInfluence> influences;
+  std::vector<uint32_t> incident_offsets;
+  std::vector<uint32_t> incident_triangles;
+
+  CharacterView GetView() const;
+};
+
+// Computes the inverse bind-pose world matrix of each bone of a skeleton
+// whose joints are only translated relative to their parents. Returns
+// false if the parents do not form a forest.
+bool ComputeBindMatrices(const std::vector<glm::vec3>& joint_positions,
+                         const std::vector<int32_t>& joint_parents,
+                         std::vector<glm::mat4>& bind_matrices);
+
+// Builds the vertex-to-triangle adjacency of an indexed triangle mesh.
+void FindIncidentTriangles(const IndexArray& indices,
+                           size_t num_vertices,
+                           std::vector<uint32_t>& offsets,
+                           std::vector<uint32_t>& triangles);
+
+// Computes area-weighted vertex normals of the character's mesh with its
+// vertices at the given positions.
+void ComputeVertexNormals(const CharacterView& character,
+                          const glm::vec3* positions,
+                          glm::vec3* normals);
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,335 @@
+#include "DerivedDataCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+namespace {
+const char kIndexName[] = "index";
+const char kStagingSuffix[] = ".tmp";
+// Staged files untouched for this long are left behind by a writer that
+// crashed or failed, rather than still being written.
+const double kStaleStagingSeconds = 60.0 * 60.0;
+
+// MurmurHash64A. Keys only have to be stable on the machine that wrote
+// them, so the words are read in native byte order.
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  uint64_t h = seed ^ (size * m);
+  size_t num_words = size / 8;
+  for (size_t i = 0; i < num_words; i++) {
+    uint64_t k;
+    std::memcpy(&k, bytes + 8 * i, sizeof(k));
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  const unsigned char* tail = bytes + 8 * num_words;
+  size_t tail_size = size & 7;
+  if (tail_size > 0) {
+    for (size_t i = tail_size; i-- > 0;) {
+      h ^= static_cast<uint64_t>(tail[i]) << (8 * i);
+    }
+    h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+uint64_t GetFileSize(const std::string& file_path) {
+  std::ifstream fs(file_path, std::ios::binary | std::ios::ate);
+  return fs ? static_cast<uint64_t>(fs.tellg()) : 0;
+}
+
+bool FileExists(const std::string& file_path) {
+  return std::ifstream(file_path).good();
+}
+
+// Seconds since the file was last written, or 0 if it cannot be read.
+double GetFileAge(const std::string& file_path) {
+  struct stat info;
+  if (stat(file_path.c_str(), &info) != 0)
+    return 0.0;
+  return std::difftime(std::time(nullptr), info.st_mtime);
+}
+
+void MakeDirectory(const std::string& directory) {
+#ifdef _WIN32
+  _mkdir(directory.c_str());
+#else
+  mkdir(directory.c_str(), 0755);
+#endif
+}
+
+std::vector<std::string> ListFiles(const std::string& directory) {
+  std::vector<std::string> names;
+#ifdef _WIN32
+  WIN32_FIND_DATAA data;
+  HANDLE handle = FindFirstFileA((directory + "*").c_str(), &data);
+  if (handle == INVALID_HANDLE_VALUE)
+    return names;
+  do {
+    if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+      names.push_back(data.cFileName);
+  } while (FindNextFileA(handle, &data));
+  FindClose(handle);
+#else
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr)
+    return names;
+  while (dirent* entry = readdir(dir)) {
+    names.push_back(entry->d_name);
+  }
+  closedir(dir);
+#endif
+  return names;
+}
+
+// Keys are the 32 hex digits MakeKey() prints.
+bool IsKey(const std::string& name) {
+  if (name.size() != 32)
+    return false;
+  for (char c : name) {
+    if (!std::isxdigit(static_cast<unsigned char>(c)))
+      return false;
+  }
+  return true;
+}
+
+bool IsStagingName(const std::string& name) {
+  size_t suffix_size = sizeof(kStagingSuffix) - 1;
+  return name.size() > suffix_size &&
+         name.compare(name.size() - suffix_size, suffix_size,
+                      kStagingSuffix) == 0;
+}
+
+// Names of staged files differ between processes and between calls, so
+// that concurrent writers never write to the same file.
+std::string MakeStagingPath(const std::string& path) {
+  static std::atomic<unsigned long> counter(0);
+#ifdef _WIN32
+  long pid = _getpid();
+#else
+  long pid = getpid();
+#endif
+  return path + "." + std::to_string(pid) + "-" +
+         std::to_string(counter++) + kStagingSuffix;
+}
+
+// Held while an index is loaded, modified and saved.
+std::mutex& GetIndexMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// std::rename does not replace an existing file on Windows.
+bool ReplaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+  std::remove(to.c_str());
+#endif
+  return std::rename(from.c_str(), to.c_str()) == 0;
+}
+}  // namespace
+
+namespace GLOO {
+DerivedDataCache::DerivedDataCache(const std::string& directory,
+                                   uint64_t max_bytes)
+    : directory_(directory), max_bytes_(max_bytes) {
+  if (!directory_.empty() && directory_.back() != '/')
+    directory_ += '/';
+  // Missing parents are created too. Fails harmlessly for directories that
+  // exist. If one cannot be created, every lookup misses and Insert()
+  // throws.
+  for (size_t sep = directory_.find('/', 1); sep != std::string::npos;
+       sep = directory_.find('/', sep + 1)) {
+    MakeDirectory(directory_.substr(0, sep));
+  }
+  std::lock_guard<std::mutex> lock(GetIndexMutex());
+  LoadIndex();
+  Rescan();
+  Evict();
+  SaveIndex();
+}
+
+std::string DerivedDataCache::MakeKey(
+    const std::vector<std::string>& file_paths,
+    const std::string& salt) {
+  // Two independently seeded 64-bit hashes, so that an accidental collision
+  // is out of the question.
+  uint64_t lanes[2] = {HashBytes(salt.data(), salt.size(), 1),
+                       HashBytes(salt.data(), salt.size(), 2)};
+  for (const std::string& file_path : file_paths) {
+    MappedFile file;
+    if (!file.Open(file_path))
+      return "";
+    for (uint64_t& lane : lanes) {
+      lane = HashBytes(file.GetData(), file.GetSize(), lane);
+    }
+  }
+  char key[33];
+  std::snprintf(key, sizeof(key), "%016llx%016llx",
+                static_cast<unsigned long long>(lanes[0]),
+                static_cast<unsigned long long>(lanes[1]));
+  return key;
+}
+
+std::string DerivedDataCache::Find(const std::string& key) {
+  std::lock_guard<std::mutex> lock(GetIndexMutex());
+  LoadIndex();
+  auto it = std::find_if(entries_.begin(), entries_.end(),
+                         [&key](const Entry& e) { return e.key == key; });
+  if (it == entries_.end())
+    return "";
+  Entry entry = *it;
+  entries_.erase(it);
+  std::string entry_path = GetEntryPath(key);
+  bool exists = FileExists(entry_path);
+  if (exists)
+    entries_.push_back(entry);
+  SaveIndex();
+  return exists ? entry_path : "";
+}
+
+std::string DerivedDataCache::GetStagingPath(const std::string& key) const {
+  return MakeStagingPath(GetEntryPath(key));
+}
+
+void DerivedDataCache::Insert(const std::string& key,
+                              const std::string& staging_path) {
+  uint64_t size = GetFileSize(staging_path);
+  std::lock_guard<std::mutex> lock(GetIndexMutex());
+  if (!ReplaceFile(staging_path, GetEntryPath(key))) {
+    std::remove(staging_path.c_str());
+    throw std::runtime_error("Unable to add " + staging_path +
+                             " to the cache!");
+  }
+  LoadIndex();
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [&key](const Entry& e) {
+                                  return e.key == key;
+                                }),
+                 entries_.end());
+  entries_.push_back({key, size});
+  Evict();
+  SaveIndex();
+}
+
+void DerivedDataCache::Remove(const std::string& key) {
+  std::lock_guard<std::mutex> lock(GetIndexMutex());
+  LoadIndex();
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [&key](const Entry& e) {
+                                  return e.key == key;
+                                }),
+                 entries_.end());
+  std::remove(GetEntryPath(key).c_str());
+  SaveIndex();
+}
+
+std::string DerivedDataCache::GetEntryPath(const std::string& key) const {
+  return directory_ + key;
+}
+
+void DerivedDataCache::LoadIndex() {
+  entries_.clear();
+  std::ifstream fs(directory_ + kIndexName);
+  Entry entry;
+  while (fs >> entry.key >> entry.size) {
+    entries_.push_back(entry);
+  }
+}
+
+void DerivedDataCache::SaveIndex() const {
+  // Written aside and renamed over the old index, so that a crash or a
+  // concurrent reader never sees a partial one. Failing to save only
+  // loses recency information.
+  std::string index_path = directory_ + kIndexName;
+  std::string staging_path = MakeStagingPath(index_path);
+  {
+    std::ofstream fs(staging_path);
+    for (const Entry& entry : entries_) {
+      fs << entry.key << ' ' << entry.size << '\n';
+    }
+    if (!fs)
+      return;
+  }
+  if (!ReplaceFile(staging_path, index_path))
+    std::remove(staging_path.c_str());
+}
+
+void DerivedDataCache::Rescan() {
+  std::vector<std::string> names = ListFiles(directory_);
+  // Staged files that were never inserted would otherwise stay forever,
+  // uncounted by the budget.
+  for (const std::string& name : names) {
+    if (IsStagingName(name) &&
+        GetFileAge(directory_ + name) > kStaleStagingSeconds) {
+      std::remove((directory_ + name).c_str());
+    }
+  }
+  std::sort(names.begin(), names.end());
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                [&names](const Entry& e) {
+                                  return !std::binary_search(
+                                      names.begin(), names.end(), e.key);
+                                }),
+                 entries_.end());
+
+  std::vector<std::string> indexed;
+  for (const Entry& entry : entries_) {
+    indexed.push_back(entry.key);
+  }
+  std::sort(indexed.begin(), indexed.end());
+  std::vector<Entry> orphans;
+  for (const std::string& name : names) {
+    if (IsKey(name) &&
+        !std::binary_search(indexed.begin(), indexed.end(), name)) {
+      orphans.push_back({name, GetFileSize(GetEntryPath(name))});
+    }
+  }
+  // Nothing is known about their recency; evict them first.
+  entries_.insert(entries_.begin(), orphans.begin(), orphans.end());
+}
+
+void DerivedDataCache::Evict() {
+  uint64_t total_size = 0;
+  for (const Entry& entry : entries_) {
+    total_size += entry.size;
+  }
+  // The newest entry is kept even if it alone exceeds the budget, since it
+  // is about to be used.
+  size_t num_evicted = 0;
+  while (total_size > max_bytes_ && num_evicted + 1 < entries_.size()) {
+    const Entry& entry = entries_[num_evicted++];
+    std::remove(GetEntryPath(entry.key).c_str());
+    total_size -= entry.size;
+  }
+  entries_.erase(entries_.begin(), entries_.begin() + num_evicted);
+}
+}  // namespace GLOO
@@ -0,0 +1,67 @@
+#ifndef GLOO_DERIVED_DATA_CACHE_H_
+#define GLOO_DERIVED_DATA_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GLOO {
+// Directory of files derived from source assets. Entries are named by a
+// hash of the sources' contents, so editing a source makes it hash to a new
+// name instead of reusing a stale entry. An index file keeps the entries in
+// least recently used order, and the oldest ones are evicted once their
+// total size exceeds a budget.
+//
+// Any number of instances may share a directory within a process: each
+// operation rereads the index and writes it back under a process-wide
+// lock. Entries written without reaching the index, e.g. by a crashed or
+// concurrent process, are picked up again when a cache is opened, and
+// staged files abandoned by such processes are deleted.
+class DerivedDataCache {
+ public:
+  // Creates directory, and its parents, if they do not exist yet.
+  DerivedDataCache(const std::string& directory, uint64_t max_bytes);
+
+  // Hashes the contents of the files, in order, together with salt, which
+  // should name the kind of derived data and the version of the code that
+  // computes it. Returns an empty key if a file cannot be read.
+  static std::string MakeKey(const std::vector<std::string>& file_paths,
+                             const std::string& salt);
+
+  // Returns the path of the entry for key and marks it as the most recently
+  // used one, or an empty string if there is none.
+  std::string Find(const std::string& key);
+  // A new, unique path to write an entry to before Insert(). It is in the
+  // cache directory, so that inserting it is a rename.
+  std::string GetStagingPath(const std::string& key) const;
+  // Moves the file at staging_path into the cache as the entry for key and
+  // evicts least recently used entries past the budget. Throws if the file
+  // cannot be moved.
+  void Insert(const std::string& key, const std::string& staging_path);
+  // Drops an entry that turned out to be unusable.
+  void Remove(const std::string& key);
+
+ private:
+  struct Entry {
+    std::string key;
+    uint64_t size;
+  };
+
+  std::string GetEntryPath(const std::string& key) const;
+  // The index methods run with the process-wide lock held.
+  void LoadIndex();
+  void SaveIndex() const;
+  // Adds the entries in the directory missing from the index as the least
+  // recently used ones, drops the indexed ones that are gone and deletes
+  // stale staged files.
+  void Rescan();
+  void Evict();
+
+  std::string directory_;
+  uint64_t max_bytes_;
+  // Least recently used first.
+  std::vector<Entry> entries_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,42 @@
+#include "Frustum.hpp"
+
+namespace GLOO {
+Frustum::Frustum(const glm::mat4& view_projection) {
+  // Gribb-Hartmann: each clip plane is the last row of the matrix plus or
+  // minus one of the other rows.
+  const glm::mat4& m = view_projection;
+  glm::vec4 rows[4];
+  for (int row = 0; row < 4; row++) {
+    rows[row] = glm::vec4(m[0][row], m[1][row], m[2][row], m[3][row]);
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    planes_[2 * axis] = rows[3] + rows[axis];
+    planes_[2 * axis + 1] = rows[3] - rows[axis];
+  }
+  for (glm::vec4& plane : planes_) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+  for (const glm::vec4& plane : planes_) {
+    if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+      return false;
+  }
+  return true;
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const {
+  if (box.IsEmpty())
+    return false;
+  for (const glm::vec4& plane : planes_) {
+    // The corner furthest along the plane normal.
+    glm::vec3 corner(plane.x >= 0.0f ? box.GetMax().x : box.GetMin().x,
+                     plane.y >= 0.0f ? box.GetMax().y : box.GetMin().y,
+                     plane.z >= 0.0f ? box.GetMax().z : box.GetMin().z);
+    if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+      return false;
+  }
+  return true;
+}
+}  // namespace GLOO
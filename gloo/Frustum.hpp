@@ -0,0 +1,27 @@
+#ifndef GLOO_FRUSTUM_H_
+#define GLOO_FRUSTUM_H_
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.hpp"
+
+namespace GLOO {
+// The six planes bounding the volume seen through a view-projection matrix.
+// Tests are conservative: objects near a frustum corner may be reported as
+// visible although they are not.
+class Frustum {
+ public:
+  // Extracts the planes of view_projection in the space it maps from, e.g.
+  // world space for projection * view.
+  explicit Frustum(const glm::mat4& view_projection);
+
+  bool Intersects(const BoundingSphere& sphere) const;
+  bool Intersects(const BoundingBox& box) const;
+
+ private:
+  // Planes as (normal, d) with normals pointing inside.
+  glm::vec4 planes_[6];
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,114 @@
+#include "HeadlessContext.hpp"
+
+#include <stdexcept>
+
+#ifdef GLOO_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "gloo/shaders/ShaderProgram.hpp"
+
+namespace GLOO {
+HeadlessContext::HeadlessContext()
+    : window_handle_(nullptr), egl_display_(nullptr), egl_context_(nullptr) {
+#ifdef GLOO_USE_EGL
+  InitializeEGL();
+#else
+  InitializeGLFW();
+#endif
+}
+
+HeadlessContext::~HeadlessContext() {
+#ifdef GLOO_USE_EGL
+  if (egl_display_ != nullptr) {
+    EGLDisplay display = static_cast<EGLDisplay>(egl_display_);
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (egl_context_ != nullptr)
+      eglDestroyContext(display, static_cast<EGLContext>(egl_context_));
+    eglTerminate(display);
+  }
+#endif
+  if (window_handle_ != nullptr) {
+    glfwDestroyWindow(window_handle_);
+    glfwTerminate();
+  }
+}
+
+void HeadlessContext::InitializeEGL() {
+#ifdef GLOO_USE_EGL
+  // Surfaceless platform: render on the GPU without any window system.
+  auto get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+          eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (get_platform_display == nullptr) {
+    throw std::runtime_error("EGL_EXT_platform_base is not supported!");
+  }
+  EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                            EGL_DEFAULT_DISPLAY, nullptr);
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+    throw std::runtime_error("Failed to initialize surfaceless EGL display!");
+  }
+  egl_display_ = display;
+
+  const EGLint config_attribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                   EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                   EGL_NONE};
+  EGLConfig config;
+  EGLint num_configs = 0;
+  if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) ||
+      num_configs == 0) {
+    throw std::runtime_error("No EGL config supports desktop OpenGL!");
+  }
+
+  eglBindAPI(EGL_OPENGL_API);
+  const EGLint context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION, 3,
+                                    EGL_CONTEXT_MINOR_VERSION, 3,
+                                    EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                    EGL_NONE};
+  EGLContext context =
+      eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+  if (context == EGL_NO_CONTEXT) {
+    throw std::runtime_error("Failed to create EGL context!");
+  }
+  egl_context_ = context;
+
+  if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    throw std::runtime_error("Failed to make EGL context current!");
+  }
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    throw std::runtime_error("Failed to initialize GLAD!");
+  }
+  ShaderProgram::LoadBinaryFunctions((GLADloadproc)eglGetProcAddress);
+#endif
+}
+
+void HeadlessContext::InitializeGLFW() {
+  if (!glfwInit()) {
+    throw std::runtime_error("Failed to initialize GLFW!");
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+  // The window is never shown; its size is irrelevant since all rendering
+  // goes to framebuffer objects.
+  window_handle_ = glfwCreateWindow(1, 1, "", nullptr, nullptr);
+  if (window_handle_ == nullptr) {
+    glfwTerminate();
+    throw std::runtime_error("Failed to create hidden GLFW window!");
+  }
+  glfwMakeContextCurrent(window_handle_);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    throw std::runtime_error("Failed to initialize GLAD!");
+  }
+  ShaderProgram::LoadBinaryFunctions((GLADloadproc)glfwGetProcAddress);
+}
+}  // namespace GLOO
@@ -0,0 +1,37 @@
+#ifndef GLOO_HEADLESS_CONTEXT_H_
+#define GLOO_HEADLESS_CONTEXT_H_
+
+#include "external.hpp"
+
+namespace GLOO {
+// An OpenGL 3.3 core context without a visible window, used for offscreen
+// batch rendering. Built with GLOO_USE_EGL, it is a surfaceless EGL context
+// that needs no display server; otherwise it is a hidden GLFW window, which
+// becomes an OSMesa context when GLFW is built with GLFW_USE_OSMESA.
+// Rendering must target a framebuffer object since there is no default one.
+class HeadlessContext {
+ public:
+  HeadlessContext();
+  ~HeadlessContext();
+
+  HeadlessContext(const HeadlessContext&) = delete;
+  HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+  // The hidden window owning the context, or nullptr with EGL.
+  GLFWwindow* GetWindow() const {
+    return window_handle_;
+  }
+
+ private:
+  void InitializeEGL();
+  void InitializeGLFW();
+
+  GLFWwindow* window_handle_;
+  // EGLDisplay and EGLContext, kept opaque so that callers do not need the
+  // EGL headers.
+  void* egl_display_;
+  void* egl_context_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,247 @@
+#include "LightClusterGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "gloo/utils.hpp"
+#include "gloo/SceneNode.hpp"
+#include "gloo/components/CameraComponent.hpp"
+#include "gloo/components/LightComponent.hpp"
+#include "gloo/lights/AmbientLight.hpp"
+#include "gloo/lights/PointLight.hpp"
+#include "gloo/lights/DirectionalLight.hpp"
+
+namespace {
+// Point lights are cut off once their attenuated contribution drops below
+// one 8-bit color step.
+const float kMinLightIntensity = 1.0f / 256.0f;
+const float kUnboundedRange = -1.0f;
+
+const float kPointLightType = 0.0f;
+const float kDirectionalLightType = 1.0f;
+
+float MaxComponent(const glm::vec3& v) {
+  return std::max(v.x, std::max(v.y, v.z));
+}
+
+// Returns the distance at which the attenuation of a point light falls
+// below kMinLightIntensity, or kUnboundedRange if it never does.
+float ComputeLightRange(const GLOO::PointLight& light) {
+  glm::vec3 att = light.GetAttenuation();
+  float peak = std::max(MaxComponent(light.GetDiffuseColor()),
+                        MaxComponent(light.GetSpecularColor()));
+  float target = peak / kMinLightIntensity;
+  if (att.z > 0.0f) {
+    float disc = att.y * att.y - 4.0f * att.z * (att.x - target);
+    return std::max(0.0f, (-att.y + std::sqrt(std::max(disc, 0.0f))) /
+                              (2.0f * att.z));
+  }
+  if (att.y > 0.0f) {
+    return std::max(0.0f, (target - att.x) / att.y);
+  }
+  return kUnboundedRange;
+}
+}  // namespace
+
+namespace GLOO {
+LightClusterGrid::LightClusterGrid(const glm::ivec3& dimensions)
+    : dimensions_(dimensions),
+      tile_size_(1.0f),
+      z_near_(0.1f),
+      z_far_(100.0f),
+      log_depth_scale_(1.0f),
+      ambient_color_(0.0f),
+      num_global_lights_(0),
+      num_lights_(0),
+      light_buf_(make_unique<TextureBuffer>(GL_RGBA32F)),
+      cluster_buf_(make_unique<TextureBuffer>(GL_RG32UI)),
+      index_buf_(make_unique<TextureBuffer>(GL_R32UI)) {
+  if (dimensions_.x <= 0 || dimensions_.y <= 0 || dimensions_.z <= 0) {
+    throw std::runtime_error("Light cluster grid needs positive dimensions!");
+  }
+}
+
+void LightClusterGrid::Build(const std::vector<LightComponent*>& light_ptrs,
+                             const CameraComponent& camera,
+                             const glm::ivec2& viewport_size) {
+  tile_size_ = glm::vec2(std::max(viewport_size.x, 1),
+                         std::max(viewport_size.y, 1)) /
+               glm::vec2(dimensions_.x, dimensions_.y);
+  z_near_ = camera.GetNearPlane();
+  z_far_ = camera.GetFarPlane();
+  log_depth_scale_ = dimensions_.z / std::log(z_far_ / z_near_);
+
+  glm::mat4 view = camera.GetViewMatrix();
+  glm::mat4 projection = camera.GetProjectionMatrix();
+
+  light_data_.clear();
+  local_lights_.clear();
+  ambient_color_ = glm::vec3(0.0f);
+
+  // Global lights go first so that the shader can loop over a prefix.
+  for (LightComponent* component : light_ptrs) {
+    LightBase* light_ptr = component->GetLightPtr();
+    if (light_ptr == nullptr) {
+      throw std::runtime_error("Light component has no light attached!");
+    }
+    if (light_ptr->GetType() == LightType::Ambient) {
+      auto ambient_ptr = static_cast<AmbientLight*>(light_ptr);
+      ambient_color_ += ambient_ptr->GetAmbientColor();
+    } else if (light_ptr->GetType() == LightType::Directional) {
+      auto directional_ptr = static_cast<DirectionalLight*>(light_ptr);
+      AppendLight(glm::vec4(directional_ptr->GetDirection(),
+                            kDirectionalLightType),
+                  directional_ptr->GetDiffuseColor(), kUnboundedRange,
+                  directional_ptr->GetSpecularColor(), glm::vec3(0.0f));
+    } else if (light_ptr->GetType() == LightType::Point) {
+      auto point_ptr = static_cast<PointLight*>(light_ptr);
+      float range = ComputeLightRange(*point_ptr);
+      if (range == kUnboundedRange) {
+        glm::vec3 position =
+            component->GetNodePtr()->GetTransform().GetWorldPosition();
+        AppendLight(glm::vec4(position, kPointLightType),
+                    point_ptr->GetDiffuseColor(), range,
+                    point_ptr->GetSpecularColor(),
+                    point_ptr->GetAttenuation());
+      }
+    } else {
+      throw std::runtime_error(
+          "Encountered light type unrecognized by the light clusters!");
+    }
+  }
+  num_global_lights_ = static_cast<int>(light_data_.size() / kTexelsPerLight);
+
+  // Bounded point lights are binned into the clusters their spheres overlap.
+  for (LightComponent* component : light_ptrs) {
+    LightBase* light_ptr = component->GetLightPtr();
+    if (light_ptr->GetType() != LightType::Point) {
+      continue;
+    }
+    auto point_ptr = static_cast<PointLight*>(light_ptr);
+    float range = ComputeLightRange(*point_ptr);
+    if (range == kUnboundedRange) {
+      continue;
+    }
+    glm::vec3 position =
+        component->GetNodePtr()->GetTransform().GetWorldPosition();
+    LocalLight local;
+    if (!ComputeCellRange(glm::vec3(view * glm::vec4(position, 1.0f)), range,
+                          projection, local)) {
+      continue;
+    }
+    local.index = static_cast<int>(light_data_.size() / kTexelsPerLight);
+    local_lights_.push_back(local);
+    AppendLight(glm::vec4(position, kPointLightType),
+                point_ptr->GetDiffuseColor(), range,
+                point_ptr->GetSpecularColor(), point_ptr->GetAttenuation());
+  }
+  num_lights_ = light_data_.size() / kTexelsPerLight;
+
+  // Two passes over the binned lights: count per cluster, prefix-sum into
+  // offsets, then scatter the light indices.
+  size_t num_clusters =
+      static_cast<size_t>(dimensions_.x) * dimensions_.y * dimensions_.z;
+  cluster_ranges_.assign(num_clusters, glm::uvec2(0u));
+  for (const LocalLight& light : local_lights_) {
+    for (int z = light.min_cell.z; z <= light.max_cell.z; z++)
+      for (int y = light.min_cell.y; y <= light.max_cell.y; y++)
+        for (int x = light.min_cell.x; x <= light.max_cell.x; x++) {
+          size_t cluster = (size_t(z) * dimensions_.y + y) * dimensions_.x + x;
+          cluster_ranges_[cluster].y++;
+        }
+  }
+  unsigned int offset = 0;
+  for (glm::uvec2& range : cluster_ranges_) {
+    range.x = offset;
+    offset += range.y;
+    range.y = 0;
+  }
+  light_indices_.resize(offset);
+  for (const LocalLight& light : local_lights_) {
+    for (int z = light.min_cell.z; z <= light.max_cell.z; z++)
+      for (int y = light.min_cell.y; y <= light.max_cell.y; y++)
+        for (int x = light.min_cell.x; x <= light.max_cell.x; x++) {
+          size_t cluster = (size_t(z) * dimensions_.y + y) * dimensions_.x + x;
+          glm::uvec2& range = cluster_ranges_[cluster];
+          light_indices_[range.x + range.y] =
+              static_cast<unsigned int>(light.index);
+          range.y++;
+        }
+  }
+
+  light_buf_->Update(light_data_);
+  cluster_buf_->Update(cluster_ranges_);
+  index_buf_->Update(light_indices_);
+}
+
+void LightClusterGrid::BindTextures(GLuint first_unit) const {
+  light_buf_->BindTexture(first_unit);
+  cluster_buf_->BindTexture(first_unit + 1);
+  index_buf_->BindTexture(first_unit + 2);
+}
+
+void LightClusterGrid::AppendLight(const glm::vec4& position_type,
+                                   const glm::vec3& diffuse,
+                                   float range,
+                                   const glm::vec3& specular,
+                                   const glm::vec3& attenuation) {
+  light_data_.push_back(position_type);
+  light_data_.emplace_back(diffuse, range);
+  light_data_.emplace_back(specular, 0.0f);
+  light_data_.emplace_back(attenuation, 0.0f);
+}
+
+bool LightClusterGrid::ComputeCellRange(const glm::vec3& view_center,
+                                        float range,
+                                        const glm::mat4& projection,
+                                        LocalLight& light) const {
+  // The camera looks down -z in view space.
+  float depth_min = -view_center.z - range;
+  float depth_max = -view_center.z + range;
+  if (depth_max < z_near_ || depth_min > z_far_) {
+    return false;
+  }
+
+  glm::vec2 ndc_min(-1.0f), ndc_max(1.0f);
+  if (depth_min > z_near_) {
+    // The projection of the sphere is contained in the projection of its
+    // view-space bounding box, which lies entirely in front of the camera.
+    ndc_min = glm::vec2(std::numeric_limits<float>::max());
+    ndc_max = glm::vec2(-std::numeric_limits<float>::max());
+    for (int corner = 0; corner < 8; corner++) {
+      glm::vec3 offset((corner & 1) ? range : -range,
+                       (corner & 2) ? range : -range,
+                       (corner & 4) ? range : -range);
+      glm::vec4 clip = projection * glm::vec4(view_center + offset, 1.0f);
+      glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+      ndc_min = glm::min(ndc_min, ndc);
+      ndc_max = glm::max(ndc_max, ndc);
+    }
+    if (ndc_max.x < -1.0f || ndc_max.y < -1.0f || ndc_min.x > 1.0f ||
+        ndc_min.y > 1.0f) {
+      return false;
+    }
+  }
+
+  // gl_FragCoord has its origin at the bottom-left, like NDC.
+  glm::vec2 grid_size(dimensions_.x, dimensions_.y);
+  glm::vec2 cell_min = (ndc_min * 0.5f + 0.5f) * grid_size;
+  glm::vec2 cell_max = (ndc_max * 0.5f + 0.5f) * grid_size;
+  for (int axis = 0; axis < 2; axis++) {
+    int last = dimensions_[axis] - 1;
+    light.min_cell[axis] = glm::clamp(int(std::floor(cell_min[axis])), 0, last);
+    light.max_cell[axis] = glm::clamp(int(std::floor(cell_max[axis])), 0, last);
+  }
+  light.min_cell.z = SliceOf(std::max(depth_min, z_near_));
+  light.max_cell.z = SliceOf(std::min(depth_max, z_far_));
+  return true;
+}
+
+int LightClusterGrid::SliceOf(float view_depth) const {
+  float scaled_log = std::log(view_depth / z_near_) * log_depth_scale_;
+  int slice = int(std::floor(scaled_log));
+  return glm::clamp(slice, 0, dimensions_.z - 1);
+}
+}  // namespace GLOO
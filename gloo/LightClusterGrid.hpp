@@ -0,0 +1,103 @@
+#ifndef GLOO_LIGHT_CLUSTER_GRID_H_
+#define GLOO_LIGHT_CLUSTER_GRID_H_
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gl_wrapper/TextureBuffer.hpp"
+
+namespace GLOO {
+class CameraComponent;
+class LightComponent;
+
+// Bins the lights of a scene into a screen-space grid of tiles that is further
+// split into exponential depth slices (clusters). All lights are uploaded to
+// buffer textures so that a single shading pass can evaluate every light
+// affecting a fragment.
+class LightClusterGrid {
+ public:
+  LightClusterGrid(const glm::ivec3& dimensions = glm::ivec3(16, 9, 24));
+
+  // Rebuilds light data and per-cluster light lists on the CPU and uploads
+  // them to the GPU.
+  void Build(const std::vector<LightComponent*>& light_ptrs,
+             const CameraComponent& camera,
+             const glm::ivec2& viewport_size);
+
+  // Binds light data, cluster ranges and light indices to three consecutive
+  // texture units starting at first_unit.
+  void BindTextures(GLuint first_unit) const;
+
+  glm::ivec3 GetDimensions() const {
+    return dimensions_;
+  }
+  glm::vec2 GetTileSize() const {
+    return tile_size_;
+  }
+  float GetNearPlane() const {
+    return z_near_;
+  }
+  // Multiplier turning log(view_depth / near) into a slice index.
+  float GetLogDepthScale() const {
+    return log_depth_scale_;
+  }
+  glm::vec3 GetAmbientColor() const {
+    return ambient_color_;
+  }
+  // Global lights (directional and unbounded point lights) occupy the first
+  // slots of the light buffer and are evaluated for every fragment.
+  int GetNumGlobalLights() const {
+    return num_global_lights_;
+  }
+  size_t GetNumLights() const {
+    return num_lights_;
+  }
+  size_t GetNumLightIndices() const {
+    return light_indices_.size();
+  }
+
+  // Number of vec4 texels describing one light in the light buffer.
+  static const int kTexelsPerLight = 4;
+
+ private:
+  struct LocalLight {
+    int index;
+    glm::ivec3 min_cell;
+    glm::ivec3 max_cell;
+  };
+
+  void AppendLight(const glm::vec4& position_type,
+                   const glm::vec3& diffuse,
+                   float range,
+                   const glm::vec3& specular,
+                   const glm::vec3& attenuation);
+  bool ComputeCellRange(const glm::vec3& view_center,
+                        float range,
+                        const glm::mat4& projection,
+                        LocalLight& light) const;
+  int SliceOf(float view_depth) const;
+
+  glm::ivec3 dimensions_;
+  glm::vec2 tile_size_;
+  float z_near_;
+  float z_far_;
+  float log_depth_scale_;
+  glm::vec3 ambient_color_;
+  int num_global_lights_;
+  size_t num_lights_;
+
+  // CPU staging arrays, kept around to avoid per-frame allocations.
+  std::vector<glm::vec4> light_data_;
+  std::vector<LocalLight> local_lights_;
+  std::vector<glm::uvec2> cluster_ranges_;
+  std::vector<unsigned int> light_indices_;
+
+  std::unique_ptr<TextureBuffer> light_buf_;
+  std::unique_ptr<TextureBuffer> cluster_buf_;
+  std::unique_ptr<TextureBuffer> index_buf_;
+};
+}  // namespace GLOO
+
+#endif
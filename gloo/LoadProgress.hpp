@@ -0,0 +1,33 @@
+#ifndef GLOO_LOAD_PROGRESS_H_
+#define GLOO_LOAD_PROGRESS_H_
+
+#include <mutex>
+#include <string>
+
+namespace GLOO {
+// Stage and completed fraction of a background load. The loading thread
+// reports; the render thread polls, e.g. to draw a progress bar.
+class LoadProgress {
+ public:
+  LoadProgress() : fraction_(0.0f) {
+  }
+
+  void Report(const std::string& stage, float fraction) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage_ = stage;
+    fraction_ = fraction;
+  }
+  void Get(std::string& stage, float& fraction) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage = stage_;
+    fraction = fraction_;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::string stage_;
+  float fraction_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef GLOO_MAPPED_FILE_H_
+#define GLOO_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace GLOO {
+// Read-only memory mapping of a whole file, so that large assets can be
+// parsed in place without copying them through stream buffers.
+class MappedFile {
+ public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Returns false if the file cannot be opened or mapped. An empty file
+  // opens successfully with a null data pointer.
+  bool Open(const std::string& file_path);
+  void Close();
+
+  const char* GetData() const {
+    return data_;
+  }
+  size_t GetSize() const {
+    return size_;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+#ifdef _WIN32
+  void* file_handle_;
+  void* mapping_handle_;
+#endif
+};
+}  // namespace GLOO
+
+#endif
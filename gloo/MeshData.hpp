@@ -14,8 +14,13 @@ struct MeshGroup {
 };
 
 struct MeshData {
-  std::unique_ptr<VertexObject> vertex_obj;
+  // Shared so that it can be handed to RenderingComponents directly.
+  std::shared_ptr<VertexObject> vertex_obj;
   std::vector<MeshGroup> groups;
+  // Where each vertex of the source file ended up after optimization:
+  // vertex i of the file is vertex vertex_remap[i] of vertex_obj. Empty
+  // when the order is unchanged.
+  std::vector<unsigned int> vertex_remap;
 };
 }  // namespace GLOO
 
@@ -1,11 +1,110 @@
 #include "MeshLoader.hpp"
 
 #include <iostream>
+#include <stdexcept>
 
 #include "gloo/utils.hpp"
+#include "gloo/AssetRegistry.hpp"
+#include "gloo/DerivedDataCache.hpp"
+#include "gloo/MeshOptimizer.hpp"
+#include "gloo/parsers/CharacterParser.hpp"
+#include "gloo/parsers/GltfParser.hpp"
+
+namespace {
+// Characters parsed from text files are cached as bundles under the
+// project root, in at most this many bytes.
+const char kCacheDir[] = "cache/";
+const uint64_t kCacheBytes = 256ull << 20;
+
+std::string GetCharacterKey(const std::string& prefix) {
+  return GLOO::GetCanonicalPath(GLOO::GetAssetDir() + prefix);
+}
+
+// Returns false if there is no such file.
+bool LoadGlb(const std::string& file_path,
+             GLOO::LoadedCharacter& character,
+             GLOO::LoadProgress& progress) {
+  // Binary already, so it is not worth caching.
+  progress.Report("Importing " + file_path, 0.1f);
+  auto parsed = GLOO::make_unique<GLOO::CharacterData>();
+  if (!GLOO::GltfParser::Parse(file_path, *parsed))
+    return false;
+  character.parsed = std::move(parsed);
+  character.view = character.parsed->GetView();
+  return true;
+}
+
+// Loads the text files through the derived data cache, parsing them only
+// if no bundle was cached for their current contents.
+void LoadCachedCharacter(const std::string& prefix_full,
+                         GLOO::LoadedCharacter& character,
+                         GLOO::LoadProgress& progress) {
+  using GLOO::DerivedDataCache;
+  progress.Report("Hashing sources", 0.05f);
+  DerivedDataCache cache(GLOO::GetProjectRootDir() + kCacheDir, kCacheBytes);
+  std::vector<std::string> sources = {
+      prefix_full + ".skel", prefix_full + ".obj", prefix_full + ".attach"};
+  std::string salt =
+      "character/" + std::to_string(GLOO::CharacterBundle::kVersion) + "/" +
+      std::to_string(GLOO::CharacterParser::kVersion);
+  std::string key = DerivedDataCache::MakeKey(sources, salt);
+  if (!key.empty()) {
+    std::string cached_path = cache.Find(key);
+    try {
+      if (!cached_path.empty() &&
+          character.bundle.Open(cached_path, character.view)) {
+        return;
+      }
+    } catch (const std::runtime_error& e) {
+      std::cerr << "WARNING: " << e.what() << std::endl;
+      character.bundle.Close();
+      cache.Remove(key);
+    }
+  }
+
+  progress.Report("Parsing", 0.1f);
+  character.parsed = GLOO::make_unique<GLOO::CharacterData>();
+  if (!GLOO::CharacterParser::Parse(prefix_full, *character.parsed)) {
+    throw std::runtime_error("Unable to load character " + prefix_full +
+                             "!");
+  }
+  character.view = character.parsed->GetView();
+  // A source edited while it was being parsed hashes differently now, and
+  // what was parsed must not be cached under either key.
+  if (key.empty() || DerivedDataCache::MakeKey(sources, salt) != key)
+    return;
+  progress.Report("Writing cache", 0.7f);
+  try {
+    std::string staging_path = cache.GetStagingPath(key);
+    GLOO::CharacterBundle::Write(staging_path, character.view);
+    cache.Insert(key, staging_path);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "WARNING: Unable to cache character: " << e.what()
+              << std::endl;
+  }
+}
+
+std::shared_ptr<GLOO::LoadedCharacter> LoadCharacter(
+    const std::string& prefix_full,
+    GLOO::LoadProgress& progress) {
+  auto character = std::make_shared<GLOO::LoadedCharacter>();
+  // Bundles are written by CharacterConverter and need no parsing.
+  progress.Report("Opening bundle", 0.0f);
+  if (!character->bundle.Open(prefix_full + ".chr", character->view) &&
+      !LoadGlb(prefix_full + ".glb", *character, progress)) {
+    LoadCachedCharacter(prefix_full, *character, progress);
+  }
+
+  progress.Report("Preparing mesh", 0.8f);
+  const GLOO::CharacterView& view = character->view;
+  character->mesh_indices.assign(view.indices.begin(), view.indices.end());
+  return character;
+}
+}  // namespace
 
 namespace GLOO {
-MeshData MeshLoader::Import(const std::string& filename) {
+MeshData MeshLoader::Import(const std::string& filename,
+                            const Options& options) {
   std::string file_path = GetAssetDir() + filename;
   bool success;
   auto parsed_data = ObjParser::Parse(file_path, success);
@@ -15,7 +114,11 @@ MeshData MeshLoader::Import(const std::string& filename) {
   }
 
   MeshData mesh_data;
-  mesh_data.vertex_obj = make_unique<VertexObject>();
+  if (options.optimize && parsed_data.positions && parsed_data.indices) {
+    mesh_data.vertex_remap = Optimize(parsed_data);
+  }
+
+  mesh_data.vertex_obj = std::make_shared<VertexObject>(options.layout);
   if (parsed_data.positions) {
     mesh_data.vertex_obj->UpdatePositions(std::move(parsed_data.positions));
   }
@@ -33,4 +136,76 @@ MeshData MeshLoader::Import(const std::string& filename) {
 
   return mesh_data;
 }
+
+std::shared_ptr<const LoadedCharacter> MeshLoader::ImportCharacterShared(
+    const std::string& prefix) {
+  static AssetRegistry<const LoadedCharacter> characters;
+  std::string key = GetCharacterKey(prefix);
+  // Held until the load is done, so that requesters joining it find the
+  // same progress.
+  std::shared_ptr<LoadProgress> progress = GetCharacterProgress(prefix);
+  return characters.GetOrCreate(
+      key, [&]() -> std::shared_ptr<const LoadedCharacter> {
+        std::shared_ptr<LoadedCharacter> character =
+            LoadCharacter(GetAssetDir() + prefix, *progress);
+        character->key = key;
+        return character;
+      });
+}
+
+std::shared_ptr<LoadProgress> MeshLoader::GetCharacterProgress(
+    const std::string& prefix) {
+  static AssetRegistry<LoadProgress> progresses;
+  return progresses.GetOrCreate(GetCharacterKey(prefix), []() {
+    return std::make_shared<LoadProgress>();
+  });
+}
+
+std::shared_ptr<VertexObject> MeshLoader::ImportCharacterMesh(
+    const LoadedCharacter& character) {
+  static AssetRegistry<VertexObject> meshes;
+  const CharacterView& view = character.view;
+  return meshes.GetOrCreate(character.key, [&view]() {
+    auto mesh = std::make_shared<VertexObject>(VertexLayout::Interleaved);
+    mesh->SetPositionsAndNormals(
+        make_unique<PositionArray>(view.positions.begin(),
+                                   view.positions.end()),
+        make_unique<NormalArray>(view.normals.begin(), view.normals.end()));
+    mesh->UpdateIndices(
+        make_unique<IndexArray>(view.indices.begin(), view.indices.end()));
+    return mesh;
+  });
+}
+
+std::vector<unsigned int> MeshLoader::Optimize(
+    ObjParser::ParsedData& parsed_data) {
+  IndexArray& indices = *parsed_data.indices;
+  size_t num_vertices = parsed_data.positions->size();
+
+  // Triangles are only reordered within their group, so that group ranges
+  // stay valid.
+  if (parsed_data.groups.empty()) {
+    MeshOptimizer::OptimizeVertexCache(indices, 0, indices.size(),
+                                       num_vertices);
+  } else {
+    for (const MeshGroup& group : parsed_data.groups) {
+      MeshOptimizer::OptimizeVertexCache(indices, group.start_face_index,
+                                         group.num_indices, num_vertices);
+    }
+  }
+
+  std::vector<unsigned int> remap =
+      MeshOptimizer::OptimizeVertexFetch(indices, num_vertices);
+  MeshOptimizer::RemapVertices(*parsed_data.positions, remap);
+  // OBJ normals and texture coordinates are only used per vertex when there
+  // is one for each position.
+  if (parsed_data.normals && parsed_data.normals->size() == num_vertices) {
+    MeshOptimizer::RemapVertices(*parsed_data.normals, remap);
+  }
+  if (parsed_data.tex_coords &&
+      parsed_data.tex_coords->size() == num_vertices) {
+    MeshOptimizer::RemapVertices(*parsed_data.tex_coords, remap);
+  }
+  return remap;
+}
 }  // namespace GLOO
@@ -1,13 +1,68 @@
 #ifndef GLOO_MESH_LOADER_H_
 #define GLOO_MESH_LOADER_H_
 
+#include <memory>
+#include <string>
+
 #include "parsers/ObjParser.hpp"
+#include "CharacterBundle.hpp"
+#include "LoadProgress.hpp"
 #include "MeshData.hpp"
 
 namespace GLOO {
+// A character loaded off the render thread, shared by everyone showing the
+// same files and immutable once loaded. The arrays of view live in the
+// mapped bundle, or in parsed without a bundle.
+struct LoadedCharacter {
+  // Canonical path prefix of the files.
+  std::string key;
+  CharacterView view;
+  CharacterBundle bundle;
+  std::unique_ptr<CharacterData> parsed;
+  // The indices of view, for BVHs of the skinned meshes.
+  IndexArray mesh_indices;
+};
+
 class MeshLoader {
  public:
-  static MeshData Import(const std::string& filename);
+  struct Options {
+    Options() : layout(VertexLayout::Interleaved), optimize(true) {
+    }
+
+    // Interleaved attributes keep each vertex in one cache-friendly fetch.
+    VertexLayout layout;
+    // Reorders triangles and vertices for the GPU vertex caches; see
+    // MeshData::vertex_remap to map per-vertex data of the file.
+    bool optimize;
+  };
+
+  static MeshData Import(const std::string& filename,
+                         const Options& options = Options());
+  // Loads the character at prefix, relative to the asset directory, from
+  // PREFIX.chr if it exists, else PREFIX.glb, else the .skel, .obj and
+  // .attach files through the derived data cache. Requests for the same
+  // files share one character for as long as any of them holds it, and
+  // requests during a load wait for it. Throws if the files cannot be
+  // loaded. Runs on any thread.
+  static std::shared_ptr<const LoadedCharacter> ImportCharacterShared(
+      const std::string& prefix);
+  // The progress ImportCharacterShared reports for prefix. It is shared
+  // like the character, so a requester joining a load in flight sees the
+  // progress of that load.
+  static std::shared_ptr<LoadProgress> GetCharacterProgress(
+      const std::string& prefix);
+  // The bind pose mesh of character, created once and shared like the
+  // character. Shared meshes must not be modified; instances that draw
+  // changed vertices should create their own VertexObject and share the
+  // indices (VertexObject::ShareIndices). Its vertices are uploaded by
+  // VertexObject::UploadVertices, which every user must call until it
+  // returns true before drawing it. Render thread only.
+  static std::shared_ptr<VertexObject> ImportCharacterMesh(
+      const LoadedCharacter& character);
+
+  // Applies the reordering of Import to parsed data in place, without
+  // creating GL objects. Returns the vertex remap table.
+  static std::vector<unsigned int> Optimize(ObjParser::ParsedData& parsed_data);
 };
 }  // namespace GLOO
 
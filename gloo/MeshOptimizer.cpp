@@ -0,0 +1,131 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace GLOO {
+void MeshOptimizer::OptimizeVertexCache(IndexArray& indices,
+                                        size_t start,
+                                        size_t count,
+                                        size_t num_vertices,
+                                        size_t cache_size) {
+  if (count % 3 != 0 || start + count > indices.size()) {
+    throw std::runtime_error("Invalid triangle range to optimize!");
+  }
+  size_t num_triangles = count / 3;
+  if (num_triangles == 0)
+    return;
+  const unsigned int* triangles = indices.data() + start;
+
+  // Triangles adjacent to each vertex, in compressed rows.
+  std::vector<unsigned int> live_counts(num_vertices, 0);
+  for (size_t i = 0; i < count; i++) {
+    if (triangles[i] >= num_vertices) {
+      throw std::runtime_error("Index out of range in mesh optimization!");
+    }
+    live_counts[triangles[i]]++;
+  }
+  std::vector<size_t> adjacency_offsets(num_vertices + 1, 0);
+  for (size_t v = 0; v < num_vertices; v++) {
+    adjacency_offsets[v + 1] = adjacency_offsets[v] + live_counts[v];
+  }
+  std::vector<unsigned int> adjacency(count);
+  std::vector<size_t> fill(adjacency_offsets.begin(),
+                           adjacency_offsets.end() - 1);
+  for (size_t t = 0; t < num_triangles; t++) {
+    for (size_t c = 0; c < 3; c++) {
+      adjacency[fill[triangles[3 * t + c]]++] = static_cast<unsigned int>(t);
+    }
+  }
+
+  // A vertex is in the cache if it was used less than cache_size
+  // timestamps ago.
+  std::vector<size_t> cache_times(num_vertices, 0);
+  size_t time = cache_size + 1;
+  std::vector<bool> emitted(num_triangles, false);
+  std::vector<unsigned int> dead_end_stack;
+  std::vector<unsigned int> candidates;
+  IndexArray output;
+  output.reserve(count);
+
+  const size_t kNone = std::numeric_limits<size_t>::max();
+  size_t cursor = 0;
+  size_t fanning_vertex = triangles[0];
+  while (fanning_vertex != kNone) {
+    candidates.clear();
+    for (size_t a = adjacency_offsets[fanning_vertex];
+         a < adjacency_offsets[fanning_vertex + 1]; a++) {
+      unsigned int t = adjacency[a];
+      if (emitted[t])
+        continue;
+      for (size_t c = 0; c < 3; c++) {
+        unsigned int v = triangles[3 * t + c];
+        output.push_back(v);
+        dead_end_stack.push_back(v);
+        candidates.push_back(v);
+        live_counts[v]--;
+        if (time - cache_times[v] > cache_size) {
+          cache_times[v] = time++;
+        }
+      }
+      emitted[t] = true;
+    }
+
+    // Prefer the candidate that will still be cached after emitting all of
+    // its remaining triangles, and among those the one used longest ago.
+    fanning_vertex = kNone;
+    long best_priority = -1;
+    for (unsigned int v : candidates) {
+      if (live_counts[v] == 0)
+        continue;
+      long priority = 0;
+      if (time - cache_times[v] + 2 * live_counts[v] <= cache_size) {
+        priority = static_cast<long>(time - cache_times[v]);
+      }
+      if (priority > best_priority) {
+        best_priority = priority;
+        fanning_vertex = v;
+      }
+    }
+
+    // Dead end: back up to a recently used vertex, then scan the rest.
+    while (fanning_vertex == kNone && !dead_end_stack.empty()) {
+      unsigned int v = dead_end_stack.back();
+      dead_end_stack.pop_back();
+      if (live_counts[v] > 0)
+        fanning_vertex = v;
+    }
+    while (fanning_vertex == kNone && cursor < num_vertices) {
+      if (live_counts[cursor] > 0)
+        fanning_vertex = cursor;
+      cursor++;
+    }
+  }
+
+  std::copy(output.begin(), output.end(), indices.begin() + start);
+}
+
+std::vector<unsigned int> MeshOptimizer::OptimizeVertexFetch(
+    IndexArray& indices,
+    size_t num_vertices) {
+  const unsigned int kUnassigned = std::numeric_limits<unsigned int>::max();
+  std::vector<unsigned int> remap(num_vertices, kUnassigned);
+  unsigned int next_vertex = 0;
+  for (unsigned int& index : indices) {
+    if (index >= num_vertices) {
+      throw std::runtime_error("Index out of range in mesh optimization!");
+    }
+    if (remap[index] == kUnassigned) {
+      remap[index] = next_vertex++;
+    }
+    index = remap[index];
+  }
+  for (unsigned int& new_index : remap) {
+    if (new_index == kUnassigned) {
+      new_index = next_vertex++;
+    }
+  }
+  return remap;
+}
+}  // namespace GLOO
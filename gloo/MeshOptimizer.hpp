@@ -0,0 +1,47 @@
+#ifndef GLOO_MESH_OPTIMIZER_H_
+#define GLOO_MESH_OPTIMIZER_H_
+
+#include <stdexcept>
+#include <vector>
+
+#include "alias_types.hpp"
+
+namespace GLOO {
+// Reorders indexed triangle meshes for the GPU without changing what they
+// look like.
+class MeshOptimizer {
+ public:
+  // Reorders the triangles in indices[start, start + count) for the
+  // post-transform vertex cache with Tipsify (Sander et al. 2007), which
+  // fans around recently used vertices so that they are still cached when
+  // a neighboring triangle needs them again.
+  static void OptimizeVertexCache(IndexArray& indices,
+                                  size_t start,
+                                  size_t count,
+                                  size_t num_vertices,
+                                  size_t cache_size = 16);
+
+  // Renumbers vertices in the order the indices first reference them, so
+  // that vertex fetches walk memory mostly sequentially. Rewrites indices
+  // and returns the remap table: vertex i moves to position remap[i].
+  // Unreferenced vertices are moved to the end.
+  static std::vector<unsigned int> OptimizeVertexFetch(IndexArray& indices,
+                                                       size_t num_vertices);
+
+  // Applies a remap table from OptimizeVertexFetch to a per-vertex array.
+  template <class T>
+  static void RemapVertices(std::vector<T>& vertices,
+                            const std::vector<unsigned int>& remap) {
+    if (vertices.size() != remap.size()) {
+      throw std::runtime_error("Vertex array does not match remap table!");
+    }
+    std::vector<T> remapped(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+      remapped[remap[i]] = vertices[i];
+    }
+    vertices.swap(remapped);
+  }
+};
+}  // namespace GLOO
+
+#endif
@@ -1,6 +1,8 @@
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <tuple>
 #include <glad/glad.h>
 #include <glm/gtx/string_cast.hpp>
 
@@ -11,12 +13,20 @@
 #include "shaders/ShaderProgram.hpp"
 #include "components/ShadingComponent.hpp"
 #include "components/CameraComponent.hpp"
+#include "components/MaterialComponent.hpp"
 #include "debug/PrimitiveFactory.hpp"
+#include "debug/Profiler.hpp"
+#include "Frustum.hpp"
 
 
 namespace GLOO {
-Renderer::Renderer(Application& application) : application_(application) {
-  UNUSED(application_);
+Renderer::Renderer(Application& application)
+    : application_(application),
+      lighting_mode_(LightingMode::MultiPass),
+      light_clusters_(make_unique<LightClusterGrid>()),
+      frustum_culling_(true),
+      num_culled_(0),
+      num_visible_(0) {
 }
 
 void Renderer::SetRenderingOptions() const {
@@ -67,7 +77,11 @@ void Renderer::RenderScene(const Scene& scene) const {
   GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
   const SceneNode& root = scene.GetRootNode();
-  auto rendering_info = RetrieveRenderingInfo(scene);
+  RenderingInfo rendering_info;
+  {
+    ScopedTimer timer("RetrieveRenderingInfo");
+    rendering_info = RetrieveRenderingInfo(scene);
+  }
 
   auto light_ptrs = root.GetComponentPtrsInChildren<LightComponent>();
   if (light_ptrs.size() == 0) {
@@ -77,10 +91,18 @@ void Renderer::RenderScene(const Scene& scene) const {
   }
 
   CameraComponent* camera = scene.GetActiveCameraPtr();
+  Frustum frustum(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+  DrawList draw_list =
+      BuildDrawList(rendering_info, frustum_culling_ ? &frustum : nullptr);
 
   // First pass: depth buffer.
-  // Remaining passes: one per light source.
-  size_t total_passes = 1 + light_ptrs.size();
+  // Remaining passes: one per light source, or a single pass over all lights
+  // binned into clusters.
+  bool clustered = lighting_mode_ == LightingMode::Clustered;
+  if (clustered) {
+    light_clusters_->Build(light_ptrs, *camera, application_.GetWindowSize());
+  }
+  size_t total_passes = clustered ? 2 : 1 + light_ptrs.size();
 
   for (size_t pass = 0; pass < total_passes; pass++) {
 
@@ -88,42 +110,155 @@ void Renderer::RenderScene(const Scene& scene) const {
     bool color_mask = (pass == 0) ? GL_FALSE : GL_TRUE;
     GL_CHECK(glColorMask(color_mask, color_mask, color_mask, color_mask));
 
-    for (const auto& pr : rendering_info) {
+    const LightComponent* light = nullptr;
+    if (pass > 0 && !clustered) {
+      light = light_ptrs.at(total_passes - pass - 1);
+    }
+    std::string pass_name = "Depth pre-pass";
+    if (pass > 0) {
+      pass_name = clustered ? "Clustered light pass"
+                            : "Light pass " + std::to_string(pass);
+    }
+    GpuTimer& timer = GetPassTimer(pass_name);
+    timer.Begin();
+    SubmitDrawList(draw_list, pass == 0 ? PassType::Depth : PassType::Shading,
+                   *camera, light);
+    timer.End();
+  }
 
-      auto robj_ptr = pr.first;
+  // Re-enable writing to depth buffer.
+  GL_CHECK(glDepthMask(GL_TRUE));
 
-      SceneNode& node = *robj_ptr->GetNodePtr();
+}
 
-      auto shading_ptr = node.GetComponentPtr<ShadingComponent>();
+GpuTimer& Renderer::GetPassTimer(const std::string& name) const {
+  std::unique_ptr<GpuTimer>& timer = pass_timers_[name];
+  if (timer == nullptr) {
+    timer = make_unique<GpuTimer>(name);
+  }
+  return *timer;
+}
 
-      if (shading_ptr == nullptr) {
-        std::cerr << "Some mesh is not attached with a shader during rendering!"
-                  << std::endl;
+Renderer::DrawList Renderer::BuildDrawList(
+    const RenderingInfo& rendering_info,
+    const Frustum* frustum) const {
+  DrawList draw_list;
+  draw_list.reserve(rendering_info.size());
+  num_culled_ = 0;
+  for (const auto& pr : rendering_info) {
+    RenderingComponent* robj_ptr = pr.first;
+    SceneNode& node = *robj_ptr->GetNodePtr();
+    // Components may be waiting for their mesh to load, e.g. while a
+    // character loads in the background; they have nothing to draw yet.
+    VertexObject* vertex_obj_ptr = robj_ptr->GetVertexObjectPtr();
+    if (vertex_obj_ptr == nullptr)
+      continue;
+
+    if (frustum != nullptr) {
+      // The sphere test is cheaper and rejects most objects; the box test
+      // is tighter for elongated ones.
+      const VertexObject& vertex_obj = *vertex_obj_ptr;
+      const glm::mat4& model_matrix = pr.second;
+      if (!frustum->Intersects(
+              vertex_obj.GetBoundingSphere().Transform(model_matrix)) ||
+          !frustum->Intersects(
+              vertex_obj.GetBoundingBox().Transform(model_matrix))) {
+        num_culled_++;
         continue;
       }
+    }
 
-      ShaderProgram* shader = shading_ptr->GetShaderPtr();
-
-      BindGuard shader_bg(shader);
+    auto shading_ptr = node.GetComponentPtr<ShadingComponent>();
+    if (shading_ptr == nullptr) {
+      std::cerr << "Some mesh is not attached with a shader during rendering!"
+                << std::endl;
+      continue;
+    }
 
-      // Set various uniform variables in the shaders.
-      shader->SetTargetNode(node, pr.second);
-      shader->SetCamera(*camera);
+    auto material_ptr = node.GetComponentPtr<MaterialComponent>();
+    DrawItem item;
+    item.shader = shading_ptr->GetShaderPtr();
+    item.vertex_array = &vertex_obj_ptr->GetVertexArray();
+    item.material =
+        material_ptr == nullptr ? nullptr : &material_ptr->GetMaterial();
+    item.rendering = robj_ptr;
+    item.model_matrix = pr.second;
+    draw_list.push_back(item);
+  }
+  num_visible_ = draw_list.size();
+
+  std::stable_sort(draw_list.begin(), draw_list.end(),
+                   [](const DrawItem& a, const DrawItem& b) {
+                     return std::tie(a.shader, a.vertex_array, a.material) <
+                            std::tie(b.shader, b.vertex_array, b.material);
+                   });
+  return draw_list;
+}
 
-      if (pass > 0) {
-        LightComponent& light = *light_ptrs.at(total_passes - pass - 1);
-        shader->SetLightSource(light);
+void Renderer::SubmitDrawList(const DrawList& draw_list,
+                              PassType pass_type,
+                              const CameraComponent& camera,
+                              const LightComponent* light) const {
+  const ShaderProgram* bound_shader = nullptr;
+  const VertexArray* bound_vertex_array = nullptr;
+  const Material* bound_material = nullptr;
+  bool material_set = false;
+  bool polygon_mode_set = false;
+  PolygonMode polygon_mode = PolygonMode::Fill;
+
+  for (const DrawItem& item : draw_list) {
+    ShaderProgram* shader = item.shader;
+    if (shader != bound_shader) {
+      shader->Bind();
+      // Set per-pass uniform variables once per shader.
+      shader->SetCamera(camera);
+      // The depth pre-pass writes no color, so it needs no lights.
+      if (pass_type == PassType::Shading) {
+        if (light != nullptr) {
+          shader->SetLightSource(*light);
+        } else if (lighting_mode_ == LightingMode::Clustered) {
+          shader->SetLightClusters(*light_clusters_);
+        }
       }
+      bound_shader = shader;
+      bound_vertex_array = nullptr;
+      material_set = false;
+    }
 
-      robj_ptr->Render();
+    if (item.vertex_array != bound_vertex_array) {
+      // Linking is cached per shader, so this only touches GL the first time
+      // a vertex array meets a shader. It must precede binding, since
+      // linking binds and unbinds the vertex array itself.
+      shader->LinkVertexArray(*item.vertex_array);
+      item.vertex_array->Bind();
+      bound_vertex_array = item.vertex_array;
+
+      PolygonMode mode = item.vertex_array->GetPolygonMode();
+      if (!polygon_mode_set || mode != polygon_mode) {
+        GL_CHECK(glPolygonMode(GL_FRONT_AND_BACK, mode == PolygonMode::Wireframe
+                                                      ? GL_LINE
+                                                      : GL_FILL));
+        polygon_mode = mode;
+        polygon_mode_set = true;
+      }
+    }
 
+    if (!material_set || item.material != bound_material) {
+      shader->SetMaterial(item.material);
+      bound_material = item.material;
+      material_set = true;
     }
 
+    shader->SetModelMatrix(item.model_matrix);
+    item.rendering->Draw();
   }
 
-  // Re-enable writing to depth buffer.
-  GL_CHECK(glDepthMask(GL_TRUE));
-
+  if (bound_vertex_array != nullptr) {
+    bound_vertex_array->Unbind();
+  }
+  if (bound_shader != nullptr) {
+    bound_shader->Unbind();
+  }
 }
 
 
@@ -1,24 +1,93 @@
 #ifndef GLOO_RENDERER_H_
 #define GLOO_RENDERER_H_
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 #include "components/LightComponent.hpp"
 #include "components/RenderingComponent.hpp"
+#include "LightClusterGrid.hpp"
+#include "debug/GpuTimer.hpp"
 
 namespace GLOO {
 class Scene;
 class Application;
+class ShaderProgram;
+class Material;
+class CameraComponent;
+class Frustum;
+
+enum class LightingMode {
+  // One additive pass per light source.
+  MultiPass,
+  // All lights evaluated in a single pass from CPU-binned light clusters.
+  Clustered
+};
+
 class Renderer {
  public:
   Renderer(Application& application);
   void Render(const Scene& scene) const;
+  void SetLightingMode(LightingMode mode) {
+    lighting_mode_ = mode;
+  }
+  LightingMode GetLightingMode() const {
+    return lighting_mode_;
+  }
+  // Skips objects whose bounds lie outside the camera frustum.
+  void SetFrustumCulling(bool enabled) {
+    frustum_culling_ = enabled;
+  }
+  bool GetFrustumCulling() const {
+    return frustum_culling_;
+  }
+  // Statistics of the last rendered frame.
+  size_t GetNumCulled() const {
+    return num_culled_;
+  }
+  size_t GetNumVisible() const {
+    return num_visible_;
+  }
 
  private:
   using RenderingInfo = std::vector<std::pair<RenderingComponent*, glm::mat4>>;
+  // One draw call with the state it needs, sorted so that shader, vertex
+  // array and material changes happen once per group.
+  struct DrawItem {
+    ShaderProgram* shader;
+    VertexArray* vertex_array;
+    const Material* material;
+    const RenderingComponent* rendering;
+    glm::mat4 model_matrix;
+  };
+  using DrawList = std::vector<DrawItem>;
+  // What a pass over the draw list writes, and so which per-pass uniforms
+  // its shaders need.
+  enum class PassType { Depth, Shading };
   void RenderScene(const Scene& scene) const;
+  // Culls against frustum unless it is nullptr.
+  DrawList BuildDrawList(const RenderingInfo& rendering_info,
+                         const Frustum* frustum) const;
+  // light is the light source of a multi-pass shading pass, and nullptr
+  // otherwise.
+  void SubmitDrawList(const DrawList& draw_list,
+                      PassType pass_type,
+                      const CameraComponent& camera,
+                      const LightComponent* light) const;
   void SetRenderingOptions() const;
   void RecursiveRetrieve(const SceneNode& node, RenderingInfo& info, const glm::mat4& model_matrix) const;
   RenderingInfo RetrieveRenderingInfo(const Scene& scene) const;
+  // GPU timer of a render pass, created on first use.
+  GpuTimer& GetPassTimer(const std::string& name) const;
   Application& application_;
+  LightingMode lighting_mode_;
+  std::unique_ptr<LightClusterGrid> light_clusters_;
+  bool frustum_culling_;
+  mutable size_t num_culled_;
+  mutable size_t num_visible_;
+  mutable std::unordered_map<std::string, std::unique_ptr<GpuTimer>>
+      pass_timers_;
 };
 }  // namespace GLOO
 
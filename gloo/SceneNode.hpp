@@ -32,7 +32,7 @@ class SceneNode {
   SceneNode* GetParentPtr() const {
     return parent_;
   }
-  std::vector<SceneNode*> GetGizmoPtrs() {
+  const std::vector<SceneNode*>& GetGizmoPtrs() const {
       return gizmo_spheres_;
   }
   void AddToGizmoPtrs(SceneNode* ptr) {
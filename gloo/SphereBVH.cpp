@@ -0,0 +1,151 @@
+#include "SphereBVH.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+// Slab test; returns the entry distance, or a negative value on a miss.
+float IntersectBox(const glm::vec3& bounds_min,
+                   const glm::vec3& bounds_max,
+                   const glm::vec3& origin,
+                   const glm::vec3& inv_direction,
+                   float max_t) {
+  glm::vec3 t0 = (bounds_min - origin) * inv_direction;
+  glm::vec3 t1 = (bounds_max - origin) * inv_direction;
+  glm::vec3 t_near = glm::min(t0, t1);
+  glm::vec3 t_far = glm::max(t0, t1);
+  float t_entry =
+      std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+  float t_exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_t));
+  return t_entry <= t_exit ? t_entry : -1.0f;
+}
+}  // namespace
+
+namespace GLOO {
+const uint32_t SphereBVH::kBlockSize;
+
+void SphereBVH::Build(const std::vector<BoundingSphere>& spheres) {
+  nodes_.clear();
+  blocks_.clear();
+  order_.resize(spheres.size());
+  for (size_t i = 0; i < spheres.size(); i++) {
+    order_[i] = static_cast<uint32_t>(i);
+  }
+  if (!spheres.empty())
+    BuildRecursive(spheres, 0, spheres.size());
+}
+
+uint32_t SphereBVH::BuildRecursive(const std::vector<BoundingSphere>& spheres,
+                                   size_t begin,
+                                   size_t end) {
+  uint32_t index = static_cast<uint32_t>(nodes_.size());
+  nodes_.push_back(Node());
+  Node& node = nodes_.back();
+  node.bounds_min = glm::vec3(std::numeric_limits<float>::max());
+  node.bounds_max = glm::vec3(-std::numeric_limits<float>::max());
+  for (size_t i = begin; i < end; i++) {
+    const BoundingSphere& sphere = spheres[order_[i]];
+    node.bounds_min = glm::min(node.bounds_min, sphere.center - sphere.radius);
+    node.bounds_max = glm::max(node.bounds_max, sphere.center + sphere.radius);
+  }
+
+  size_t count = end - begin;
+  if (count <= kBlockSize) {
+    SphereBlock block;
+    for (uint32_t k = 0; k < kBlockSize; k++) {
+      // Unused lanes repeat the last sphere and are never read.
+      uint32_t sphere_index = order_[begin + std::min<size_t>(k, count - 1)];
+      const BoundingSphere& sphere = spheres[sphere_index];
+      for (int c = 0; c < 3; c++) {
+        block.center[c][k] = sphere.center[c];
+      }
+      block.radius_sq[k] = sphere.radius * sphere.radius;
+      block.spheres[k] = sphere_index;
+    }
+    node.second_child_or_block = static_cast<uint32_t>(blocks_.size());
+    node.num_spheres = static_cast<uint32_t>(count);
+    blocks_.push_back(block);
+    return index;
+  }
+
+  glm::vec3 extent = node.bounds_max - node.bounds_min;
+  int axis = 0;
+  if (extent.y > extent[axis])
+    axis = 1;
+  if (extent.z > extent[axis])
+    axis = 2;
+  size_t mid = begin + count / 2;
+  std::nth_element(order_.begin() + begin, order_.begin() + mid,
+                   order_.begin() + end,
+                   [&spheres, axis](uint32_t a, uint32_t b) {
+                     return spheres[a].center[axis] < spheres[b].center[axis];
+                   });
+
+  BuildRecursive(spheres, begin, mid);
+  uint32_t second_child = BuildRecursive(spheres, mid, end);
+  // The recursion may have reallocated nodes_.
+  nodes_[index].second_child_or_block = second_child;
+  nodes_[index].num_spheres = 0;
+  return index;
+}
+
+int SphereBVH::Intersect(const glm::vec3& origin,
+                         const glm::vec3& direction,
+                         float& t) const {
+  t = std::numeric_limits<float>::max();
+  if (nodes_.empty())
+    return -1;
+  int closest = -1;
+  glm::vec3 inv_direction = 1.0f / direction;
+  float a = glm::dot(direction, direction);
+  float inv_a = 1.0f / a;
+
+  uint32_t stack[64];
+  int stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    const Node& node = nodes_[stack[--stack_size]];
+    if (IntersectBox(node.bounds_min, node.bounds_max, origin, inv_direction,
+                     t) < 0.0f)
+      continue;
+    if (node.num_spheres == 0) {
+      if (stack_size + 2 > 64) {
+        throw std::runtime_error("BVH is too deep to traverse!");
+      }
+      stack[stack_size++] = node.second_child_or_block;
+      stack[stack_size++] = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+      continue;
+    }
+
+    // Nearer root of |origin + t * direction - center|^2 = radius^2 on all
+    // lanes at once, written to vectorize without intrinsics. The
+    // discriminant comes from the distance between the center and the ray,
+    // which unlike b^2 - ac does not cancel out for small, far spheres.
+    const SphereBlock& block = blocks_[node.second_child_or_block];
+    float lane_t[kBlockSize];
+    for (uint32_t k = 0; k < kBlockSize; k++) {
+      float ox = origin.x - block.center[0][k];
+      float oy = origin.y - block.center[1][k];
+      float oz = origin.z - block.center[2][k];
+      float b = ox * direction.x + oy * direction.y + oz * direction.z;
+      float lx = ox - b * inv_a * direction.x;
+      float ly = oy - b * inv_a * direction.y;
+      float lz = oz - b * inv_a * direction.z;
+      float discriminant =
+          a * (block.radius_sq[k] - (lx * lx + ly * ly + lz * lz));
+      lane_t[k] = discriminant >= 0.0f
+                      ? (-b - std::sqrt(discriminant)) * inv_a
+                      : -1.0f;
+    }
+    for (uint32_t k = 0; k < node.num_spheres; k++) {
+      if (lane_t[k] > 0.0f && lane_t[k] < t) {
+        t = lane_t[k];
+        closest = static_cast<int>(block.spheres[k]);
+      }
+    }
+  }
+  return closest;
+}
+}  // namespace GLOO
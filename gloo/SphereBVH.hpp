@@ -0,0 +1,54 @@
+#ifndef GLOO_SPHERE_BVH_H_
+#define GLOO_SPHERE_BVH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.hpp"
+
+namespace GLOO {
+// Bounding volume hierarchy over spheres, for picking among many small
+// objects such as joints. It is cheap enough to rebuild every frame, and
+// rebuilding reuses the previous storage, so neither refreshing nor
+// querying allocates once the sphere count is stable.
+class SphereBVH {
+ public:
+  void Build(const std::vector<BoundingSphere>& spheres);
+
+  // Returns the index of the closest sphere hit in front of the origin and
+  // its distance in t, or -1 if no sphere is hit.
+  int Intersect(const glm::vec3& origin,
+                const glm::vec3& direction,
+                float& t) const;
+
+ private:
+  static const uint32_t kBlockSize = 4;
+
+  // Same depth-first layout as TriangleBVH.
+  struct Node {
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+    uint32_t second_child_or_block;
+    uint32_t num_spheres;
+  };
+
+  // Spheres in structure-of-arrays layout, tested together.
+  struct SphereBlock {
+    float center[3][kBlockSize];
+    float radius_sq[kBlockSize];
+    uint32_t spheres[kBlockSize];
+  };
+
+  uint32_t BuildRecursive(const std::vector<BoundingSphere>& spheres,
+                          size_t begin,
+                          size_t end);
+
+  std::vector<uint32_t> order_;
+  std::vector<Node> nodes_;
+  std::vector<SphereBlock> blocks_;
+};
+}  // namespace GLOO
+
+#endif
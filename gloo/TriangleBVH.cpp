@@ -0,0 +1,249 @@
+#include "TriangleBVH.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+// Slab test; returns the entry distance, or a negative value on a miss.
+float IntersectBox(const glm::vec3& bounds_min,
+                   const glm::vec3& bounds_max,
+                   const glm::vec3& origin,
+                   const glm::vec3& inv_direction,
+                   float max_t) {
+  glm::vec3 t0 = (bounds_min - origin) * inv_direction;
+  glm::vec3 t1 = (bounds_max - origin) * inv_direction;
+  glm::vec3 t_near = glm::min(t0, t1);
+  glm::vec3 t_far = glm::max(t0, t1);
+  float t_entry =
+      std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+  float t_exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_t));
+  return t_entry <= t_exit ? t_entry : -1.0f;
+}
+}  // namespace
+
+namespace GLOO {
+const uint32_t TriangleBVH::kBlockSize;
+
+TriangleBVH::TriangleBVH() : num_vertices_(0) {
+}
+
+void TriangleBVH::Build(const PositionArray& positions,
+                        const IndexArray& indices) {
+  indices_ = indices;
+  num_vertices_ = positions.size();
+  nodes_.clear();
+  blocks_.clear();
+  size_t num_triangles = indices_.size() / 3;
+  if (num_triangles == 0)
+    return;
+
+  std::vector<uint32_t> triangles(num_triangles);
+  std::vector<glm::vec3> centroids(num_triangles);
+  for (size_t t = 0; t < num_triangles; t++) {
+    for (size_t c = 0; c < 3; c++) {
+      if (indices_[3 * t + c] >= num_vertices_) {
+        throw std::runtime_error("Index out of range in BVH build!");
+      }
+    }
+    triangles[t] = static_cast<uint32_t>(t);
+    centroids[t] = (positions[indices_[3 * t]] +
+                    positions[indices_[3 * t + 1]] +
+                    positions[indices_[3 * t + 2]]) /
+                   3.0f;
+  }
+  nodes_.reserve(2 * (num_triangles / kBlockSize + 1));
+  blocks_.reserve(num_triangles / kBlockSize + 1);
+  BuildRecursive(triangles, centroids, 0, num_triangles);
+  Refit(positions);
+}
+
+uint32_t TriangleBVH::BuildRecursive(std::vector<uint32_t>& triangles,
+                                     const std::vector<glm::vec3>& centroids,
+                                     size_t begin,
+                                     size_t end) {
+  uint32_t index = static_cast<uint32_t>(nodes_.size());
+  nodes_.push_back(Node());
+  size_t count = end - begin;
+  if (count <= kBlockSize) {
+    TriangleBlock block;
+    for (uint32_t k = 0; k < kBlockSize; k++) {
+      block.triangles[k] = triangles[begin + std::min<size_t>(k, count - 1)];
+    }
+    nodes_[index].second_child_or_block = static_cast<uint32_t>(blocks_.size());
+    nodes_[index].num_triangles = static_cast<uint32_t>(count);
+    blocks_.push_back(block);
+    return index;
+  }
+
+  // Median split along the axis of largest centroid extent. It keeps the
+  // tree balanced, which matters more than a tight fit for a tree that is
+  // refit to new poses rather than rebuilt.
+  glm::vec3 centroid_min(std::numeric_limits<float>::max());
+  glm::vec3 centroid_max(-std::numeric_limits<float>::max());
+  for (size_t i = begin; i < end; i++) {
+    centroid_min = glm::min(centroid_min, centroids[triangles[i]]);
+    centroid_max = glm::max(centroid_max, centroids[triangles[i]]);
+  }
+  glm::vec3 extent = centroid_max - centroid_min;
+  int axis = 0;
+  if (extent.y > extent[axis])
+    axis = 1;
+  if (extent.z > extent[axis])
+    axis = 2;
+  size_t mid = begin + count / 2;
+  std::nth_element(triangles.begin() + begin, triangles.begin() + mid,
+                   triangles.begin() + end,
+                   [&centroids, axis](uint32_t a, uint32_t b) {
+                     return centroids[a][axis] < centroids[b][axis];
+                   });
+
+  BuildRecursive(triangles, centroids, begin, mid);
+  uint32_t second_child = BuildRecursive(triangles, centroids, mid, end);
+  nodes_[index].second_child_or_block = second_child;
+  nodes_[index].num_triangles = 0;
+  return index;
+}
+
+void TriangleBVH::Refit(const PositionArray& positions) {
+  if (positions.size() != num_vertices_) {
+    throw std::runtime_error("BVH refit with a different vertex count!");
+  }
+  // Children follow their parents, so a reverse sweep visits them first.
+  for (size_t i = nodes_.size(); i-- > 0;) {
+    Node& node = nodes_[i];
+    if (node.num_triangles > 0) {
+      FillLeaf(node, blocks_[node.second_child_or_block], positions);
+    } else {
+      const Node& first = nodes_[i + 1];
+      const Node& second = nodes_[node.second_child_or_block];
+      node.bounds_min = glm::min(first.bounds_min, second.bounds_min);
+      node.bounds_max = glm::max(first.bounds_max, second.bounds_max);
+    }
+  }
+}
+
+void TriangleBVH::FillLeaf(Node& node,
+                           TriangleBlock& block,
+                           const PositionArray& positions) const {
+  node.bounds_min = glm::vec3(std::numeric_limits<float>::max());
+  node.bounds_max = glm::vec3(-std::numeric_limits<float>::max());
+  for (uint32_t k = 0; k < kBlockSize; k++) {
+    glm::vec3 v0(0.0f), edge1(0.0f), edge2(0.0f);
+    if (k < node.num_triangles) {
+      const unsigned int* triangle = &indices_[3 * block.triangles[k]];
+      v0 = positions[triangle[0]];
+      glm::vec3 v1 = positions[triangle[1]];
+      glm::vec3 v2 = positions[triangle[2]];
+      edge1 = v1 - v0;
+      edge2 = v2 - v0;
+      node.bounds_min =
+          glm::min(node.bounds_min, glm::min(v0, glm::min(v1, v2)));
+      node.bounds_max =
+          glm::max(node.bounds_max, glm::max(v0, glm::max(v1, v2)));
+    }
+    for (int c = 0; c < 3; c++) {
+      block.v0[c][k] = v0[c];
+      block.edge1[c][k] = edge1[c];
+      block.edge2[c][k] = edge2[c];
+    }
+  }
+}
+
+bool TriangleBVH::Intersect(const glm::vec3& origin,
+                            const glm::vec3& direction,
+                            RayHit& hit,
+                            float max_t) const {
+  hit.t = max_t;
+  if (IsEmpty())
+    return false;
+  bool found = false;
+  glm::vec3 inv_direction = 1.0f / direction;
+
+  // Pending nodes with their entry distances, nearest on top.
+  struct StackEntry {
+    uint32_t node;
+    float t_entry;
+  };
+  StackEntry stack[64];
+  int stack_size = 0;
+  float t_root = IntersectBox(nodes_[0].bounds_min, nodes_[0].bounds_max,
+                              origin, inv_direction, hit.t);
+  if (t_root >= 0.0f)
+    stack[stack_size++] = {0, t_root};
+
+  while (stack_size > 0) {
+    StackEntry entry = stack[--stack_size];
+    if (entry.t_entry > hit.t)
+      continue;
+    const Node& node = nodes_[entry.node];
+    if (node.num_triangles > 0) {
+      float previous_t = hit.t;
+      IntersectBlock(blocks_[node.second_child_or_block], node.num_triangles,
+                     origin, direction, hit);
+      found |= hit.t < previous_t;
+      continue;
+    }
+
+    uint32_t children[2] = {entry.node + 1, node.second_child_or_block};
+    float t_children[2];
+    for (int c = 0; c < 2; c++) {
+      const Node& child = nodes_[children[c]];
+      t_children[c] = IntersectBox(child.bounds_min, child.bounds_max, origin,
+                                   inv_direction, hit.t);
+    }
+    int near = t_children[1] >= 0.0f &&
+                       (t_children[0] < 0.0f || t_children[1] < t_children[0])
+                   ? 1
+                   : 0;
+    int far = 1 - near;
+    if (stack_size + 2 > 64) {
+      throw std::runtime_error("BVH is too deep to traverse!");
+    }
+    if (t_children[far] >= 0.0f)
+      stack[stack_size++] = {children[far], t_children[far]};
+    if (t_children[near] >= 0.0f)
+      stack[stack_size++] = {children[near], t_children[near]};
+  }
+  return found;
+}
+
+void TriangleBVH::IntersectBlock(const TriangleBlock& block,
+                                 uint32_t num_triangles,
+                                 const glm::vec3& origin,
+                                 const glm::vec3& direction,
+                                 RayHit& hit) const {
+  // Moller-Trumbore on all lanes at once. Written as plain loops over
+  // arrays so that it vectorizes without intrinsics; degenerate padding
+  // lanes produce NaNs that fail every comparison.
+  float t[kBlockSize], u[kBlockSize], v[kBlockSize];
+  for (uint32_t k = 0; k < kBlockSize; k++) {
+    float e1x = block.edge1[0][k], e1y = block.edge1[1][k],
+          e1z = block.edge1[2][k];
+    float e2x = block.edge2[0][k], e2y = block.edge2[1][k],
+          e2z = block.edge2[2][k];
+    float px = direction.y * e2z - direction.z * e2y;
+    float py = direction.z * e2x - direction.x * e2z;
+    float pz = direction.x * e2y - direction.y * e2x;
+    float inv_det = 1.0f / (e1x * px + e1y * py + e1z * pz);
+    float sx = origin.x - block.v0[0][k];
+    float sy = origin.y - block.v0[1][k];
+    float sz = origin.z - block.v0[2][k];
+    u[k] = (sx * px + sy * py + sz * pz) * inv_det;
+    float qx = sy * e1z - sz * e1y;
+    float qy = sz * e1x - sx * e1z;
+    float qz = sx * e1y - sy * e1x;
+    v[k] = (direction.x * qx + direction.y * qy + direction.z * qz) * inv_det;
+    t[k] = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+  }
+  for (uint32_t k = 0; k < num_triangles; k++) {
+    if (u[k] >= 0.0f && v[k] >= 0.0f && u[k] + v[k] <= 1.0f && t[k] > 0.0f &&
+        t[k] < hit.t) {
+      hit.t = t[k];
+      hit.u = u[k];
+      hit.v = v[k];
+      hit.triangle = block.triangles[k];
+    }
+  }
+}
+}  // namespace GLOO
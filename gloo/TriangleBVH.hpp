@@ -0,0 +1,88 @@
+#ifndef GLOO_TRIANGLE_BVH_H_
+#define GLOO_TRIANGLE_BVH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "alias_types.hpp"
+
+namespace GLOO {
+struct RayHit {
+  // Distance along the ray, in units of the ray direction's length.
+  float t;
+  uint32_t triangle;
+  // Barycentric coordinates of the hit point with respect to the second
+  // and third vertex of the triangle.
+  float u, v;
+};
+
+// Bounding volume hierarchy over the triangles of an indexed mesh, for ray
+// casts against meshes that deform without changing topology. The tree is
+// built once; after the vertices move, Refit recomputes the bounds
+// bottom-up in linear time while keeping the tree structure.
+class TriangleBVH {
+ public:
+  TriangleBVH();
+
+  bool IsEmpty() const {
+    return nodes_.empty();
+  }
+
+  void Build(const PositionArray& positions, const IndexArray& indices);
+  // Positions must have the same vertex count as on Build.
+  void Refit(const PositionArray& positions);
+
+  // Finds the closest hit with t in (0, max_t). Returns whether there is
+  // one.
+  bool Intersect(const glm::vec3& origin,
+                 const glm::vec3& direction,
+                 RayHit& hit,
+                 float max_t = 1e30f) const;
+
+ private:
+  static const uint32_t kBlockSize = 4;
+
+  // Depth-first layout: an interior node's first child follows it and
+  // second_child points to the other one. Leaves own one triangle block.
+  struct Node {
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+    // Second child of an interior node, or block index of a leaf.
+    uint32_t second_child_or_block;
+    // Number of triangles in a leaf, 0 for interior nodes.
+    uint32_t num_triangles;
+  };
+
+  // Up to kBlockSize triangles in structure-of-arrays layout, tested
+  // against a ray together so that the compiler can vectorize the test.
+  // Unused lanes hold degenerate triangles that never hit.
+  struct TriangleBlock {
+    float v0[3][kBlockSize];
+    float edge1[3][kBlockSize];
+    float edge2[3][kBlockSize];
+    uint32_t triangles[kBlockSize];
+  };
+
+  uint32_t BuildRecursive(std::vector<uint32_t>& triangles,
+                          const std::vector<glm::vec3>& centroids,
+                          size_t begin,
+                          size_t end);
+  void FillLeaf(Node& node,
+                TriangleBlock& block,
+                const PositionArray& positions) const;
+  void IntersectBlock(const TriangleBlock& block,
+                      uint32_t num_triangles,
+                      const glm::vec3& origin,
+                      const glm::vec3& direction,
+                      RayHit& hit) const;
+
+  IndexArray indices_;
+  size_t num_vertices_;
+  std::vector<Node> nodes_;
+  std::vector<TriangleBlock> blocks_;
+};
+}  // namespace GLOO
+
+#endif
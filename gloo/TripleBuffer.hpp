@@ -0,0 +1,63 @@
+#ifndef GLOO_TRIPLE_BUFFER_H_
+#define GLOO_TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace GLOO {
+// Lock-free hand-off of the latest value from one writer thread to one
+// reader thread. The writer fills the back buffer and publishes it; the
+// reader picks up the most recently published buffer, skipping any that
+// were overwritten in between. Neither side ever waits for the other.
+template <class T>
+class TripleBuffer {
+ public:
+  TripleBuffer() : front_(0), middle_(1), back_(2) {
+  }
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Writer side. The back buffer keeps its old contents, so it can be
+  // refilled without reallocating, unless the reader moved them out.
+  T& GetWriteBuffer() {
+    return buffers_[back_];
+  }
+  void Publish() {
+    unsigned int old_middle =
+        middle_.exchange(back_ | kFreshBit, std::memory_order_acq_rel);
+    back_ = old_middle & kIndexMask;
+  }
+
+  // Reader side. Returns whether a new buffer was published since the last
+  // Acquire; GetReadBuffer then refers to it.
+  bool Acquire() {
+    if ((middle_.load(std::memory_order_acquire) & kFreshBit) == 0)
+      return false;
+    unsigned int old_middle =
+        middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = old_middle & kIndexMask;
+    return true;
+  }
+  const T& GetReadBuffer() const {
+    return buffers_[front_];
+  }
+  // The reader may also move data out of the read buffer; the writer gets
+  // it back as it was left.
+  T& GetReadBuffer() {
+    return buffers_[front_];
+  }
+
+ private:
+  static const unsigned int kIndexMask = 3;
+  static const unsigned int kFreshBit = 4;
+
+  T buffers_[3];
+  unsigned int front_;
+  // Index of the buffer between the two sides, plus kFreshBit when it was
+  // published but not yet acquired.
+  std::atomic<unsigned int> middle_;
+  unsigned int back_;
+};
+}  // namespace GLOO
+
+#endif
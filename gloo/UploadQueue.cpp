@@ -0,0 +1,36 @@
+#include "UploadQueue.hpp"
+
+#include <chrono>
+
+namespace GLOO {
+void UploadQueue::Push(Step step) {
+  steps_.push_back(std::move(step));
+  num_pushed_++;
+}
+
+void UploadQueue::Run(double budget_ms) {
+  auto start = std::chrono::steady_clock::now();
+  while (!steps_.empty()) {
+    RunFront();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (elapsed.count() >= budget_ms)
+      break;
+  }
+}
+
+void UploadQueue::Flush() {
+  while (!steps_.empty()) {
+    RunFront();
+  }
+}
+
+void UploadQueue::RunFront() {
+  // Steps may push further steps, which must not invalidate the one
+  // running, so it is moved out first.
+  Step step = std::move(steps_.front());
+  steps_.pop_front();
+  if (!step())
+    steps_.push_front(std::move(step));
+}
+}  // namespace GLOO
@@ -0,0 +1,46 @@
+#ifndef GLOO_UPLOAD_QUEUE_H_
+#define GLOO_UPLOAD_QUEUE_H_
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+
+namespace GLOO {
+// Work that has to run on the render thread, which owns the GL context,
+// split into steps so that a large upload is spread over several frames
+// instead of stalling one.
+class UploadQueue {
+ public:
+  // Returns false while it has work left, and is then run again.
+  using Step = std::function<bool()>;
+
+  UploadQueue() : num_pushed_(0) {
+  }
+
+  void Push(Step step);
+  // Runs steps in order until the queue is empty or budget_ms have passed.
+  // At least one step runs per call, so the queue always makes progress.
+  void Run(double budget_ms);
+  // Runs all steps, for callers that need the uploads done right away.
+  void Flush();
+  bool IsEmpty() const {
+    return steps_.empty();
+  }
+  // Steps ever pushed and steps finished, for progress reports.
+  size_t GetNumPushed() const {
+    return num_pushed_;
+  }
+  size_t GetNumFinished() const {
+    return num_pushed_ - steps_.size();
+  }
+
+ private:
+  // Runs the front step once and pops it if it is done.
+  void RunFront();
+
+  std::deque<Step> steps_;
+  size_t num_pushed_;
+};
+}  // namespace GLOO
+
+#endif
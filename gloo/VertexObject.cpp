@@ -1,51 +1,391 @@
 #include "VertexObject.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <iostream>
 #include <stdexcept>
 
 #include "gloo/gl_wrapper/BindGuard.hpp"
+#include "gloo/utils.hpp"
 #include "gloo/SceneNode.hpp"
 
+namespace {
+glm::vec4 ToVec4(const glm::vec2& v) {
+  return glm::vec4(v.x, v.y, 0.0f, 0.0f);
+}
+
+glm::vec4 ToVec4(const glm::vec3& v) {
+  return glm::vec4(v, 0.0f);
+}
+
+glm::vec4 ToVec4(const glm::vec4& v) {
+  return v;
+}
+
+glm::vec4 ToVec4(const glm::uvec4& v) {
+  return glm::vec4(v);
+}
+
+// Packs vertices [first, first + count) of array.
+template <class Array>
+void PackArray(const Array* array,
+               const GLOO::VertexAttributeFormat& format,
+               size_t stride,
+               size_t first,
+               size_t count,
+               std::vector<unsigned char>& data) {
+  // Attributes without data are left zeroed.
+  if (array == nullptr)
+    return;
+  size_t end = std::min(first + count,
+                        std::min(array->size(), data.size() / stride));
+  for (size_t i = first; i < end; i++) {
+    GLOO::VertexFormat::Write(format, ToVec4((*array)[i]), &data[i * stride]);
+  }
+}
+}  // namespace
+
 namespace GLOO {
+void VertexObject::SetVertexFormat(const VertexFormat& format) {
+  layout_ = VertexLayout::Interleaved;
+  custom_format_ = true;
+  format_ = format;
+  vertex_array_->CreateInterleavedBuffer(format_, usage_);
+  // Forces a full repack.
+  interleaved_data_.clear();
+  UpdateInterleaved({VertexAttribute::Position});
+}
+
+void VertexObject::SetBufferUsage(BufferUsage usage) {
+  if (usage == usage_) {
+    return;
+  }
+  usage_ = usage;
+  if (layout_ == VertexLayout::Interleaved) {
+    if (vertex_array_->HasInterleavedBuffer()) {
+      vertex_array_->CreateInterleavedBuffer(format_, usage_);
+      vertex_array_->UpdateInterleaved(interleaved_data_);
+    }
+    return;
+  }
+  if (positions_ != nullptr) {
+    vertex_array_->CreatePositionBuffer(usage_);
+    vertex_array_->UpdatePositions(*positions_);
+  }
+  if (normals_ != nullptr) {
+    vertex_array_->CreateNormalBuffer(usage_);
+    vertex_array_->UpdateNormals(*normals_);
+  }
+  if (colors_ != nullptr) {
+    vertex_array_->CreateColorBuffer(usage_);
+    vertex_array_->UpdateColors(*colors_);
+  }
+  if (tex_coords_ != nullptr) {
+    vertex_array_->CreateTexCoordBuffer(usage_);
+    vertex_array_->UpdateTexCoords(*tex_coords_);
+  }
+}
+
 void VertexObject::UpdatePositions(std::unique_ptr<PositionArray> positions) {
+  if (layout_ == VertexLayout::Interleaved) {
+    positions_ = std::move(positions);
+    UpdateBounds();
+    UpdateInterleaved({VertexAttribute::Position});
+    return;
+  }
   if (positions_ == nullptr) {
-    vertex_array_->CreatePositionBuffer();
+    vertex_array_->CreatePositionBuffer(usage_);
   }
   positions_ = std::move(positions);
+  UpdateBounds();
   vertex_array_->UpdatePositions(*positions_);
 }
 
+void VertexObject::UpdatePositionsAndNormals(
+    std::unique_ptr<PositionArray> positions,
+    std::unique_ptr<NormalArray> normals) {
+  if (layout_ == VertexLayout::Interleaved) {
+    positions_ = std::move(positions);
+    normals_ = std::move(normals);
+    UpdateBounds();
+    UpdateInterleaved({VertexAttribute::Position, VertexAttribute::Normal});
+    return;
+  }
+  UpdatePositions(std::move(positions));
+  UpdateNormals(std::move(normals));
+}
+
+void VertexObject::SwapPositionsAndNormals(PositionArray& positions,
+                                           NormalArray& normals) {
+  if (positions_ == nullptr || normals_ == nullptr) {
+    // Nothing to give back yet; the buffers are created on this call.
+    UpdatePositionsAndNormals(make_unique<PositionArray>(std::move(positions)),
+                              make_unique<NormalArray>(std::move(normals)));
+    return;
+  }
+  positions_->swap(positions);
+  normals_->swap(normals);
+  UpdateBounds();
+  if (layout_ == VertexLayout::Interleaved) {
+    UpdateInterleaved({VertexAttribute::Position, VertexAttribute::Normal});
+    return;
+  }
+  vertex_array_->UpdatePositions(*positions_);
+  vertex_array_->UpdateNormals(*normals_);
+}
+
+void VertexObject::SetPositionsAndNormals(
+    std::unique_ptr<PositionArray> positions,
+    std::unique_ptr<NormalArray> normals) {
+  if (layout_ != VertexLayout::Interleaved) {
+    UpdatePositionsAndNormals(std::move(positions), std::move(normals));
+    return;
+  }
+  positions_ = std::move(positions);
+  normals_ = std::move(normals);
+  UpdateBounds();
+  VertexFormat format = custom_format_ ? format_ : MakeFloatFormat();
+  if (!vertex_array_->HasInterleavedBuffer() || format != format_) {
+    format_ = format;
+    vertex_array_->CreateInterleavedBuffer(format_, usage_);
+  }
+  size_t num_bytes = positions_->size() * format_.GetStride();
+  interleaved_data_.assign(num_bytes, 0);
+  vertex_array_->ResizeInterleaved(num_bytes);
+  num_uploaded_vertices_ = 0;
+}
+
+bool VertexObject::UploadVertices(size_t max_vertices) {
+  size_t num_vertices = positions_ == nullptr ? 0 : positions_->size();
+  if (layout_ != VertexLayout::Interleaved ||
+      num_uploaded_vertices_ >= num_vertices) {
+    return true;
+  }
+  size_t first = num_uploaded_vertices_;
+  size_t count = std::min(max_vertices, num_vertices - first);
+  for (const VertexAttributeFormat& attr : format_.GetAttributes()) {
+    PackAttribute(attr, first, count);
+  }
+  size_t stride = format_.GetStride();
+  vertex_array_->UpdateInterleaved(interleaved_data_, first * stride,
+                                   count * stride);
+  num_uploaded_vertices_ += count;
+  return num_uploaded_vertices_ == num_vertices;
+}
+
 void VertexObject::UpdateIndices(std::unique_ptr<IndexArray> indices) {
-  if (indices_ == nullptr) {
+  if (indices_ == nullptr || vertex_array_->IsIndexBufferShared()) {
     vertex_array_->CreateIndexBuffer();
   }
   indices_ = std::move(indices);
   vertex_array_->UpdateIndices(*indices_);
 }
 
+void VertexObject::ShareIndices(const VertexObject& other) {
+  indices_ = other.indices_;
+  vertex_array_->ShareIndexBuffer(*other.vertex_array_);
+}
+
 void VertexObject::UpdateNormals(std::unique_ptr<NormalArray> normals) {
+  if (layout_ == VertexLayout::Interleaved) {
+    normals_ = std::move(normals);
+    UpdateInterleaved({VertexAttribute::Normal});
+    return;
+  }
   if (normals_ == nullptr) {
-    vertex_array_->CreateNormalBuffer();
+    vertex_array_->CreateNormalBuffer(usage_);
   }
   normals_ = std::move(normals);
   vertex_array_->UpdateNormals(*normals_);
 }
 
 void VertexObject::UpdateColors(std::unique_ptr<ColorArray> colors) {
+  if (layout_ == VertexLayout::Interleaved) {
+    colors_ = std::move(colors);
+    UpdateInterleaved({VertexAttribute::Color});
+    return;
+  }
   if (colors_ == nullptr) {
-    vertex_array_->CreateColorBuffer();
+    vertex_array_->CreateColorBuffer(usage_);
   }
   colors_ = std::move(colors);
   vertex_array_->UpdateColors(*colors_);
 }
 
 void VertexObject::UpdateTexCoord(std::unique_ptr<TexCoordArray> tex_coords) {
+  if (layout_ == VertexLayout::Interleaved) {
+    tex_coords_ = std::move(tex_coords);
+    UpdateInterleaved({VertexAttribute::TexCoord});
+    return;
+  }
   if (tex_coords_ == nullptr) {
-    vertex_array_->CreateTexCoordBuffer();
+    vertex_array_->CreateTexCoordBuffer(usage_);
   }
   tex_coords_ = std::move(tex_coords);
   vertex_array_->UpdateTexCoords(*tex_coords_);
 }
 
+void VertexObject::UpdateJointIndices(
+    std::unique_ptr<JointIndexArray> joint_indices) {
+  joint_indices_ = std::move(joint_indices);
+  if (layout_ == VertexLayout::Interleaved) {
+    UpdateInterleaved({VertexAttribute::JointIndices});
+  }
+}
+
+void VertexObject::UpdateJointWeights(
+    std::unique_ptr<JointWeightArray> joint_weights) {
+  joint_weights_ = std::move(joint_weights);
+  if (layout_ == VertexLayout::Interleaved) {
+    UpdateInterleaved({VertexAttribute::JointWeights});
+  }
+}
+
+void VertexObject::UpdateInstances(const InstanceArray& instances) {
+  if (instances_ == nullptr) {
+    vertex_array_->CreateInstanceBuffer();
+    instances_ = make_unique<InstanceArray>();
+  }
+  *instances_ = instances;
+  UpdateBounds();
+  vertex_array_->UpdateInstances(*instances_);
+}
+
+void VertexObject::UpdateInstances(const InstanceArray& instances,
+                                   size_t first,
+                                   size_t count) {
+  if (first + count > instances.size()) {
+    throw std::out_of_range("Instance update range out of bounds!");
+  }
+  if (instances_ == nullptr ||
+      vertex_array_->GetInstanceUsage() != BufferUsage::Dynamic) {
+    vertex_array_->CreateInstanceBuffer(BufferUsage::Dynamic);
+    instances_ = make_unique<InstanceArray>(instances);
+    UpdateBounds();
+    vertex_array_->UpdateInstances(*instances_);
+    return;
+  }
+  if (instances_->size() != instances.size()) {
+    *instances_ = instances;
+  } else {
+    std::copy(instances.begin() + first, instances.begin() + first + count,
+              instances_->begin() + first);
+  }
+  UpdateBounds();
+  vertex_array_->UpdateInstances(*instances_, first, count);
+}
+
+void VertexObject::UpdateBounds() {
+  if (positions_ == nullptr) {
+    bounding_box_ = BoundingBox();
+    bounding_sphere_ = BoundingSphere{glm::vec3(0.0f), 0.0f};
+    return;
+  }
+  BoundingBox mesh_box = BoundingBox::FromPoints(*positions_);
+  glm::vec3 center = mesh_box.GetCenter();
+  float radius_sq = 0.0f;
+  for (const glm::vec3& position : *positions_) {
+    glm::vec3 offset = position - center;
+    radius_sq = std::max(radius_sq, glm::dot(offset, offset));
+  }
+  BoundingSphere mesh_sphere{center, std::sqrt(radius_sq)};
+
+  if (instances_ == nullptr) {
+    bounding_box_ = mesh_box;
+    bounding_sphere_ = mesh_sphere;
+    return;
+  }
+  bounding_box_ = BoundingBox();
+  for (const InstanceData& instance : *instances_) {
+    bounding_box_.Expand(mesh_box.Transform(instance.transform));
+  }
+  bounding_sphere_.center = bounding_box_.GetCenter();
+  bounding_sphere_.radius = bounding_box_.IsEmpty()
+                                ? 0.0f
+                                : glm::length(bounding_box_.GetExtents());
+}
+
+void VertexObject::UpdateInterleaved(
+    std::initializer_list<VertexAttribute> attributes) {
+  VertexFormat format = custom_format_ ? format_ : MakeFloatFormat();
+  size_t num_vertices = positions_ == nullptr ? 0 : positions_->size();
+  size_t num_bytes = num_vertices * format.GetStride();
+
+  bool new_format =
+      !vertex_array_->HasInterleavedBuffer() || format != format_;
+  if (new_format) {
+    format_ = format;
+    vertex_array_->CreateInterleavedBuffer(format_, usage_);
+  }
+  if (new_format || interleaved_data_.size() != num_bytes) {
+    interleaved_data_.assign(num_bytes, 0);
+    for (const VertexAttributeFormat& attr : format_.GetAttributes()) {
+      PackAttribute(attr, 0, num_vertices);
+    }
+  } else {
+    bool packed = false;
+    for (VertexAttribute attribute : attributes) {
+      const VertexAttributeFormat* attr = format_.Find(attribute);
+      // Attributes missing from the format are kept on the CPU only.
+      if (attr != nullptr) {
+        PackAttribute(*attr, 0, num_vertices);
+        packed = true;
+      }
+    }
+    if (!packed) {
+      return;
+    }
+  }
+  vertex_array_->UpdateInterleaved(interleaved_data_);
+}
+
+VertexFormat VertexObject::MakeFloatFormat() const {
+  VertexFormat format;
+  if (positions_ != nullptr)
+    format.Add(VertexAttribute::Position, 3, GL_FLOAT);
+  if (normals_ != nullptr)
+    format.Add(VertexAttribute::Normal, 3, GL_FLOAT);
+  if (colors_ != nullptr)
+    format.Add(VertexAttribute::Color, 4, GL_FLOAT);
+  if (tex_coords_ != nullptr)
+    format.Add(VertexAttribute::TexCoord, 2, GL_FLOAT);
+  if (joint_indices_ != nullptr)
+    format.Add(VertexAttribute::JointIndices, 4, GL_UNSIGNED_INT, false, true);
+  if (joint_weights_ != nullptr)
+    format.Add(VertexAttribute::JointWeights, 4, GL_FLOAT);
+  return format;
+}
+
+void VertexObject::PackAttribute(const VertexAttributeFormat& format,
+                                 size_t first,
+                                 size_t count) {
+  size_t stride = format_.GetStride();
+  switch (format.attribute) {
+    case VertexAttribute::Position:
+      PackArray(positions_.get(), format, stride, first, count,
+                interleaved_data_);
+      break;
+    case VertexAttribute::Normal:
+      PackArray(normals_.get(), format, stride, first, count,
+                interleaved_data_);
+      break;
+    case VertexAttribute::Color:
+      PackArray(colors_.get(), format, stride, first, count,
+                interleaved_data_);
+      break;
+    case VertexAttribute::TexCoord:
+      PackArray(tex_coords_.get(), format, stride, first, count,
+                interleaved_data_);
+      break;
+    case VertexAttribute::JointIndices:
+      PackArray(joint_indices_.get(), format, stride, first, count,
+                interleaved_data_);
+      break;
+    case VertexAttribute::JointWeights:
+      PackArray(joint_weights_.get(), format, stride, first, count,
+                interleaved_data_);
+      break;
+  }
+}
 }  // namespace GLOO
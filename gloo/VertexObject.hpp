@@ -1,22 +1,87 @@
 #ifndef GLOO_VERTEX_OBJECT_H_
 #define GLOO_VERTEX_OBJECT_H_
 
+#include <initializer_list>
+
 #include "gloo/gl_wrapper/VertexArray.hpp"
+#include "gloo/BoundingBox.hpp"
 
 namespace GLOO {
+enum class VertexLayout {
+  // One buffer per attribute.
+  Separate,
+  // All attributes of a vertex next to each other in a single buffer.
+  Interleaved
+};
+
 // Instances of this class store various vertex data and are responsible
 // for sending data from CPU to GPU via the Update* methods.
 class VertexObject {
  public:
-  VertexObject() : vertex_array_(make_unique<VertexArray>()) {
+  explicit VertexObject(VertexLayout layout = VertexLayout::Separate)
+      : vertex_array_(make_unique<VertexArray>()),
+        usage_(BufferUsage::Static),
+        layout_(layout),
+        custom_format_(false),
+        num_uploaded_vertices_(0) {
+  }
+
+  // Switches to the interleaved layout with an explicit format, e.g.
+  // VertexFormat::PackedSkinned(). Without one, interleaved objects use
+  // 32-bit floats for every attribute that has data. Attributes missing
+  // from the format stay on the CPU; attributes without data are zero.
+  void SetVertexFormat(const VertexFormat& format);
+  VertexLayout GetLayout() const {
+    return layout_;
+  }
+
+  // Chooses how the vertex attribute buffers are updated. Meshes rewritten
+  // every frame (e.g. skinned meshes) should stream. Existing buffers are
+  // recreated and refilled from the arrays owned by this object.
+  void SetBufferUsage(BufferUsage usage);
+  BufferUsage GetBufferUsage() const {
+    return usage_;
   }
 
   // Vertex buffers are created in a lazy manner in the following Update*.
   void UpdatePositions(std::unique_ptr<PositionArray> positions);
   void UpdateNormals(std::unique_ptr<NormalArray> normals);
+  // Same as the two calls above, but an interleaved object packs and
+  // uploads its vertices only once, e.g. per skinned pose.
+  void UpdatePositionsAndNormals(std::unique_ptr<PositionArray> positions,
+                                 std::unique_ptr<NormalArray> normals);
+  // Same as the above, but swaps the arrays with the ones this object
+  // holds, so that the caller gets the previous ones back to refill
+  // without allocating.
+  void SwapPositionsAndNormals(PositionArray& positions,
+                               NormalArray& normals);
+  // Stores positions and normals like the above, but leaves packing and
+  // uploading an interleaved object's vertices to UploadVertices, so that
+  // a large mesh can be uploaded over several frames. Other attributes
+  // must be set before; it must not be drawn until UploadVertices is done.
+  void SetPositionsAndNormals(std::unique_ptr<PositionArray> positions,
+                              std::unique_ptr<NormalArray> normals);
+  // Packs and uploads up to max_vertices more of the vertices stored by
+  // SetPositionsAndNormals. Returns true once all of them are uploaded.
+  bool UploadVertices(size_t max_vertices);
   void UpdateColors(std::unique_ptr<ColorArray> colors);
   void UpdateTexCoord(std::unique_ptr<TexCoordArray> tex_coords);
   void UpdateIndices(std::unique_ptr<IndexArray> indices);
+  // Uses the indices of other, on the CPU and the GPU, instead of a copy.
+  // Either object updating its indices later stops sharing them.
+  void ShareIndices(const VertexObject& other);
+  // Skinning data only reaches the GPU through interleaved formats.
+  void UpdateJointIndices(std::unique_ptr<JointIndexArray> joint_indices);
+  void UpdateJointWeights(std::unique_ptr<JointWeightArray> joint_weights);
+  // Instances are expected to change every frame, so they are copied into
+  // a reused array instead of being handed over.
+  void UpdateInstances(const InstanceArray& instances);
+  // Uploads only instances [first, first + count) of instances, the rest
+  // being equal to the last update. Such objects keep their instances in a
+  // dynamic buffer, as a stream buffer would need all of them.
+  void UpdateInstances(const InstanceArray& instances,
+                       size_t first,
+                       size_t count);
 
   bool HasPositions() const {
     return positions_ != nullptr;
@@ -38,6 +103,14 @@ class VertexObject {
     return indices_ != nullptr;
   }
 
+  bool HasJointWeights() const {
+    return joint_indices_ != nullptr && joint_weights_ != nullptr;
+  }
+
+  bool HasInstances() const {
+    return instances_ != nullptr;
+  }
+
   const PositionArray& GetPositions() const {
     if (positions_ == nullptr)
       throw std::runtime_error("No position in VertexObject!");
@@ -68,6 +141,33 @@ class VertexObject {
     return *indices_;
   }
 
+  const JointIndexArray& GetJointIndices() const {
+    if (joint_indices_ == nullptr)
+      throw std::runtime_error("No joint indices in VertexObject!");
+    return *joint_indices_;
+  }
+
+  const JointWeightArray& GetJointWeights() const {
+    if (joint_weights_ == nullptr)
+      throw std::runtime_error("No joint weights in VertexObject!");
+    return *joint_weights_;
+  }
+
+  const InstanceArray& GetInstances() const {
+    if (instances_ == nullptr)
+      throw std::runtime_error("No instances in VertexObject!");
+    return *instances_;
+  }
+
+  // Local-space bounds of everything a draw of this object covers,
+  // including all instances. Updated with positions and instances.
+  const BoundingBox& GetBoundingBox() const {
+    return bounding_box_;
+  }
+  const BoundingSphere& GetBoundingSphere() const {
+    return bounding_sphere_;
+  }
+
   VertexArray& GetVertexArray() {
     return *vertex_array_.get();
   }
@@ -76,14 +176,38 @@ class VertexObject {
   }
 
  private:
+  // Brings the interleaved buffer up to date after attributes changed.
+  void UpdateInterleaved(std::initializer_list<VertexAttribute> attributes);
+  VertexFormat MakeFloatFormat() const;
+  void UpdateBounds();
+  // Packs vertices [first, first + count) of the attribute.
+  void PackAttribute(const VertexAttributeFormat& format,
+                     size_t first,
+                     size_t count);
+
   std::unique_ptr<VertexArray> vertex_array_;
+  BufferUsage usage_;
+  VertexLayout layout_;
+  bool custom_format_;
+  VertexFormat format_;
+  // CPU copy of the interleaved buffer, so that single attributes can be
+  // repacked in place.
+  std::vector<unsigned char> interleaved_data_;
+  // Vertices of interleaved_data_ uploaded by UploadVertices so far.
+  size_t num_uploaded_vertices_;
+  BoundingBox bounding_box_;
+  BoundingSphere bounding_sphere_;
 
   // Owner of vertex data.
   std::unique_ptr<PositionArray> positions_;
   std::unique_ptr<NormalArray> normals_;
   std::unique_ptr<ColorArray> colors_;
   std::unique_ptr<TexCoordArray> tex_coords_;
-  std::unique_ptr<IndexArray> indices_;
+  // Possibly shared with other objects through ShareIndices.
+  std::shared_ptr<const IndexArray> indices_;
+  std::unique_ptr<JointIndexArray> joint_indices_;
+  std::unique_ptr<JointWeightArray> joint_weights_;
+  std::unique_ptr<InstanceArray> instances_;
 };
 
 }  // namespace GLOO
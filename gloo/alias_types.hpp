@@ -11,6 +11,17 @@ using NormalArray = std::vector<glm::vec3>;
 using ColorArray = std::vector<glm::vec4>;
 using TexCoordArray = std::vector<glm::vec2>;
 using IndexArray = std::vector<unsigned int>;
+// Up to four influencing joints per vertex and their weights.
+using JointIndexArray = std::vector<glm::uvec4>;
+using JointWeightArray = std::vector<glm::vec4>;
+
+// Per-instance attributes consumed by the instanced shaders.
+struct InstanceData {
+  glm::mat4 transform;
+  glm::vec4 color;
+  glm::mat3 normal_matrix;
+};
+using InstanceArray = std::vector<InstanceData>;
 }  // namespace GLOO
 
 #endif
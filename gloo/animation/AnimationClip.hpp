@@ -0,0 +1,40 @@
+#ifndef GLOO_ANIMATION_CLIP_H_
+#define GLOO_ANIMATION_CLIP_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace GLOO {
+// Keyframes of one joint property. Times are in seconds and strictly
+// increasing, and values[i] is the value at times[i]. Both are contiguous,
+// so that sampling streams through them.
+template <class T>
+struct AnimationTrack {
+  int joint;
+  std::vector<float> times;
+  std::vector<T> values;
+};
+
+using RotationTrack = AnimationTrack<glm::quat>;
+using TranslationTrack = AnimationTrack<glm::vec3>;
+
+// Keyframed motion of a skeleton, with at most one track per joint and
+// property. Joints without a track keep the pose they are sampled into.
+struct AnimationClip {
+  AnimationClip() : duration(0.0f) {
+  }
+
+  bool IsEmpty() const {
+    return rotation_tracks.empty() && translation_tracks.empty();
+  }
+
+  // Time of the last keyframe.
+  float duration;
+  std::vector<RotationTrack> rotation_tracks;
+  std::vector<TranslationTrack> translation_tracks;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,148 @@
+#include "ClipCompressor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "ClipSampler.hpp"
+#include "Pose.hpp"
+
+namespace {
+using GLOO::ClipCompressor;
+using GLOO::CompressedClip;
+
+// Whether interpolating between the keyframes at frames first and last
+// reproduces every frame in between within max_error. The keys are compared
+// as decoded, so that the quantization error counts against max_error.
+bool IsWithinError(const std::vector<glm::quat>& frames,
+                   const std::vector<glm::quat>& quantized,
+                   size_t first,
+                   size_t last,
+                   float max_error) {
+  float inv_span = 1.0f / float(last - first);
+  for (size_t f = first + 1; f < last; f++) {
+    glm::quat q = CompressedClip::Interpolate(
+        quantized[first], quantized[last], float(f - first) * inv_span);
+    if (ClipCompressor::GetAngle(q, frames[f]) > max_error)
+      return false;
+  }
+  return true;
+}
+
+void CompressTrack(const std::vector<glm::quat>& frames,
+                   float max_error,
+                   std::vector<CompressedClip::Key>& keys) {
+  size_t num_frames = frames.size();
+  std::vector<CompressedClip::Key> encoded(num_frames);
+  std::vector<glm::quat> quantized(num_frames);
+  for (size_t f = 0; f < num_frames; f++) {
+    encoded[f].frame = static_cast<uint16_t>(f);
+    CompressedClip::EncodeRotation(frames[f], encoded[f].rotation);
+    quantized[f] = CompressedClip::DecodeRotation(encoded[f].rotation);
+  }
+
+  keys.push_back(encoded[0]);
+  bool constant = true;
+  for (size_t f = 0; f < num_frames && constant; f++) {
+    constant = ClipCompressor::GetAngle(quantized[0], frames[f]) <= max_error;
+  }
+  if (constant)
+    return;
+
+  size_t first = 0;
+  while (first + 1 < num_frames) {
+    // Gallops to a span end that fails, or past the end of the clip, then
+    // binary searches back to the last end that passes. Checking every end
+    // in turn would take O(span^2) for long spans.
+    size_t last = first + 1;
+    size_t failed = num_frames;
+    size_t step = 1;
+    while (last + step < num_frames) {
+      if (!IsWithinError(frames, quantized, first, last + step, max_error)) {
+        failed = last + step;
+        break;
+      }
+      last += step;
+      step *= 2;
+    }
+    while (last + 1 < failed) {
+      size_t mid = last + (failed - last) / 2;
+      if (IsWithinError(frames, quantized, first, mid, max_error)) {
+        last = mid;
+      } else {
+        failed = mid;
+      }
+    }
+    keys.push_back(encoded[last]);
+    first = last;
+  }
+}
+}  // namespace
+
+namespace GLOO {
+CompressedClip ClipCompressor::Compress(const AnimationClip& clip,
+                                        const Settings& settings) {
+  CompressedClip compressed;
+  compressed.sample_rate = settings.sample_rate;
+  compressed.duration = clip.duration;
+  compressed.translation_tracks = clip.translation_tracks;
+  double num_frames =
+      std::ceil(double(clip.duration) * settings.sample_rate) + 1.0;
+  if (num_frames > 65536.0) {
+    throw std::runtime_error("Clip of " + std::to_string(clip.duration) +
+                             " s is too long to compress!");
+  }
+  compressed.num_frames = static_cast<uint32_t>(num_frames);
+
+  // Plays the clip back frame by frame, as it would be at that rate.
+  int num_joints = 0;
+  for (const RotationTrack& track : clip.rotation_tracks) {
+    num_joints = std::max(num_joints, track.joint + 1);
+  }
+  size_t num_tracks = clip.rotation_tracks.size();
+  std::vector<std::vector<glm::quat>> frames(
+      num_tracks, std::vector<glm::quat>(compressed.num_frames));
+  ClipSampler sampler(clip);
+  Pose pose;
+  pose.Resize(num_joints);
+  for (uint32_t f = 0; f < compressed.num_frames; f++) {
+    float time = std::min(f / settings.sample_rate, clip.duration);
+    sampler.Sample(time, pose);
+    for (size_t i = 0; i < num_tracks; i++) {
+      frames[i][f] = pose.rotations[clip.rotation_tracks[i].joint];
+    }
+  }
+
+  for (size_t i = 0; i < num_tracks; i++) {
+    if (clip.rotation_tracks[i].times.empty())
+      continue;
+    CompressedClip::Track track;
+    track.joint = clip.rotation_tracks[i].joint;
+    track.first_key = static_cast<uint32_t>(compressed.keys.size());
+    CompressTrack(frames[i], settings.max_error, compressed.keys);
+    track.num_keys =
+        static_cast<uint32_t>(compressed.keys.size()) - track.first_key;
+    compressed.rotation_tracks.push_back(track);
+  }
+  compressed.keys.shrink_to_fit();
+  return compressed;
+}
+
+float ClipCompressor::GetAngle(const glm::quat& a, const glm::quat& b) {
+  // From the rotation between a and b, conjugate(a) * b, with atan2 rather
+  // than acos of the dot product: quaternions stored as floats are not
+  // exactly unit, which alone puts acos off by more than the error bounds
+  // in use.
+  double w = double(a.w) * b.w + double(a.x) * b.x + double(a.y) * b.y +
+             double(a.z) * b.z;
+  double x = double(a.w) * b.x - double(b.w) * a.x -
+             (double(a.y) * b.z - double(a.z) * b.y);
+  double y = double(a.w) * b.y - double(b.w) * a.y -
+             (double(a.z) * b.x - double(a.x) * b.z);
+  double z = double(a.w) * b.z - double(b.w) * a.z -
+             (double(a.x) * b.y - double(a.y) * b.x);
+  return static_cast<float>(
+      2.0 * std::atan2(std::sqrt(x * x + y * y + z * z), std::abs(w)));
+}
+}  // namespace GLOO
@@ -0,0 +1,35 @@
+#ifndef GLOO_CLIP_COMPRESSOR_H_
+#define GLOO_CLIP_COMPRESSOR_H_
+
+#include "AnimationClip.hpp"
+#include "CompressedClip.hpp"
+
+namespace GLOO {
+// Compresses the rotation tracks of a clip. Each track is played back at a
+// fixed sample rate and quantized. A track that stays within the error
+// bound of its first frame keeps that frame only. Otherwise keyframes are
+// chosen greedily: each one is placed as far from the last as possible
+// while interpolating between the two reproduces every frame in between
+// within the bound, quantization included.
+class ClipCompressor {
+ public:
+  struct Settings {
+    Settings() : sample_rate(120.0f), max_error(0.001f) {
+    }
+    // Frames per second the tracks are resampled at.
+    float sample_rate;
+    // Largest angle in radians by which a decompressed joint rotation may
+    // differ from the clip's at any frame.
+    float max_error;
+  };
+
+  // Throws if the clip is longer than 65536 frames at the sample rate.
+  static CompressedClip Compress(const AnimationClip& clip,
+                                 const Settings& settings = Settings());
+
+  // Angle in radians of the rotation between a and b.
+  static float GetAngle(const glm::quat& a, const glm::quat& b);
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,73 @@
+#include "ClipSampler.hpp"
+
+#include <algorithm>
+
+namespace {
+// Keyframes stepped over before giving up on the cursor. One suffices at
+// frame rates above the keyframe rate; more covers sparse frames.
+const int kMaxCursorSteps = 4;
+
+glm::quat Interpolate(const glm::quat& a, const glm::quat& b, float t) {
+  // Takes the shorter way around.
+  return glm::slerp(a, b, t);
+}
+
+glm::vec3 Interpolate(const glm::vec3& a, const glm::vec3& b, float t) {
+  return glm::mix(a, b, t);
+}
+
+template <class T>
+T SampleTrack(const GLOO::AnimationTrack<T>& track,
+              float time,
+              size_t key) {
+  const std::vector<float>& times = track.times;
+  if (key + 1 == times.size() || time <= times[key])
+    return track.values[key];
+  float t = (time - times[key]) / (times[key + 1] - times[key]);
+  return Interpolate(track.values[key], track.values[key + 1], t);
+}
+}  // namespace
+
+namespace GLOO {
+ClipSampler::ClipSampler(const AnimationClip& clip)
+    : clip_(clip),
+      rotation_cursors_(clip.rotation_tracks.size(), 0),
+      translation_cursors_(clip.translation_tracks.size(), 0) {
+}
+
+void ClipSampler::Sample(float time, Pose& pose) {
+  size_t num_joints = pose.GetNumJoints();
+  for (size_t i = 0; i < clip_.rotation_tracks.size(); i++) {
+    const RotationTrack& track = clip_.rotation_tracks[i];
+    if (track.times.empty() || size_t(track.joint) >= num_joints)
+      continue;
+    rotation_cursors_[i] = Seek(track.times, time, rotation_cursors_[i]);
+    pose.rotations[track.joint] =
+        SampleTrack(track, time, rotation_cursors_[i]);
+  }
+  for (size_t i = 0; i < clip_.translation_tracks.size(); i++) {
+    const TranslationTrack& track = clip_.translation_tracks[i];
+    if (track.times.empty() || size_t(track.joint) >= num_joints)
+      continue;
+    translation_cursors_[i] =
+        Seek(track.times, time, translation_cursors_[i]);
+    pose.translations[track.joint] =
+        SampleTrack(track, time, translation_cursors_[i]);
+  }
+}
+
+size_t ClipSampler::Seek(const std::vector<float>& times,
+                         float time,
+                         size_t cursor) {
+  size_t last = times.size() - 1;
+  if (cursor <= last && times[cursor] <= time) {
+    for (int step = 0; step <= kMaxCursorSteps; step++) {
+      if (cursor == last || times[cursor + 1] > time)
+        return cursor;
+      cursor++;
+    }
+  }
+  auto it = std::upper_bound(times.begin(), times.end(), time);
+  return it == times.begin() ? 0 : size_t(it - times.begin()) - 1;
+}
+}  // namespace GLOO
@@ -0,0 +1,38 @@
+#ifndef GLOO_CLIP_SAMPLER_H_
+#define GLOO_CLIP_SAMPLER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "AnimationClip.hpp"
+#include "Pose.hpp"
+
+namespace GLOO {
+// Samples a clip into poses. Every track keeps a cursor at the keyframe
+// its last sample fell after, so that playing forward finds the
+// surrounding keyframes in a step or two instead of a binary search per
+// track. Jumps, e.g. when looping, fall back to one binary search.
+class ClipSampler {
+ public:
+  // The clip must outlive the sampler and keep its tracks.
+  explicit ClipSampler(const AnimationClip& clip);
+
+  // Overwrites the animated joints of pose with the clip at time, which is
+  // clamped to the keyframes: rotations are slerped and translations
+  // lerped. Tracks of joints past the end of pose are skipped.
+  void Sample(float time, Pose& pose);
+
+ private:
+  // Index of the last keyframe at or before time, or 0 if there is none,
+  // searching from cursor onwards first.
+  static size_t Seek(const std::vector<float>& times,
+                     float time,
+                     size_t cursor);
+
+  const AnimationClip& clip_;
+  std::vector<size_t> rotation_cursors_;
+  std::vector<size_t> translation_cursors_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,30 @@
+#include "CompressedClip.hpp"
+
+#include <algorithm>
+
+namespace GLOO {
+const uint32_t CompressedClip::kMaxQuantized;
+
+void CompressedClip::EncodeRotation(const glm::quat& q, uint16_t rotation[3]) {
+  float c[4] = {q.x, q.y, q.z, q.w};
+  int largest = 0;
+  for (int i = 1; i < 4; i++) {
+    if (std::abs(c[i]) > std::abs(c[largest]))
+      largest = i;
+  }
+  // q and -q are the same rotation; the one with the largest component
+  // positive is stored.
+  float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+  uint64_t bits = static_cast<uint64_t>(largest);
+  for (int i = 0; i < 4; i++) {
+    if (i == largest)
+      continue;
+    float v = std::min(std::max(sign * c[i] * std::sqrt(2.0f), -1.0f), 1.0f);
+    long quantized = std::lround((v * 0.5f + 0.5f) * kMaxQuantized);
+    bits = bits << 15 | static_cast<uint64_t>(quantized);
+  }
+  rotation[0] = static_cast<uint16_t>(bits);
+  rotation[1] = static_cast<uint16_t>(bits >> 16);
+  rotation[2] = static_cast<uint16_t>(bits >> 32);
+}
+}  // namespace GLOO
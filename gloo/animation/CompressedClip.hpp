@@ -0,0 +1,84 @@
+#ifndef GLOO_COMPRESSED_CLIP_H_
+#define GLOO_COMPRESSED_CLIP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "AnimationClip.hpp"
+
+namespace GLOO {
+// A clip whose rotation tracks are resampled at a fixed rate, quantized to
+// 48 bits per rotation and thinned out to the keyframes needed to stay
+// within an error bound; see ClipCompressor. Translation tracks are kept
+// as they are.
+struct CompressedClip {
+  // Rotations are stored smallest-three: the index of the component with
+  // the largest magnitude in 2 bits, and the other three, from a sign-
+  // flipped quaternion whose largest component is positive, in 15 bits
+  // each. They lie within +-1/sqrt(2), which is all 15 bits cover.
+  struct Key {
+    // Frame of the keyframe at sample_rate.
+    uint16_t frame;
+    uint16_t rotation[3];
+  };
+  struct Track {
+    int joint;
+    // keys[first_key] up to keys[first_key + num_keys], at least one.
+    // Constant tracks have exactly one.
+    uint32_t first_key;
+    uint32_t num_keys;
+  };
+
+  CompressedClip() : sample_rate(0.0f), num_frames(0), duration(0.0f) {
+  }
+
+  // Bytes of the compressed rotation tracks and their keyframes.
+  size_t GetRotationBytes() const {
+    return keys.size() * sizeof(Key) + rotation_tracks.size() * sizeof(Track);
+  }
+
+  static void EncodeRotation(const glm::quat& q, uint16_t rotation[3]);
+  static glm::quat DecodeRotation(const uint16_t rotation[3]) {
+    const float kScale = 2.0f / kMaxQuantized / std::sqrt(2.0f);
+    const float kOffset = -1.0f / std::sqrt(2.0f);
+    uint64_t bits = uint64_t(rotation[0]) | uint64_t(rotation[1]) << 16 |
+                    uint64_t(rotation[2]) << 32;
+    int largest = static_cast<int>(bits >> 45);
+    float c[4];
+    float sum = 0.0f;
+    for (int i = 3; i >= 0; i--) {
+      if (i == largest)
+        continue;
+      c[i] = (bits & kMaxQuantized) * kScale + kOffset;
+      sum += c[i] * c[i];
+      bits >>= 15;
+    }
+    c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return glm::quat(c[3], c[0], c[1], c[2]);
+  }
+  // Normalized lerp along the shorter arc. Used both to decompress and to
+  // measure the error while compressing, so that the bound holds exactly.
+  static glm::quat Interpolate(const glm::quat& a, glm::quat b, float t) {
+    if (glm::dot(a, b) < 0.0f)
+      b = -b;
+    return glm::normalize(a * (1.0f - t) + b * t);
+  }
+
+  static const uint32_t kMaxQuantized = 0x7FFF;
+
+  float sample_rate;
+  uint32_t num_frames;
+  float duration;
+  std::vector<Track> rotation_tracks;
+  std::vector<Key> keys;
+  std::vector<TranslationTrack> translation_tracks;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,143 @@
+#include "CompressedClipSampler.hpp"
+
+#include <algorithm>
+
+namespace {
+// As in ClipSampler.
+const int kMaxCursorSteps = 4;
+
+// Index of the last of count keys not after the sampled time, or 0 if
+// there is none, searching from cursor onwards first.
+template <class IsAfter>
+size_t Seek(size_t count, size_t cursor, IsAfter is_after) {
+  size_t last = count - 1;
+  if (cursor <= last && !is_after(cursor)) {
+    for (int step = 0; step <= kMaxCursorSteps; step++) {
+      if (cursor == last || is_after(cursor + 1))
+        return cursor;
+      cursor++;
+    }
+  }
+  // Binary search for the first key after, as std::upper_bound would.
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (is_after(mid))
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo == 0 ? 0 : lo - 1;
+}
+
+template <class T>
+std::vector<int> MapJoints(const std::vector<T>& tracks) {
+  std::vector<int> joint_tracks;
+  for (size_t i = 0; i < tracks.size(); i++) {
+    size_t joint = tracks[i].joint;
+    if (joint >= joint_tracks.size())
+      joint_tracks.resize(joint + 1, -1);
+    joint_tracks[joint] = static_cast<int>(i);
+  }
+  return joint_tracks;
+}
+
+int FindTrack(const std::vector<int>& joint_tracks, int joint) {
+  return size_t(joint) < joint_tracks.size() ? joint_tracks[joint] : -1;
+}
+}  // namespace
+
+namespace GLOO {
+CompressedClipSampler::CompressedClipSampler(const CompressedClip& clip)
+    : clip_(clip),
+      rotation_cursors_(clip.rotation_tracks.size(), 0),
+      translation_cursors_(clip.translation_tracks.size(), 0),
+      joint_rotation_tracks_(MapJoints(clip.rotation_tracks)),
+      joint_translation_tracks_(MapJoints(clip.translation_tracks)) {
+}
+
+void CompressedClipSampler::Sample(float time, Pose& pose) {
+  size_t num_joints = pose.GetNumJoints();
+  float frame = GetFrame(time);
+  for (size_t i = 0; i < clip_.rotation_tracks.size(); i++) {
+    int joint = clip_.rotation_tracks[i].joint;
+    if (size_t(joint) < num_joints)
+      pose.rotations[joint] = SampleRotation(i, frame);
+  }
+  for (size_t i = 0; i < clip_.translation_tracks.size(); i++) {
+    int joint = clip_.translation_tracks[i].joint;
+    if (!clip_.translation_tracks[i].times.empty() &&
+        size_t(joint) < num_joints) {
+      pose.translations[joint] = SampleTranslation(i, time);
+    }
+  }
+}
+
+void CompressedClipSampler::SampleSkinningMatrices(
+    float time,
+    const SkinningRig& rig,
+    std::vector<glm::mat4>& joint_matrices,
+    std::vector<glm::mat4>& skinning_matrices) {
+  float frame = GetFrame(time);
+  joint_matrices.resize(rig.GetNumJoints());
+  for (int joint : rig.joint_order) {
+    int rotation_track = FindTrack(joint_rotation_tracks_, joint);
+    int translation_track = FindTrack(joint_translation_tracks_, joint);
+    glm::quat rotation = rotation_track == -1
+                             ? glm::quat(1.0f, 0.0f, 0.0f, 0.0f)
+                             : SampleRotation(rotation_track, frame);
+    glm::vec3 translation =
+        translation_track == -1 ||
+                clip_.translation_tracks[translation_track].times.empty()
+            ? rig.rest_translations[joint]
+            : SampleTranslation(translation_track, time);
+    glm::mat4 local = MakeJointMatrix(rotation, translation);
+    int parent = rig.joint_parents[joint];
+    joint_matrices[joint] =
+        parent == -1 ? local : joint_matrices[parent] * local;
+  }
+  skinning_matrices.resize(rig.bind_matrices.size());
+  for (size_t b = 0; b < rig.bind_matrices.size(); b++) {
+    skinning_matrices[b] = joint_matrices[b + 1] * rig.bind_matrices[b];
+  }
+}
+
+float CompressedClipSampler::GetFrame(float time) const {
+  float last = float(clip_.num_frames) - 1.0f;
+  return std::min(std::max(time * clip_.sample_rate, 0.0f), last);
+}
+
+glm::quat CompressedClipSampler::SampleRotation(size_t track_index,
+                                                float frame) {
+  const CompressedClip::Track& track = clip_.rotation_tracks[track_index];
+  const CompressedClip::Key* keys = &clip_.keys[track.first_key];
+  if (track.num_keys == 1)
+    return CompressedClip::DecodeRotation(keys[0].rotation);
+
+  size_t& cursor = rotation_cursors_[track_index];
+  cursor = Seek(track.num_keys, cursor,
+                [keys, frame](size_t k) { return keys[k].frame > frame; });
+  const CompressedClip::Key& a = keys[cursor];
+  if (cursor + 1 == track.num_keys || frame <= a.frame)
+    return CompressedClip::DecodeRotation(a.rotation);
+  const CompressedClip::Key& b = keys[cursor + 1];
+  float t = (frame - a.frame) / float(b.frame - a.frame);
+  return CompressedClip::Interpolate(CompressedClip::DecodeRotation(a.rotation),
+                                     CompressedClip::DecodeRotation(b.rotation),
+                                     t);
+}
+
+glm::vec3 CompressedClipSampler::SampleTranslation(size_t track_index,
+                                                   float time) {
+  const TranslationTrack& track = clip_.translation_tracks[track_index];
+  const std::vector<float>& times = track.times;
+  size_t& cursor = translation_cursors_[track_index];
+  cursor = Seek(times.size(), cursor,
+                [&times, time](size_t k) { return times[k] > time; });
+  if (cursor + 1 == times.size() || time <= times[cursor])
+    return track.values[cursor];
+  float t = (time - times[cursor]) / (times[cursor + 1] - times[cursor]);
+  return glm::mix(track.values[cursor], track.values[cursor + 1], t);
+}
+}  // namespace GLOO
@@ -0,0 +1,48 @@
+#ifndef GLOO_COMPRESSED_CLIP_SAMPLER_H_
+#define GLOO_COMPRESSED_CLIP_SAMPLER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "CompressedClip.hpp"
+#include "Pose.hpp"
+#include "SkinningRig.hpp"
+
+namespace GLOO {
+// Decompresses a CompressedClip. Tracks keep cursors like ClipSampler's,
+// over their keyframes' frame numbers.
+class CompressedClipSampler {
+ public:
+  // The clip must outlive the sampler and keep its tracks.
+  explicit CompressedClipSampler(const CompressedClip& clip);
+
+  // Overwrites the animated joints of pose with the clip at time, which is
+  // clamped to the clip.
+  void Sample(float time, Pose& pose);
+  // Decompresses straight into skinning matrices, as
+  // SkinningRig::ComputeSkinningMatrices would compute them from Sample:
+  // each joint is decoded and composed with its parent in the same pass,
+  // without an intermediate pose. Joints without a track stay at rest.
+  void SampleSkinningMatrices(float time,
+                              const SkinningRig& rig,
+                              std::vector<glm::mat4>& joint_matrices,
+                              std::vector<glm::mat4>& skinning_matrices);
+
+ private:
+  // Fractional frame at time.
+  float GetFrame(float time) const;
+  glm::quat SampleRotation(size_t track_index, float frame);
+  glm::vec3 SampleTranslation(size_t track_index, float time);
+
+  const CompressedClip& clip_;
+  std::vector<size_t> rotation_cursors_;
+  std::vector<size_t> translation_cursors_;
+  // Track of each joint, or -1, for sampling in joint order.
+  std::vector<int> joint_rotation_tracks_;
+  std::vector<int> joint_translation_tracks_;
+};
+}  // namespace GLOO
+
+#endif
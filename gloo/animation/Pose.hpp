@@ -0,0 +1,27 @@
+#ifndef GLOO_POSE_H_
+#define GLOO_POSE_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace GLOO {
+// Transform of every joint of a skeleton relative to its parent, indexed
+// like the skeleton's joints. Rotations and translations are kept in
+// separate arrays, so that samplers only touch what their tracks animate.
+struct Pose {
+  void Resize(size_t num_joints) {
+    rotations.resize(num_joints);
+    translations.resize(num_joints);
+  }
+  size_t GetNumJoints() const {
+    return rotations.size();
+  }
+
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec3> translations;
+};
+}  // namespace GLOO
+
+#endif
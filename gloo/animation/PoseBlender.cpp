@@ -0,0 +1,220 @@
+#include "PoseBlender.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+using GLOO::JointMask;
+using GLOO::PoseBuffer;
+
+const size_t kLaneWidth = PoseBuffer::kLaneWidth;
+
+void CheckSizes(const PoseBuffer& a,
+                const PoseBuffer& b,
+                const JointMask* mask) {
+  if (a.GetNumJoints() != b.GetNumJoints() ||
+      (mask != nullptr && mask->weights.size() != a.GetPaddedSize())) {
+    throw std::runtime_error("Blended poses have different joints!");
+  }
+}
+
+// One block of lanes of a pose, copied out of the pose's arrays. The lane
+// loops below work on these local arrays, which the compiler knows alias
+// nothing else, so that they vectorize without run-time overlap checks
+// between the pose's many arrays.
+struct LaneBlock {
+  void Load(const PoseBuffer& pose, size_t first) {
+    for (int c = 0; c < 4; c++) {
+      for (size_t k = 0; k < kLaneWidth; k++) {
+        rotation[c][k] = pose.rotation[c][first + k];
+      }
+    }
+    for (int c = 0; c < 3; c++) {
+      for (size_t k = 0; k < kLaneWidth; k++) {
+        translation[c][k] = pose.translation[c][first + k];
+      }
+    }
+  }
+  void Store(size_t first, PoseBuffer& pose) const {
+    for (int c = 0; c < 4; c++) {
+      for (size_t k = 0; k < kLaneWidth; k++) {
+        pose.rotation[c][first + k] = rotation[c][k];
+      }
+    }
+    for (int c = 0; c < 3; c++) {
+      for (size_t k = 0; k < kLaneWidth; k++) {
+        pose.translation[c][first + k] = translation[c][k];
+      }
+    }
+  }
+
+  // x, y, z and w.
+  float rotation[4][kLaneWidth];
+  float translation[3][kLaneWidth];
+};
+
+void LoadWeights(float weight,
+                 const JointMask* mask,
+                 size_t first,
+                 float weights[kLaneWidth]) {
+  for (size_t k = 0; k < kLaneWidth; k++) {
+    weights[k] = mask == nullptr ? weight : weight * mask->weights[first + k];
+  }
+}
+
+// Nlerp or Slerp over all lanes. For slerp, the weight is corrected as in
+// Zeux's "Approximating slerp": a cubic in t whose coefficients follow the
+// cosine of the angle, fitted to slerp's path.
+template <bool kSlerp>
+void Interpolate(const PoseBuffer& other,
+                 float weight,
+                 const JointMask* mask,
+                 PoseBuffer& pose) {
+  CheckSizes(pose, other, mask);
+  LaneBlock a, b;
+  float w[kLaneWidth];
+  for (size_t first = 0; first < pose.GetPaddedSize(); first += kLaneWidth) {
+    a.Load(pose, first);
+    b.Load(other, first);
+    LoadWeights(weight, mask, first, w);
+    for (size_t k = 0; k < kLaneWidth; k++) {
+      float ax = a.rotation[0][k], ay = a.rotation[1][k],
+            az = a.rotation[2][k], aw = a.rotation[3][k];
+      float bx = b.rotation[0][k], by = b.rotation[1][k],
+            bz = b.rotation[2][k], bw = b.rotation[3][k];
+      float d = ax * bx + ay * by + az * bz + aw * bw;
+      float t = w[k];
+      if (kSlerp) {
+        float c = std::abs(d);
+        float k0 = 1.0904f + c * (-3.2452f + c * (3.55645f - c * 1.43519f));
+        float k1 = 0.848013f + c * (-1.06021f + c * 0.215638f);
+        float correction = k0 * (t - 0.5f) * (t - 0.5f) + k1;
+        t = t + t * (t - 0.5f) * (t - 1.0f) * correction;
+      }
+      float s = d < 0.0f ? -t : t;
+      float u = 1.0f - t;
+      float x = u * ax + s * bx;
+      float y = u * ay + s * by;
+      float z = u * az + s * bz;
+      float r = u * aw + s * bw;
+      float inv_length = 1.0f / std::sqrt(x * x + y * y + z * z + r * r);
+      a.rotation[0][k] = x * inv_length;
+      a.rotation[1][k] = y * inv_length;
+      a.rotation[2][k] = z * inv_length;
+      a.rotation[3][k] = r * inv_length;
+    }
+    for (int c = 0; c < 3; c++) {
+      for (size_t k = 0; k < kLaneWidth; k++) {
+        float delta = b.translation[c][k] - a.translation[c][k];
+        a.translation[c][k] += delta * w[k];
+      }
+    }
+    a.Store(first, pose);
+  }
+}
+}  // namespace
+
+namespace GLOO {
+void PoseBlender::Nlerp(const PoseBuffer& other,
+                        float weight,
+                        const JointMask* mask,
+                        PoseBuffer& pose) {
+  Interpolate<false>(other, weight, mask, pose);
+}
+
+void PoseBlender::Slerp(const PoseBuffer& other,
+                        float weight,
+                        const JointMask* mask,
+                        PoseBuffer& pose) {
+  Interpolate<true>(other, weight, mask, pose);
+}
+
+void PoseBlender::Add(const PoseBuffer& difference,
+                      float weight,
+                      const JointMask* mask,
+                      PoseBuffer& pose) {
+  CheckSizes(pose, difference, mask);
+  LaneBlock a, b;
+  float w[kLaneWidth];
+  for (size_t first = 0; first < pose.GetPaddedSize(); first += kLaneWidth) {
+    a.Load(pose, first);
+    b.Load(difference, first);
+    LoadWeights(weight, mask, first, w);
+    for (size_t k = 0; k < kLaneWidth; k++) {
+      // The difference nlerped from identity by the weight.
+      float t = w[k];
+      float s = b.rotation[3][k] < 0.0f ? -t : t;
+      float x = s * b.rotation[0][k];
+      float y = s * b.rotation[1][k];
+      float z = s * b.rotation[2][k];
+      float r = 1.0f - t + s * b.rotation[3][k];
+      float inv_length = 1.0f / std::sqrt(x * x + y * y + z * z + r * r);
+      x *= inv_length;
+      y *= inv_length;
+      z *= inv_length;
+      r *= inv_length;
+      // Then pose * difference.
+      float ax = a.rotation[0][k], ay = a.rotation[1][k],
+            az = a.rotation[2][k], aw = a.rotation[3][k];
+      a.rotation[0][k] = aw * x + ax * r + ay * z - az * y;
+      a.rotation[1][k] = aw * y - ax * z + ay * r + az * x;
+      a.rotation[2][k] = aw * z + ax * y - ay * x + az * r;
+      a.rotation[3][k] = aw * r - ax * x - ay * y - az * z;
+    }
+    for (int c = 0; c < 3; c++) {
+      for (size_t k = 0; k < kLaneWidth; k++) {
+        a.translation[c][k] += b.translation[c][k] * w[k];
+      }
+    }
+    a.Store(first, pose);
+  }
+}
+
+void PoseBlender::MakeAdditive(const PoseBuffer& pose,
+                               const PoseBuffer& reference,
+                               PoseBuffer& difference) {
+  CheckSizes(pose, reference, nullptr);
+  difference.Resize(pose.GetNumJoints());
+  LaneBlock a, b, d;
+  for (size_t first = 0; first < pose.GetPaddedSize(); first += kLaneWidth) {
+    a.Load(reference, first);
+    b.Load(pose, first);
+    for (size_t k = 0; k < kLaneWidth; k++) {
+      // conjugate(reference) * pose.
+      float ax = a.rotation[0][k], ay = a.rotation[1][k],
+            az = a.rotation[2][k], aw = a.rotation[3][k];
+      float bx = b.rotation[0][k], by = b.rotation[1][k],
+            bz = b.rotation[2][k], bw = b.rotation[3][k];
+      d.rotation[0][k] = aw * bx - ax * bw - ay * bz + az * by;
+      d.rotation[1][k] = aw * by + ax * bz - ay * bw - az * bx;
+      d.rotation[2][k] = aw * bz - ax * by + ay * bx - az * bw;
+      d.rotation[3][k] = aw * bw + ax * bx + ay * by + az * bz;
+    }
+    for (int c = 0; c < 3; c++) {
+      for (size_t k = 0; k < kLaneWidth; k++) {
+        d.translation[c][k] = b.translation[c][k] - a.translation[c][k];
+      }
+    }
+    d.Store(first, difference);
+  }
+}
+
+void PoseBlender::Evaluate(const PoseBuffer& base,
+                           const std::vector<Layer>& layers,
+                           PoseBuffer& result) {
+  result = base;
+  for (const Layer& layer : layers) {
+    switch (layer.mode) {
+      case Mode::Nlerp:
+        Nlerp(*layer.pose, layer.weight, layer.mask, result);
+        break;
+      case Mode::Slerp:
+        Slerp(*layer.pose, layer.weight, layer.mask, result);
+        break;
+      case Mode::Additive:
+        Add(*layer.pose, layer.weight, layer.mask, result);
+        break;
+    }
+  }
+}
+}  // namespace GLOO
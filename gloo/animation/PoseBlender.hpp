@@ -0,0 +1,70 @@
+#ifndef GLOO_POSE_BLENDER_H_
+#define GLOO_POSE_BLENDER_H_
+
+#include <vector>
+
+#include "PoseBuffer.hpp"
+
+namespace GLOO {
+// Blends poses in PoseBuffer layout, e.g. locomotion clips with additive
+// upper body layers. Every operation runs over all lanes, padding
+// included, as plain loops without branches that vectorize without
+// intrinsics: 4 joints per instruction with SSE, and 8 with AVX, e.g. with
+// GLOO_NATIVE_ARCH. A layer's weight, in [0, 1], is scaled per joint by its
+// mask if it has one. Poses blended together must have the same number of
+// joints; the functions throw otherwise.
+class PoseBlender {
+ public:
+  enum class Mode { Nlerp, Slerp, Additive };
+
+  struct Layer {
+    Layer(const PoseBuffer& pose,
+          Mode mode,
+          float weight,
+          const JointMask* mask = nullptr)
+        : pose(&pose), mode(mode), weight(weight), mask(mask) {
+    }
+
+    // A difference from MakeAdditive if mode is Additive.
+    const PoseBuffer* pose;
+    Mode mode;
+    float weight;
+    // Weight 1 on all joints if null.
+    const JointMask* mask;
+  };
+
+  // Moves pose towards other by weight: rotations by normalized lerp along
+  // the shorter arc, translations by lerp.
+  static void Nlerp(const PoseBuffer& other,
+                    float weight,
+                    const JointMask* mask,
+                    PoseBuffer& pose);
+  // As Nlerp, with the weight corrected by a polynomial in the angle
+  // between the rotations so that they follow slerp to within 0.05
+  // degrees, without trigonometry.
+  static void Slerp(const PoseBuffer& other,
+                    float weight,
+                    const JointMask* mask,
+                    PoseBuffer& pose);
+  // Applies a difference from MakeAdditive on top of pose: rotations are
+  // followed by the difference's, nlerped from identity by weight, and
+  // translations offset by the difference's times weight.
+  static void Add(const PoseBuffer& difference,
+                  float weight,
+                  const JointMask* mask,
+                  PoseBuffer& pose);
+  // Sets difference to what takes reference to pose, joint by joint.
+  static void MakeAdditive(const PoseBuffer& pose,
+                           const PoseBuffer& reference,
+                           PoseBuffer& difference);
+
+  // Sets result to base with the layers applied in order. The hierarchy is
+  // left to a single pass afterwards, e.g. with
+  // SkinningRig::ComputeSkinningMatrices.
+  static void Evaluate(const PoseBuffer& base,
+                       const std::vector<Layer>& layers,
+                       PoseBuffer& result);
+};
+}  // namespace GLOO
+
+#endif
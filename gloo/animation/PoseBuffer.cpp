@@ -0,0 +1,76 @@
+#include "PoseBuffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace GLOO {
+const size_t PoseBuffer::kLaneWidth;
+
+void PoseBuffer::Resize(size_t new_num_joints) {
+  // Dropped joints become padding, so they are reset to identity while
+  // they are still within the arrays.
+  for (size_t j = new_num_joints; j < num_joints; j++) {
+    SetJoint(j, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.0f));
+  }
+  // Resizing the padding keeps its identity joints identity.
+  size_t padded_size = GetPaddedSize(new_num_joints);
+  for (int c = 0; c < 3; c++) {
+    rotation[c].resize(padded_size, 0.0f);
+    translation[c].resize(padded_size, 0.0f);
+  }
+  rotation[3].resize(padded_size, 1.0f);
+  num_joints = new_num_joints;
+}
+
+void PoseBuffer::SetJoint(size_t joint,
+                          const glm::quat& r,
+                          const glm::vec3& t) {
+  rotation[0][joint] = r.x;
+  rotation[1][joint] = r.y;
+  rotation[2][joint] = r.z;
+  rotation[3][joint] = r.w;
+  for (int c = 0; c < 3; c++) {
+    translation[c][joint] = t[c];
+  }
+}
+
+void PoseBuffer::CopyFrom(const Pose& pose) {
+  Resize(pose.GetNumJoints());
+  for (size_t j = 0; j < num_joints; j++) {
+    SetJoint(j, pose.rotations[j], pose.translations[j]);
+  }
+}
+
+void PoseBuffer::CopyTo(Pose& pose) const {
+  pose.Resize(num_joints);
+  for (size_t j = 0; j < num_joints; j++) {
+    pose.rotations[j] = GetRotation(j);
+    pose.translations[j] = GetTranslation(j);
+  }
+}
+
+JointMask::JointMask(size_t num_joints, float weight)
+    : weights(PoseBuffer::GetPaddedSize(num_joints), 0.0f) {
+  std::fill(weights.begin(), weights.begin() + num_joints, weight);
+}
+
+JointMask JointMask::FromSubtree(const std::vector<int>& joint_parents,
+                                 int root) {
+  size_t num_joints = joint_parents.size();
+  JointMask mask(num_joints, 0.0f);
+  for (size_t j = 0; j < num_joints; j++) {
+    size_t depth = 0;
+    int joint = static_cast<int>(j);
+    while (joint != -1 && joint != root) {
+      joint = joint_parents[joint];
+      if (joint < -1 || joint >= static_cast<int>(num_joints) ||
+          ++depth > num_joints) {
+        throw std::runtime_error("Joint parents do not form a forest!");
+      }
+    }
+    if (joint == root)
+      mask.weights[j] = 1.0f;
+  }
+  return mask;
+}
+}  // namespace GLOO
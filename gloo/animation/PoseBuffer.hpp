@@ -0,0 +1,74 @@
+#ifndef GLOO_POSE_BUFFER_H_
+#define GLOO_POSE_BUFFER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Pose.hpp"
+
+namespace GLOO {
+// A pose in structure-of-arrays layout: each component of the joints'
+// rotations and translations has an array of its own, so that PoseBlender
+// processes kLaneWidth joints per instruction from plain loops. Joints are
+// indexed like Pose's, i.e. like SkeletonNode's. The arrays are padded
+// with identity joints to a multiple of kLaneWidth, so that the loops need
+// no remainder.
+struct PoseBuffer {
+  // Joints per 256-bit register.
+  static const size_t kLaneWidth = 8;
+
+  static size_t GetPaddedSize(size_t num_joints) {
+    return (num_joints + kLaneWidth - 1) / kLaneWidth * kLaneWidth;
+  }
+
+  PoseBuffer() : num_joints(0) {
+  }
+
+  // Added joints are identity.
+  void Resize(size_t new_num_joints);
+  size_t GetNumJoints() const {
+    return num_joints;
+  }
+  size_t GetPaddedSize() const {
+    return rotation[3].size();
+  }
+
+  glm::quat GetRotation(size_t joint) const {
+    return glm::quat(rotation[3][joint], rotation[0][joint],
+                     rotation[1][joint], rotation[2][joint]);
+  }
+  glm::vec3 GetTranslation(size_t joint) const {
+    return glm::vec3(translation[0][joint], translation[1][joint],
+                     translation[2][joint]);
+  }
+  void SetJoint(size_t joint, const glm::quat& r, const glm::vec3& t);
+
+  // Conversions from and to the layout samplers and SkeletonNode use.
+  void CopyFrom(const Pose& pose);
+  void CopyTo(Pose& pose) const;
+
+  size_t num_joints;
+  // x, y, z and w.
+  std::vector<float> rotation[4];
+  std::vector<float> translation[3];
+};
+
+// Per-joint weights of a blend layer, padded like PoseBuffer with zeros.
+struct JointMask {
+  JointMask() {
+  }
+  JointMask(size_t num_joints, float weight);
+
+  // Weight 1 for root and the joints below it and 0 for the rest, e.g. for
+  // an upper body layer. Throws if the parents do not form a forest.
+  static JointMask FromSubtree(const std::vector<int>& joint_parents,
+                               int root);
+
+  std::vector<float> weights;
+};
+}  // namespace GLOO
+
+#endif
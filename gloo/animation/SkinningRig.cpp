@@ -0,0 +1,92 @@
+#include "SkinningRig.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+glm::quat GetRotation(const GLOO::Pose& pose, int joint) {
+  return pose.rotations[joint];
+}
+glm::vec3 GetTranslation(const GLOO::Pose& pose, int joint) {
+  return pose.translations[joint];
+}
+glm::quat GetRotation(const GLOO::PoseBuffer& pose, int joint) {
+  return pose.GetRotation(joint);
+}
+glm::vec3 GetTranslation(const GLOO::PoseBuffer& pose, int joint) {
+  return pose.GetTranslation(joint);
+}
+
+template <class P>
+void ComputeMatrices(const GLOO::SkinningRig& rig,
+                     const P& pose,
+                     std::vector<glm::mat4>& joint_matrices,
+                     std::vector<glm::mat4>& skinning_matrices) {
+  joint_matrices.resize(rig.GetNumJoints());
+  for (int joint : rig.joint_order) {
+    glm::mat4 local = GLOO::MakeJointMatrix(GetRotation(pose, joint),
+                                            GetTranslation(pose, joint));
+    int parent = rig.joint_parents[joint];
+    joint_matrices[joint] =
+        parent == -1 ? local : joint_matrices[parent] * local;
+  }
+  skinning_matrices.resize(rig.bind_matrices.size());
+  for (size_t b = 0; b < rig.bind_matrices.size(); b++) {
+    skinning_matrices[b] = joint_matrices[b + 1] * rig.bind_matrices[b];
+  }
+}
+}  // namespace
+
+namespace GLOO {
+SkinningRig SkinningRig::FromCharacter(const CharacterView& character) {
+  SkinningRig rig;
+  rig.joint_parents.assign(character.joint_parents.begin(),
+                           character.joint_parents.end());
+  rig.rest_translations.assign(character.joint_positions.begin(),
+                               character.joint_positions.end());
+  rig.bind_matrices.assign(character.bind_matrices.begin(),
+                           character.bind_matrices.end());
+
+  // Sorting by depth puts parents first.
+  size_t num_joints = rig.joint_parents.size();
+  std::vector<size_t> depths(num_joints);
+  for (size_t j = 0; j < num_joints; j++) {
+    size_t depth = 0;
+    for (int parent = rig.joint_parents[j]; parent != -1;
+         parent = rig.joint_parents[parent]) {
+      if (parent < -1 || size_t(parent) >= num_joints || ++depth > num_joints)
+        throw std::runtime_error("Joint parents do not form a forest!");
+    }
+    depths[j] = depth;
+  }
+  rig.joint_order.resize(num_joints);
+  for (size_t j = 0; j < num_joints; j++) {
+    rig.joint_order[j] = static_cast<int>(j);
+  }
+  std::stable_sort(rig.joint_order.begin(), rig.joint_order.end(),
+                   [&depths](int a, int b) { return depths[a] < depths[b]; });
+  return rig;
+}
+
+void SkinningRig::GetRestPose(Pose& pose) const {
+  pose.Resize(GetNumJoints());
+  std::fill(pose.rotations.begin(), pose.rotations.end(),
+            glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+  std::copy(rest_translations.begin(), rest_translations.end(),
+            pose.translations.begin());
+}
+
+void SkinningRig::ComputeSkinningMatrices(
+    const Pose& pose,
+    std::vector<glm::mat4>& joint_matrices,
+    std::vector<glm::mat4>& skinning_matrices) const {
+  ComputeMatrices(*this, pose, joint_matrices, skinning_matrices);
+}
+
+void SkinningRig::ComputeSkinningMatrices(
+    const PoseBuffer& pose,
+    std::vector<glm::mat4>& joint_matrices,
+    std::vector<glm::mat4>& skinning_matrices) const {
+  ComputeMatrices(*this, pose, joint_matrices, skinning_matrices);
+}
+}  // namespace GLOO
@@ -0,0 +1,53 @@
+#ifndef GLOO_SKINNING_RIG_H_
+#define GLOO_SKINNING_RIG_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gloo/CharacterData.hpp"
+#include "Pose.hpp"
+#include "PoseBuffer.hpp"
+
+namespace GLOO {
+// The part of a character that turns joint poses into skinning matrices,
+// without the scene graph.
+struct SkinningRig {
+  // Parent of each joint, or -1 for roots.
+  std::vector<int> joint_parents;
+  // Joint indices in an order where parents precede their children.
+  std::vector<int> joint_order;
+  // Offsets of the joints from their parents in the bind pose.
+  std::vector<glm::vec3> rest_translations;
+  // Inverse bind-pose matrix of bone j, which belongs to joint j + 1.
+  std::vector<glm::mat4> bind_matrices;
+
+  // Throws if the joint parents do not form a forest.
+  static SkinningRig FromCharacter(const CharacterView& character);
+
+  size_t GetNumJoints() const {
+    return joint_parents.size();
+  }
+  // Rest translations without rotation.
+  void GetRestPose(Pose& pose) const;
+  // The transform hierarchy pass: joint_matrices receives the joints in
+  // model space, and skinning_matrices the bones' bind pose to posed
+  // transforms, as SkeletonNode's skinning consumes them.
+  void ComputeSkinningMatrices(const Pose& pose,
+                               std::vector<glm::mat4>& joint_matrices,
+                               std::vector<glm::mat4>& skinning_matrices) const;
+  // The same from a blended pose.
+  void ComputeSkinningMatrices(const PoseBuffer& pose,
+                               std::vector<glm::mat4>& joint_matrices,
+                               std::vector<glm::mat4>& skinning_matrices) const;
+};
+
+// Translation by t after rotation by q, as Transform composes them.
+inline glm::mat4 MakeJointMatrix(const glm::quat& q, const glm::vec3& t) {
+  glm::mat4 m = glm::mat4_cast(q);
+  m[3] = glm::vec4(t, 1.0f);
+  return m;
+}
+}  // namespace GLOO
+
+#endif
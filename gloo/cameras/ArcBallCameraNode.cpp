@@ -9,6 +9,7 @@
 #include "gloo/components/ShadingComponent.hpp"
 #include "gloo/components/MaterialComponent.hpp"
 #include "gloo/InputManager.hpp"
+#include "gloo/shaders/ShaderRegistry.hpp"
 #include "gloo/shaders/SimpleShader.hpp"
 #include "gloo/VertexObject.hpp"
 
@@ -178,7 +179,7 @@ void ArcBallCameraNode::PlotAxes() {
   auto y_line = std::make_shared<VertexObject>();
   auto z_line = std::make_shared<VertexObject>();
 
-  auto line_shader = std::make_shared<SimpleShader>();
+  auto line_shader = ShaderRegistry::Get<SimpleShader>();
 
   auto indices = IndexArray();
   indices.push_back(0);
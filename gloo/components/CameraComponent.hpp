@@ -14,6 +14,12 @@ class CameraComponent : public ComponentBase {
   void SetAspectRatio(float aspect_ratio) {
     aspect_ratio_ = aspect_ratio;
   }
+  float GetNearPlane() const {
+    return z_near_;
+  }
+  float GetFarPlane() const {
+    return z_far_;
+  }
   void SetViewMatrix(std::unique_ptr<glm::mat4> V) {
     V_ = std::move(V);
   }
@@ -23,19 +23,32 @@ void RenderingComponent::SetDrawRange(int start_index, int num_indices) {
 }
 
 void RenderingComponent::Render() const {
+  size_t start_index, num_indices;
+  GetDrawRange(start_index, num_indices);
+  vertex_obj_->GetVertexArray().Render(start_index, num_indices);
+}
+
+void RenderingComponent::Draw() const {
+  size_t start_index, num_indices;
+  GetDrawRange(start_index, num_indices);
+  vertex_obj_->GetVertexArray().Draw(start_index, num_indices);
+}
+
+void RenderingComponent::GetDrawRange(size_t& start_index,
+                                      size_t& num_indices) const {
   if (vertex_obj_ == nullptr) {
     throw std::runtime_error(
         "Rendering component has no vertex object attached!");
   }
   if (start_index_ >= 0 && num_indices_ >= 0) {
-    vertex_obj_->GetVertexArray().Render(static_cast<size_t>(start_index_),
-                                         static_cast<size_t>(num_indices_));
+    start_index = static_cast<size_t>(start_index_);
+    num_indices = static_cast<size_t>(num_indices_);
   } else {
+    start_index = 0;
     if (vertex_obj_->HasIndices())
-      vertex_obj_->GetVertexArray().Render(0, vertex_obj_->GetIndices().size());
+      num_indices = vertex_obj_->GetIndices().size();
     else
-      vertex_obj_->GetVertexArray().Render(0,
-                                           vertex_obj_->GetPositions().size());
+      num_indices = vertex_obj_->GetPositions().size();
   }
 }
 
@@ -16,10 +16,18 @@ class RenderingComponent : public ComponentBase {
   VertexObject* GetVertexObjectPtr() {
     return vertex_obj_.get();
   }
+  const VertexObject* GetVertexObjectPtr() const {
+    return vertex_obj_.get();
+  }
 
   void Render() const;
+  // Like Render, but expects the caller to have bound the vertex array and
+  // set its polygon mode.
+  void Draw() const;
 
  private:
+  void GetDrawRange(size_t& start_index, size_t& num_indices) const;
+
   std::shared_ptr<VertexObject> vertex_obj_;
   int start_index_;
   int num_indices_;
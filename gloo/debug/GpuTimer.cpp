@@ -0,0 +1,49 @@
+#include "GpuTimer.hpp"
+
+#include "Profiler.hpp"
+#include "gloo/utils.hpp"
+
+namespace GLOO {
+const size_t GpuTimer::kNumQueries;
+
+GpuTimer::GpuTimer(const std::string& name)
+    : name_(name), oldest_(0), num_pending_(0), active_(false) {
+  GL_CHECK(glGenQueries(kNumQueries, queries_));
+}
+
+GpuTimer::~GpuTimer() {
+  GL_CHECK(glDeleteQueries(kNumQueries, queries_));
+}
+
+void GpuTimer::Begin() {
+  CollectResults();
+  active_ = num_pending_ < kNumQueries;
+  if (active_) {
+    GLuint query = queries_[(oldest_ + num_pending_) % kNumQueries];
+    GL_CHECK(glBeginQuery(GL_TIME_ELAPSED, query));
+  }
+}
+
+void GpuTimer::End() {
+  if (!active_)
+    return;
+  GL_CHECK(glEndQuery(GL_TIME_ELAPSED));
+  num_pending_++;
+  active_ = false;
+}
+
+void GpuTimer::CollectResults() {
+  while (num_pending_ > 0) {
+    GLuint query = queries_[oldest_];
+    GLint available = 0;
+    GL_CHECK(glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available));
+    if (!available)
+      break;
+    GLuint64 elapsed_ns = 0;
+    GL_CHECK(glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns));
+    Profiler::GetInstance().Record(name_, true, elapsed_ns * 1e-6f);
+    oldest_ = (oldest_ + 1) % kNumQueries;
+    num_pending_--;
+  }
+}
+}  // namespace GLOO
@@ -0,0 +1,41 @@
+#ifndef GLOO_GPU_TIMER_H_
+#define GLOO_GPU_TIMER_H_
+
+#include <string>
+
+#include <glad/glad.h>
+
+namespace GLOO {
+// Measures GPU time of the commands between Begin and End with
+// GL_TIME_ELAPSED queries. Results are only collected once the GPU reports
+// them available, a few frames later, so timing never stalls the pipeline.
+// Finished measurements go to the Profiler under the timer's name. Only one
+// timer may be between Begin and End at a time.
+class GpuTimer {
+ public:
+  explicit GpuTimer(const std::string& name);
+  ~GpuTimer();
+
+  GpuTimer(const GpuTimer&) = delete;
+  GpuTimer& operator=(const GpuTimer&) = delete;
+
+  void Begin();
+  void End();
+
+ private:
+  // Records every query whose result has arrived, oldest first.
+  void CollectResults();
+
+  static const size_t kNumQueries = 4;
+
+  std::string name_;
+  GLuint queries_[kNumQueries];
+  size_t oldest_;
+  size_t num_pending_;
+  // Whether the current Begin started a query; false when all queries were
+  // still in flight and the frame goes unmeasured.
+  bool active_;
+};
+}  // namespace GLOO
+
+#endif
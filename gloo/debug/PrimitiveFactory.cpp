@@ -1,42 +1,82 @@
 #include "PrimitiveFactory.hpp"
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 #include "gloo/utils.hpp"
+#include "gloo/AssetRegistry.hpp"
+
+namespace {
+GLOO::AssetRegistry<GLOO::VertexObject>& GetPrimitiveRegistry() {
+  static GLOO::AssetRegistry<GLOO::VertexObject> registry;
+  return registry;
+}
+
+// Exact, unlike std::to_string, so that nearby sizes get separate meshes.
+std::string ToKey(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return std::to_string(bits);
+}
+}  // namespace
 
 namespace GLOO {
 std::unique_ptr<VertexObject> PrimitiveFactory::CreateSphere(float r,
                                                              size_t slices,
                                                              size_t stacks) {
-  auto positions = make_unique<PositionArray>();
-  auto normals = make_unique<NormalArray>();
-  auto indices = make_unique<IndexArray>();
+  // Rings of slices vertices each, from the north pole (theta = 0) down to
+  // the south pole (theta = pi). The arrays are sized up front and written
+  // in place, with one sine and cosine per ring and per slice rather than
+  // per vertex.
+  size_t num_rings = stacks + 1;
+  auto positions = make_unique<PositionArray>(num_rings * slices);
+  auto normals = make_unique<NormalArray>(num_rings * slices);
+  auto indices = make_unique<IndexArray>(stacks * slices * 6);
 
   float phi_step = kPi * 2 / slices;
   float theta_step = kPi / stacks;
+  std::vector<float> cos_phi(slices);
+  std::vector<float> sin_phi(slices);
+  for (size_t hi = 0; hi < slices; hi++) {
+    cos_phi[hi] = cosf(hi * phi_step);
+    sin_phi[hi] = sinf(hi * phi_step);
+  }
 
-  for (size_t vi = 0; vi < stacks; vi++) {  // vertical loop
+  glm::vec3* position = positions->data();
+  glm::vec3* normal = normals->data();
+  for (size_t vi = 0; vi < num_rings; vi++) {  // vertical loop
     float theta = vi * theta_step;
-    float z = r * cosf(theta);
+    float sin_theta = sinf(theta);
+    float cos_theta = cosf(theta);
     for (size_t hi = 0; hi < slices; hi++) {  // horizontal loop
-      float phi = hi * phi_step;
-      glm::vec3 p(r * cosf(phi) * sinf(theta), r * sinf(phi) * sinf(theta), z);
-      positions->push_back(p);
-      normals->push_back(glm::normalize(p));
+      glm::vec3 n(cos_phi[hi] * sin_theta, sin_phi[hi] * sin_theta, cos_theta);
+      *position++ = r * n;
+      *normal++ = n;
     }
   }
 
-  for (size_t vi = 0; vi < stacks; vi++)
+  unsigned int* index = indices->data();
+  for (size_t vi = 0; vi < stacks; vi++) {
     for (size_t hi = 0; hi < slices; hi++) {
+      // The last slice closes the ring.
+      size_t next = hi + 1 == slices ? 0 : hi + 1;
       auto t1 = (unsigned int)(vi * slices + hi);
-      auto t2 = (unsigned int)(vi * slices + hi + 1);
-      auto t3 = (unsigned int)((vi + 1) * slices + hi + 1);
+      auto t2 = (unsigned int)(vi * slices + next);
+      auto t3 = (unsigned int)((vi + 1) * slices + next);
       auto t4 = (unsigned int)((vi + 1) * slices + hi);
-      indices->insert(indices->end(), {t1, t2, t3});
-      indices->insert(indices->end(), {t1, t3, t4});
+      index[0] = t1;
+      index[1] = t2;
+      index[2] = t3;
+      index[3] = t1;
+      index[4] = t3;
+      index[5] = t4;
+      index += 6;
     }
+  }
 
-  auto obj = make_unique<VertexObject>();
+  auto obj = make_unique<VertexObject>(VertexLayout::Interleaved);
   obj->UpdatePositions(std::move(positions));
   obj->UpdateNormals(std::move(normals));
   obj->UpdateIndices(std::move(indices));
@@ -45,42 +85,33 @@ std::unique_ptr<VertexObject> PrimitiveFactory::CreateSphere(float r,
 
 std::unique_ptr<VertexObject>
 PrimitiveFactory::CreateCylinder(float r, float h, size_t num_sides) {
-  auto positions = make_unique<PositionArray>();
-  auto normals = make_unique<NormalArray>();
-  auto indices = make_unique<IndexArray>();
+  auto positions = make_unique<PositionArray>(2 * num_sides);
+  auto normals = make_unique<NormalArray>(2 * num_sides);
+  auto indices = make_unique<IndexArray>(6 * num_sides);
 
   float step = 2 * kPi / num_sides;
 
   for (size_t face = 0; face < num_sides; face++) {
-    float lx = r * cosf(face * step);
-    float lz = r * sinf(face * step);
-    positions->emplace_back(lx, 0.0f, lz);
-    positions->emplace_back(lx, h, lz);
-
-    normals->emplace_back(cosf(face * step), 0.0f, sinf(face * step));
-    normals->emplace_back(cosf(face * step), 0.0f, sinf(face * step));
+    float c = cosf(face * step);
+    float s = sinf(face * step);
+    (*positions)[2 * face] = glm::vec3(r * c, 0.0f, r * s);
+    (*positions)[2 * face + 1] = glm::vec3(r * c, h, r * s);
+    (*normals)[2 * face] = glm::vec3(c, 0.0f, s);
+    (*normals)[2 * face + 1] = glm::vec3(c, 0.0f, s);
   }
+  unsigned int* index = indices->data();
   for (size_t face = 0; face < num_sides; ++face) {
     unsigned int i1 = (unsigned int)face * 2;
-    unsigned int i2;
-    if (face == num_sides - 1) {
-      i2 = 1;
-    } else {
-      i2 = i1 + 3;
-    }
-    unsigned int i3 = i1 + 1;
-
-    indices->insert(indices->end(), {i1, i2, i3});
-    if (face == num_sides - 1) {
-      i2 = 0;
-      i3 = 1;
-    } else {
-      i2 = i1 + 2;
-      i3 = i1 + 3;
-    }
-    indices->insert(indices->end(), {i1, i2, i3});
+    bool last = face == num_sides - 1;
+    index[0] = i1;
+    index[1] = last ? 1 : i1 + 3;
+    index[2] = i1 + 1;
+    index[3] = i1;
+    index[4] = last ? 0 : i1 + 2;
+    index[5] = last ? 1 : i1 + 3;
+    index += 6;
   }
-  auto obj = make_unique<VertexObject>();
+  auto obj = make_unique<VertexObject>(VertexLayout::Interleaved);
   obj->UpdatePositions(std::move(positions));
   obj->UpdateNormals(std::move(normals));
   obj->UpdateIndices(std::move(indices));
@@ -108,7 +139,7 @@ std::unique_ptr<VertexObject> PrimitiveFactory::CreateQuad() {
   tex_coords->emplace_back(1.0f, 1.0f);
   tex_coords->emplace_back(0.0f, 1.0f);
 
-  auto obj = make_unique<VertexObject>();
+  auto obj = make_unique<VertexObject>(VertexLayout::Interleaved);
   obj->UpdatePositions(std::move(positions));
   obj->UpdateNormals(std::move(normals));
   obj->UpdateIndices(std::move(indices));
@@ -124,9 +155,35 @@ std::unique_ptr<VertexObject> PrimitiveFactory::CreateLineSegment(
   positions->push_back(p);
   positions->push_back(q);
 
-  auto obj = make_unique<VertexObject>();
+  auto obj = make_unique<VertexObject>(VertexLayout::Interleaved);
   obj->UpdatePositions(std::move(positions));
   return obj;
 }
 
+std::shared_ptr<VertexObject> PrimitiveFactory::GetSphere(float r,
+                                                          size_t slices,
+                                                          size_t stacks) {
+  std::string key = "sphere/" + ToKey(r) + "/" + std::to_string(slices) +
+                    "/" + std::to_string(stacks);
+  return GetPrimitiveRegistry().GetOrCreate(key, [=]() {
+    return std::shared_ptr<VertexObject>(CreateSphere(r, slices, stacks));
+  });
+}
+
+std::shared_ptr<VertexObject> PrimitiveFactory::GetCylinder(float r,
+                                                            float h,
+                                                            size_t num_sides) {
+  std::string key = "cylinder/" + ToKey(r) + "/" + ToKey(h) + "/" +
+                    std::to_string(num_sides);
+  return GetPrimitiveRegistry().GetOrCreate(key, [=]() {
+    return std::shared_ptr<VertexObject>(CreateCylinder(r, h, num_sides));
+  });
+}
+
+std::shared_ptr<VertexObject> PrimitiveFactory::GetQuad() {
+  return GetPrimitiveRegistry().GetOrCreate("quad", []() {
+    return std::shared_ptr<VertexObject>(CreateQuad());
+  });
+}
+
 }  // namespace GLOO
@@ -22,6 +22,18 @@ class PrimitiveFactory {
   // Create a line segment between p and q.
   static std::unique_ptr<VertexObject> CreateLineSegment(const glm::vec3& p,
                                                          const glm::vec3& q);
+
+  // Like the Create* methods above, but memoized by shape parameters:
+  // nodes drawing the same shape share one VertexObject, for as long as any
+  // of them holds it. Shared objects must not be modified, so meshes that
+  // get per-node data such as instances come from Create* instead.
+  static std::shared_ptr<VertexObject> GetSphere(float r,
+                                                 size_t slices,
+                                                 size_t stacks);
+  static std::shared_ptr<VertexObject> GetCylinder(float r,
+                                                   float h,
+                                                   size_t num_sides);
+  static std::shared_ptr<VertexObject> GetQuad();
 };
 }  // namespace GLOO
 
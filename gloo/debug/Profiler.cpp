@@ -0,0 +1,43 @@
+#include "Profiler.hpp"
+
+namespace GLOO {
+const size_t Profiler::kHistorySize;
+
+float TimingSeries::GetLatest() const {
+  return samples[(next_sample + samples.size() - 1) % samples.size()];
+}
+
+float TimingSeries::GetAverage() const {
+  float sum = 0.0f;
+  for (float sample : samples) {
+    sum += sample;
+  }
+  return sum / samples.size();
+}
+
+void Profiler::Record(const std::string& name, bool gpu, float milliseconds) {
+  auto it = series_indices_.find(name);
+  if (it == series_indices_.end()) {
+    TimingSeries series;
+    series.name = name;
+    series.gpu = gpu;
+    series.samples.assign(kHistorySize, 0.0f);
+    series.next_sample = 0;
+    it = series_indices_.emplace(name, series_.size()).first;
+    series_.push_back(std::move(series));
+  }
+  TimingSeries& series = series_[it->second];
+  series.samples[series.next_sample] = milliseconds;
+  series.next_sample = (series.next_sample + 1) % kHistorySize;
+}
+
+ScopedTimer::ScopedTimer(const char* name)
+    : name_(name), start_(std::chrono::steady_clock::now()) {
+}
+
+ScopedTimer::~ScopedTimer() {
+  std::chrono::duration<float, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start_;
+  Profiler::GetInstance().Record(name_, false, elapsed.count());
+}
+}  // namespace GLOO
@@ -0,0 +1,65 @@
+#ifndef GLOO_PROFILER_H_
+#define GLOO_PROFILER_H_
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GLOO {
+// Rolling history of one timed section, in milliseconds.
+struct TimingSeries {
+  std::string name;
+  bool gpu;
+  // Circular buffer; the oldest sample is at next_sample.
+  std::vector<float> samples;
+  size_t next_sample;
+
+  float GetLatest() const;
+  float GetAverage() const;
+};
+
+// Collects CPU and GPU timings by section name for on-screen graphs.
+class Profiler {
+ public:
+  // Singleton design pattern, as InputManager.
+  static Profiler& GetInstance() {
+    static Profiler _instance;
+    return _instance;
+  }
+
+  Profiler(const Profiler&) = delete;
+  void operator=(const Profiler&) = delete;
+
+  static const size_t kHistorySize = 120;
+
+  void Record(const std::string& name, bool gpu, float milliseconds);
+  // Series in the order they were first recorded.
+  const std::vector<TimingSeries>& GetSeries() const {
+    return series_;
+  }
+
+ private:
+  Profiler() {
+  }
+
+  std::vector<TimingSeries> series_;
+  std::unordered_map<std::string, size_t> series_indices_;
+};
+
+// Records the CPU time between construction and destruction.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(const char* name);
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  const char* name_;
+  std::chrono::steady_clock::time_point start_;
+};
+}  // namespace GLOO
+
+#endif
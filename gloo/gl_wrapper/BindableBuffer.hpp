@@ -20,6 +20,9 @@ class BindableBuffer : public IBindable {
 
   void Reset(GLuint handle = 0);
   GLuint Release();
+  GLuint GetHandle() const {
+    return handle_;
+  }
 
   void Bind() const override;
   void Unbind() const override;
@@ -0,0 +1,45 @@
+#include "Framebuffer.hpp"
+
+#include <stdexcept>
+
+#include "gloo/utils.hpp"
+
+namespace GLOO {
+Framebuffer::Framebuffer(glm::ivec2 size) : size_(size) {
+  GL_CHECK(glGenRenderbuffers(1, &color_renderbuffer_));
+  GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer_));
+  GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y));
+
+  GL_CHECK(glGenRenderbuffers(1, &depth_renderbuffer_));
+  GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_));
+  GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x,
+                                 size.y));
+  GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+  GL_CHECK(glGenFramebuffers(1, &handle_));
+  GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, handle_));
+  GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                     GL_RENDERBUFFER, color_renderbuffer_));
+  GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                     GL_RENDERBUFFER, depth_renderbuffer_));
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    throw std::runtime_error("Framebuffer is incomplete!");
+  }
+}
+
+Framebuffer::~Framebuffer() {
+  GL_CHECK(glDeleteFramebuffers(1, &handle_));
+  GL_CHECK(glDeleteRenderbuffers(1, &color_renderbuffer_));
+  GL_CHECK(glDeleteRenderbuffers(1, &depth_renderbuffer_));
+}
+
+void Framebuffer::Bind() const {
+  GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, handle_));
+}
+
+void Framebuffer::Unbind() const {
+  GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+}  // namespace GLOO
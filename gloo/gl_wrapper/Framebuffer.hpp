@@ -0,0 +1,36 @@
+#ifndef GLOO_FRAMEBUFFER_H_
+#define GLOO_FRAMEBUFFER_H_
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "IBindable.hpp"
+
+namespace GLOO {
+// A framebuffer object with an RGBA8 color and a 24-bit depth renderbuffer,
+// used as the render target when there is no window.
+class Framebuffer : public IBindable {
+ public:
+  explicit Framebuffer(glm::ivec2 size);
+  ~Framebuffer();
+
+  Framebuffer(const Framebuffer&) = delete;
+  Framebuffer& operator=(const Framebuffer&) = delete;
+
+  // Binds for both drawing and reading.
+  void Bind() const override;
+  void Unbind() const override;
+
+  glm::ivec2 GetSize() const {
+    return size_;
+  }
+
+ private:
+  GLuint handle_;
+  GLuint color_renderbuffer_;
+  GLuint depth_renderbuffer_;
+  glm::ivec2 size_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,103 @@
+#include "ReadbackRing.hpp"
+
+#include <stdexcept>
+
+#include "gloo/utils.hpp"
+
+namespace GLOO {
+ReadbackRing::ReadbackRing(glm::ivec2 size, size_t num_buffers)
+    : size_(size), slots_(num_buffers), oldest_(0), num_pending_(0) {
+  if (num_buffers == 0) {
+    throw std::runtime_error("A readback ring needs at least one buffer!");
+  }
+  GLsizeiptr num_bytes = GLsizeiptr(size.x) * size.y * 4;
+  for (Slot& slot : slots_) {
+    GL_CHECK(glGenBuffers(1, &slot.buffer));
+    GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+    GL_CHECK(glBufferData(GL_PIXEL_PACK_BUFFER, num_bytes, nullptr,
+                          GL_STREAM_READ));
+    slot.fence = nullptr;
+  }
+  GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+ReadbackRing::~ReadbackRing() {
+  for (Slot& slot : slots_) {
+    if (slot.fence != nullptr)
+      glDeleteSync(slot.fence);
+    glDeleteBuffers(1, &slot.buffer);
+  }
+}
+
+void ReadbackRing::Read(const std::string& label) {
+  if (IsFull()) {
+    throw std::runtime_error("Readback ring is full!");
+  }
+  Slot& slot = slots_[(oldest_ + num_pending_) % slots_.size()];
+  slot.label = label;
+
+  // With a pixel pack buffer bound, glReadPixels writes to the buffer and
+  // returns without waiting for rendering to finish.
+  GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+  GL_CHECK(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+  GL_CHECK(glReadPixels(0, 0, size_.x, size_.y, GL_RGBA, GL_UNSIGNED_BYTE,
+                        nullptr));
+  GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  GL_CHECK_ERROR();
+  // Submit now so the copy runs while the CPU moves on.
+  GL_CHECK(glFlush());
+  num_pending_++;
+}
+
+const std::string& ReadbackRing::GetOldestLabel() const {
+  if (IsEmpty()) {
+    throw std::runtime_error("Readback ring is empty!");
+  }
+  return slots_[oldest_].label;
+}
+
+std::unique_ptr<Image> ReadbackRing::Pop() {
+  if (IsEmpty()) {
+    throw std::runtime_error("Readback ring is empty!");
+  }
+  Slot& slot = slots_[oldest_];
+  const GLuint64 kTimeoutNs = 1000000000;
+  GLenum status;
+  do {
+    status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                              kTimeoutNs);
+  } while (status == GL_TIMEOUT_EXPIRED);
+  glDeleteSync(slot.fence);
+  slot.fence = nullptr;
+  if (status == GL_WAIT_FAILED) {
+    throw std::runtime_error("Waiting on a readback fence failed!");
+  }
+
+  GLsizeiptr num_bytes = GLsizeiptr(size_.x) * size_.y * 4;
+  GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer));
+  const uint8_t* pixels = static_cast<const uint8_t*>(
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, num_bytes, GL_MAP_READ_BIT));
+  GL_CHECK_ERROR();
+  if (pixels == nullptr) {
+    GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    throw std::runtime_error("Failed to map a readback buffer!");
+  }
+
+  // OpenGL rows start at the bottom of the framebuffer.
+  auto image = make_unique<Image>(size_.x, size_.y);
+  for (int y = 0; y < size_.y; y++) {
+    const uint8_t* row = pixels + size_t(size_.y - 1 - y) * size_.x * 4;
+    for (int x = 0; x < size_.x; x++) {
+      const uint8_t* p = row + 4 * x;
+      image->SetPixel(x, y, glm::vec3(p[0], p[1], p[2]) / 255.0f);
+    }
+  }
+  GL_CHECK(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+  GL_CHECK(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  oldest_ = (oldest_ + 1) % slots_.size();
+  num_pending_--;
+  return image;
+}
+}  // namespace GLOO
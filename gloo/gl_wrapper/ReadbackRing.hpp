@@ -0,0 +1,58 @@
+#ifndef GLOO_READBACK_RING_H_
+#define GLOO_READBACK_RING_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gloo/Image.hpp"
+
+namespace GLOO {
+// Asynchronous readback of rendered frames through a ring of pixel pack
+// buffers. Read only queues a copy of the current read framebuffer into the
+// next free buffer; Pop maps the oldest one once its copy has finished. With
+// a few buffers in flight, the CPU works on an older frame while the GPU
+// renders the next one instead of stalling in glReadPixels.
+class ReadbackRing {
+ public:
+  ReadbackRing(glm::ivec2 size, size_t num_buffers = 3);
+  ~ReadbackRing();
+
+  ReadbackRing(const ReadbackRing&) = delete;
+  ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+  bool IsEmpty() const {
+    return num_pending_ == 0;
+  }
+  bool IsFull() const {
+    return num_pending_ == slots_.size();
+  }
+
+  // Queues a readback of the bound read framebuffer, tagged with label.
+  // Throws if the ring is full; Pop first.
+  void Read(const std::string& label);
+
+  // Label of the oldest pending readback.
+  const std::string& GetOldestLabel() const;
+  // Waits for the oldest pending readback and returns its pixels, top row
+  // first.
+  std::unique_ptr<Image> Pop();
+
+ private:
+  struct Slot {
+    GLuint buffer;
+    GLsync fence;
+    std::string label;
+  };
+
+  glm::ivec2 size_;
+  std::vector<Slot> slots_;
+  size_t oldest_;
+  size_t num_pending_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,36 @@
+#include "TextureBuffer.hpp"
+
+#include "BindGuard.hpp"
+#include "gloo/utils.hpp"
+
+namespace GLOO {
+TextureBuffer::TextureBuffer(GLenum internal_format)
+    : BindableBuffer(GL_TEXTURE_BUFFER), internal_format_(internal_format) {
+  GL_CHECK(glGenTextures(1, &texture_handle_));
+}
+
+TextureBuffer::~TextureBuffer() {
+  GL_CHECK(glDeleteTextures(1, &texture_handle_));
+}
+
+void TextureBuffer::Update(const void* data, size_t num_bytes) {
+  // Buffer textures must be backed by a non-empty data store.
+  const uint32_t kEmpty[4] = {0, 0, 0, 0};
+  if (num_bytes == 0) {
+    data = kEmpty;
+    num_bytes = sizeof(kEmpty);
+  }
+  {
+    BindGuard bg(this);
+    GL_CHECK(glBufferData(target_, num_bytes, data, GL_STREAM_DRAW));
+  }
+  GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, texture_handle_));
+  GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, internal_format_, GetHandle()));
+  GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, 0));
+}
+
+void TextureBuffer::BindTexture(GLuint unit) const {
+  GL_CHECK(glActiveTexture(GL_TEXTURE0 + unit));
+  GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, texture_handle_));
+}
+}  // namespace GLOO
@@ -0,0 +1,38 @@
+#ifndef GLOO_TEXTURE_BUFFER_H_
+#define GLOO_TEXTURE_BUFFER_H_
+
+#include "BindableBuffer.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace GLOO {
+// A buffer object exposed to shaders as a buffer texture (samplerBuffer /
+// usamplerBuffer), used to feed variable-length arrays to GLSL 330.
+class TextureBuffer : public BindableBuffer {
+ public:
+  TextureBuffer(GLenum internal_format);
+  ~TextureBuffer();
+
+  TextureBuffer(const TextureBuffer&) = delete;
+  TextureBuffer& operator=(const TextureBuffer&) = delete;
+
+  // Reallocates the storage (orphaning the previous one) and uploads data.
+  template <class T>
+  void Update(const std::vector<T>& array) {
+    Update(array.data(), sizeof(T) * array.size());
+  }
+  void Update(const void* data, size_t num_bytes);
+
+  // Binds the buffer texture to the given texture unit.
+  void BindTexture(GLuint unit) const;
+
+ private:
+  GLuint texture_handle_;
+  GLenum internal_format_;
+};
+}  // namespace GLOO
+
+#endif
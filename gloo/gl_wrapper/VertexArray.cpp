@@ -1,14 +1,22 @@
 #include "VertexArray.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 #include "BindGuard.hpp"
 #include "gloo/utils.hpp"
 
 namespace GLOO {
 VertexArray::VertexArray()
-    : draw_mode_(DrawMode::Triangles), polygon_mode_(PolygonMode::Fill) {
+    : index_type_(GL_UNSIGNED_INT),
+      num_indices_(0),
+      draw_mode_(DrawMode::Triangles),
+      polygon_mode_(PolygonMode::Fill) {
   GL_CHECK(glGenVertexArrays(1, &handle_));
+  ResetAttributeLinks();
 }
 
 VertexArray::~VertexArray() {
@@ -25,6 +33,15 @@ VertexArray::VertexArray(VertexArray&& other) noexcept {
   color_buf_ = std::move(other.color_buf_);
   tex_coord_buf_ = std::move(other.tex_coord_buf_);
   idx_buf_ = std::move(other.idx_buf_);
+  instance_buf_ = std::move(other.instance_buf_);
+  linked_program_ids_ = std::move(other.linked_program_ids_);
+  interleaved_buf_ = std::move(other.interleaved_buf_);
+  format_ = std::move(other.format_);
+  std::copy(other.attr_indices_, other.attr_indices_ + kNumVertexAttributes,
+            attr_indices_);
+  index_type_ = other.index_type_;
+  num_indices_ = other.num_indices_;
+  index_data_ = std::move(other.index_data_);
   draw_mode_ = other.draw_mode_;
   polygon_mode_ = other.polygon_mode_;
 }
@@ -38,6 +55,15 @@ VertexArray& VertexArray::operator=(VertexArray&& other) noexcept {
   color_buf_ = std::move(other.color_buf_);
   tex_coord_buf_ = std::move(other.tex_coord_buf_);
   idx_buf_ = std::move(other.idx_buf_);
+  instance_buf_ = std::move(other.instance_buf_);
+  linked_program_ids_ = std::move(other.linked_program_ids_);
+  interleaved_buf_ = std::move(other.interleaved_buf_);
+  format_ = std::move(other.format_);
+  std::copy(other.attr_indices_, other.attr_indices_ + kNumVertexAttributes,
+            attr_indices_);
+  index_type_ = other.index_type_;
+  num_indices_ = other.num_indices_;
+  index_data_ = std::move(other.index_data_);
   draw_mode_ = other.draw_mode_;
   polygon_mode_ = other.polygon_mode_;
   return *this;
@@ -51,79 +77,279 @@ void VertexArray::Unbind() const {
   GL_CHECK(glBindVertexArray(0));
 }
 
-void VertexArray::CreatePositionBuffer() {
-  pos_buf_ = make_unique<PositionBuffer>(GL_STATIC_DRAW);
+void VertexArray::CreatePositionBuffer(BufferUsage usage) {
+  pos_buf_ = make_unique<PositionBuffer>(usage);
+  AttributeIndex(VertexAttribute::Position) = -1;
+  linked_program_ids_.clear();
 }
 
-void VertexArray::CreateNormalBuffer() {
-  normal_buf_ = make_unique<NormalBuffer>(GL_STATIC_DRAW);
+void VertexArray::CreateNormalBuffer(BufferUsage usage) {
+  normal_buf_ = make_unique<NormalBuffer>(usage);
+  AttributeIndex(VertexAttribute::Normal) = -1;
+  linked_program_ids_.clear();
 }
 
-void VertexArray::CreateColorBuffer() {
-  color_buf_ = make_unique<ColorBuffer>(GL_STATIC_DRAW);
+void VertexArray::CreateColorBuffer(BufferUsage usage) {
+  color_buf_ = make_unique<ColorBuffer>(usage);
+  AttributeIndex(VertexAttribute::Color) = -1;
+  linked_program_ids_.clear();
 }
 
-void VertexArray::CreateTexCoordBuffer() {
-  tex_coord_buf_ = make_unique<TexCoordBuffer>(GL_STATIC_DRAW);
+void VertexArray::CreateTexCoordBuffer(BufferUsage usage) {
+  tex_coord_buf_ = make_unique<TexCoordBuffer>(usage);
+  AttributeIndex(VertexAttribute::TexCoord) = -1;
+  linked_program_ids_.clear();
 }
 
 void VertexArray::CreateIndexBuffer() {
-  idx_buf_ = make_unique<IndexBuffer>(GL_STATIC_DRAW);
+  idx_buf_ = std::make_shared<IndexBuffer>(BufferUsage::Static);
+  linked_program_ids_.clear();
   BindGuard vao_bg(this);
   // Different from other types of vertex buffers, EBOs should not be unbounded.
   idx_buf_->Bind();
 }
 
+void VertexArray::ShareIndexBuffer(const VertexArray& other) {
+  if (other.idx_buf_ == nullptr)
+    throw std::runtime_error("Cannot share a missing index buffer!");
+  idx_buf_ = other.idx_buf_;
+  index_type_ = other.index_type_;
+  num_indices_ = other.num_indices_;
+  index_data_.clear();
+  BindGuard vao_bg(this);
+  idx_buf_->Bind();
+}
+
+void VertexArray::CreateInstanceBuffer(BufferUsage usage) {
+  instance_buf_ = make_unique<InstanceBuffer>(usage);
+  linked_program_ids_.clear();
+}
+
+void VertexArray::CreateInterleavedBuffer(const VertexFormat& format,
+                                          BufferUsage usage) {
+  pos_buf_.reset();
+  normal_buf_.reset();
+  color_buf_.reset();
+  tex_coord_buf_.reset();
+  interleaved_buf_ = make_unique<InterleavedBuffer>(usage);
+  format_ = format;
+  ResetAttributeLinks();
+  linked_program_ids_.clear();
+}
+
+void VertexArray::ResetAttributeLinks() {
+  std::fill(attr_indices_, attr_indices_ + kNumVertexAttributes, -1);
+}
+
 void VertexArray::UpdatePositions(const PositionArray& positions) const {
   pos_buf_->Update(positions);
+  GLint attr_idx = AttributeIndex(VertexAttribute::Position);
+  if (pos_buf_->IsRing() && attr_idx >= 0)
+    LinkPositionBuffer(attr_idx);
 }
 
 void VertexArray::UpdateNormals(const NormalArray& normals) const {
   normal_buf_->Update(normals);
+  GLint attr_idx = AttributeIndex(VertexAttribute::Normal);
+  if (normal_buf_->IsRing() && attr_idx >= 0)
+    LinkNormalBuffer(attr_idx);
 }
 
 void VertexArray::UpdateColors(const ColorArray& colors) const {
   color_buf_->Update(colors);
+  GLint attr_idx = AttributeIndex(VertexAttribute::Color);
+  if (color_buf_->IsRing() && attr_idx >= 0)
+    LinkColorBuffer(attr_idx);
 }
 
 void VertexArray::UpdateTexCoords(const TexCoordArray& tex_coords) const {
   tex_coord_buf_->Update(tex_coords);
+  GLint attr_idx = AttributeIndex(VertexAttribute::TexCoord);
+  if (tex_coord_buf_->IsRing() && attr_idx >= 0)
+    LinkTexCoordBuffer(attr_idx);
 }
 
 void VertexArray::UpdateIndices(const IndexArray& indices) const {
-  idx_buf_->Update(indices);
+  bool fits_short =
+      std::all_of(indices.begin(), indices.end(),
+                  [](unsigned int index) { return index <= 0xFFFF; });
+  index_type_ = fits_short ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+  num_indices_ = indices.size();
+  if (fits_short) {
+    index_data_.resize(indices.size() * sizeof(uint16_t));
+    for (size_t i = 0; i < indices.size(); i++) {
+      uint16_t index = static_cast<uint16_t>(indices[i]);
+      std::memcpy(&index_data_[i * sizeof(index)], &index, sizeof(index));
+    }
+  } else {
+    index_data_.resize(indices.size() * sizeof(unsigned int));
+    if (!indices.empty())
+      std::memcpy(index_data_.data(), indices.data(), index_data_.size());
+  }
+  idx_buf_->Update(index_data_);
 }
 
 void VertexArray::LinkPositionBuffer(GLuint attr_idx) const {
+  if (pos_buf_ == nullptr) {
+    LinkAttribute(VertexAttribute::Position, attr_idx);
+    return;
+  }
   BindGuard vao_bg(this);
   BindGuard buf_bg(pos_buf_.get());
   // The line below attaches the vertex buffer to the VAO.
-  GL_CHECK(glVertexAttribPointer(attr_idx, 3, GL_FLOAT, GL_FALSE, 0, 0));
+  GL_CHECK(glVertexAttribPointer(
+      attr_idx, 3, GL_FLOAT, GL_FALSE, 0,
+      reinterpret_cast<void*>(pos_buf_->GetOffset())));
   GL_CHECK(glEnableVertexAttribArray(attr_idx));
+  AttributeIndex(VertexAttribute::Position) = static_cast<GLint>(attr_idx);
 }
 
 void VertexArray::LinkNormalBuffer(GLuint attr_idx) const {
+  if (normal_buf_ == nullptr) {
+    LinkAttribute(VertexAttribute::Normal, attr_idx);
+    return;
+  }
   BindGuard vao_bg(this);
   BindGuard buf_bg(normal_buf_.get());
   // The line below attaches the vertex buffer to the VAO.
-  GL_CHECK(glVertexAttribPointer(attr_idx, 3, GL_FLOAT, GL_FALSE, 0, 0));
+  GL_CHECK(glVertexAttribPointer(
+      attr_idx, 3, GL_FLOAT, GL_FALSE, 0,
+      reinterpret_cast<void*>(normal_buf_->GetOffset())));
   GL_CHECK(glEnableVertexAttribArray(attr_idx));
+  AttributeIndex(VertexAttribute::Normal) = static_cast<GLint>(attr_idx);
 }
 
 void VertexArray::LinkColorBuffer(GLuint attr_idx) const {
+  if (color_buf_ == nullptr) {
+    LinkAttribute(VertexAttribute::Color, attr_idx);
+    return;
+  }
   BindGuard vao_bg(this);
   BindGuard buf_bg(color_buf_.get());
   // The line below attaches the vertex buffer to the VAO.
-  GL_CHECK(glVertexAttribPointer(attr_idx, 4, GL_FLOAT, GL_FALSE, 0, 0));
+  GL_CHECK(glVertexAttribPointer(
+      attr_idx, 4, GL_FLOAT, GL_FALSE, 0,
+      reinterpret_cast<void*>(color_buf_->GetOffset())));
   GL_CHECK(glEnableVertexAttribArray(attr_idx));
+  AttributeIndex(VertexAttribute::Color) = static_cast<GLint>(attr_idx);
 }
 
 void VertexArray::LinkTexCoordBuffer(GLuint attr_idx) const {
+  if (tex_coord_buf_ == nullptr) {
+    LinkAttribute(VertexAttribute::TexCoord, attr_idx);
+    return;
+  }
   BindGuard vao_bg(this);
   BindGuard buf_bg(tex_coord_buf_.get());
   // The line below attaches the vertex buffer to the VAO.
-  GL_CHECK(glVertexAttribPointer(attr_idx, 2, GL_FLOAT, GL_FALSE, 0, 0));
+  GL_CHECK(glVertexAttribPointer(
+      attr_idx, 2, GL_FLOAT, GL_FALSE, 0,
+      reinterpret_cast<void*>(tex_coord_buf_->GetOffset())));
+  GL_CHECK(glEnableVertexAttribArray(attr_idx));
+  AttributeIndex(VertexAttribute::TexCoord) = static_cast<GLint>(attr_idx);
+}
+
+void VertexArray::UpdateInstances(const InstanceArray& instances) const {
+  instance_buf_->Update(instances);
+}
+
+void VertexArray::UpdateInstances(const InstanceArray& instances,
+                                  size_t first,
+                                  size_t count) const {
+  instance_buf_->Update(instances, first, count);
+}
+
+void VertexArray::LinkInstanceBuffer(GLuint first_attr_idx) const {
+  BindGuard vao_bg(this);
+  BindGuard buf_bg(instance_buf_.get());
+  const GLsizei stride = sizeof(InstanceData);
+  const size_t color_offset = sizeof(glm::mat4);
+  const size_t normal_offset = color_offset + sizeof(glm::vec4);
+  for (GLuint col = 0; col < 4; col++) {
+    GLuint attr_idx = first_attr_idx + col;
+    GL_CHECK(glVertexAttribPointer(
+        attr_idx, 4, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<void*>(col * sizeof(glm::vec4))));
+    GL_CHECK(glEnableVertexAttribArray(attr_idx));
+    GL_CHECK(glVertexAttribDivisor(attr_idx, 1));
+  }
+  GL_CHECK(glVertexAttribPointer(first_attr_idx + 4, 4, GL_FLOAT, GL_FALSE,
+                                 stride,
+                                 reinterpret_cast<void*>(color_offset)));
+  GL_CHECK(glEnableVertexAttribArray(first_attr_idx + 4));
+  GL_CHECK(glVertexAttribDivisor(first_attr_idx + 4, 1));
+  for (GLuint col = 0; col < 3; col++) {
+    GLuint attr_idx = first_attr_idx + 5 + col;
+    GL_CHECK(glVertexAttribPointer(
+        attr_idx, 3, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<void*>(normal_offset + col * sizeof(glm::vec3))));
+    GL_CHECK(glEnableVertexAttribArray(attr_idx));
+    GL_CHECK(glVertexAttribDivisor(attr_idx, 1));
+  }
+}
+
+void VertexArray::UpdateInterleaved(
+    const std::vector<unsigned char>& vertices) const {
+  interleaved_buf_->Update(vertices);
+  RelinkInterleavedRing();
+}
+
+void VertexArray::ResizeInterleaved(size_t num_bytes) const {
+  interleaved_buf_->Resize(num_bytes);
+  RelinkInterleavedRing();
+}
+
+void VertexArray::UpdateInterleaved(const std::vector<unsigned char>& vertices,
+                                    size_t first,
+                                    size_t count) const {
+  interleaved_buf_->Update(vertices, first, count);
+  RelinkInterleavedRing();
+}
+
+void VertexArray::RelinkInterleavedRing() const {
+  if (!interleaved_buf_->IsRing())
+    return;
+  for (const VertexAttributeFormat& attr : format_.GetAttributes()) {
+    GLint attr_idx = AttributeIndex(attr.attribute);
+    if (attr_idx >= 0)
+      LinkAttribute(attr.attribute, attr_idx);
+  }
+}
+
+void VertexArray::LinkAttribute(VertexAttribute attribute,
+                                GLuint attr_idx) const {
+  const VertexAttributeFormat* attr = format_.Find(attribute);
+  if (interleaved_buf_ == nullptr || attr == nullptr) {
+    throw std::runtime_error("Cannot link a vertex attribute without data!");
+  }
+  BindGuard vao_bg(this);
+  BindGuard buf_bg(interleaved_buf_.get());
+  GLsizei stride = static_cast<GLsizei>(format_.GetStride());
+  void* offset =
+      reinterpret_cast<void*>(interleaved_buf_->GetOffset() + attr->offset);
+  if (attr->integer) {
+    GL_CHECK(glVertexAttribIPointer(attr_idx, attr->num_components, attr->type,
+                                    stride, offset));
+  } else {
+    GL_CHECK(glVertexAttribPointer(attr_idx, attr->num_components, attr->type,
+                                   attr->normalized ? GL_TRUE : GL_FALSE,
+                                   stride, offset));
+  }
   GL_CHECK(glEnableVertexAttribArray(attr_idx));
+  AttributeIndex(attribute) = static_cast<GLint>(attr_idx);
+}
+
+bool VertexArray::IsLinkedWith(size_t program_id) const {
+  for (size_t id : linked_program_ids_) {
+    if (id == program_id)
+      return true;
+  }
+  return false;
+}
+
+void VertexArray::MarkLinkedWith(size_t program_id) {
+  if (!IsLinkedWith(program_id))
+    linked_program_ids_.push_back(program_id);
 }
 
 void VertexArray::SetDrawMode(DrawMode mode) {
@@ -146,12 +372,31 @@ void VertexArray::Render(size_t start_index, size_t num_indices) const {
     GL_CHECK(glPolygonMode(GL_FRONT_AND_BACK, GL_FILL));
   }
 
-  GLint draw_mode = draw_mode_ == DrawMode::Triangles ? GL_TRIANGLES : GL_LINES;
+  Draw(start_index, num_indices);
+}
 
-  if (idx_buf_ != nullptr) {
-    GL_CHECK(glDrawElements(
-        draw_mode, static_cast<GLsizei>(num_indices), GL_UNSIGNED_INT,
-        reinterpret_cast<void*>(start_index * sizeof(unsigned int))));
+void VertexArray::Draw(size_t start_index, size_t num_indices) const {
+  GLint draw_mode = draw_mode_ == DrawMode::Triangles ? GL_TRIANGLES : GL_LINES;
+  size_t index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                                       : sizeof(unsigned int);
+  void* index_offset = reinterpret_cast<void*>(start_index * index_size);
+
+  if (instance_buf_ != nullptr) {
+    GLsizei num_instances = static_cast<GLsizei>(instance_buf_->GetSize());
+    if (num_instances == 0)
+      return;
+    if (idx_buf_ != nullptr) {
+      GL_CHECK(glDrawElementsInstanced(draw_mode,
+                                       static_cast<GLsizei>(num_indices),
+                                       index_type_, index_offset,
+                                       num_instances));
+    } else {
+      GL_CHECK(glDrawArraysInstanced(draw_mode, (GLint)start_index,
+                                     (GLsizei)num_indices, num_instances));
+    }
+  } else if (idx_buf_ != nullptr) {
+    GL_CHECK(glDrawElements(draw_mode, static_cast<GLsizei>(num_indices),
+                            index_type_, index_offset));
   } else {
     GL_CHECK(glDrawArrays(draw_mode, (GLint)start_index, (GLsizei)num_indices));
   }
@@ -159,12 +404,13 @@ void VertexArray::Render(size_t start_index, size_t num_indices) const {
 
 void VertexArray::Render() const {
   if (idx_buf_ != nullptr)
-    Render(0, idx_buf_->GetSize());
-  else {
-    if (pos_buf_ == nullptr)
-      throw std::runtime_error("Cannot render VertexArray without positions!");
+    Render(0, num_indices_);
+  else if (pos_buf_ != nullptr)
     Render(0, pos_buf_->GetSize());
-  }
+  else if (HasInterleaved(VertexAttribute::Position))
+    Render(0, interleaved_buf_->GetSize() / format_.GetStride());
+  else
+    throw std::runtime_error("Cannot render VertexArray without positions!");
 }
 
 static_assert(std::is_move_constructible<VertexArray>(), "");
@@ -3,9 +3,12 @@
 
 #include "IBindable.hpp"
 
+#include <vector>
+
 #include "gloo/external.hpp"
 #include "gloo/alias_types.hpp"
 #include "VertexBuffer.hpp"
+#include "VertexFormat.hpp"
 
 namespace GLOO {
 enum class DrawMode { Triangles, Lines };
@@ -27,45 +30,118 @@ class VertexArray : public IBindable {
   void Bind() const override;
   void Unbind() const override;
 
-  void CreatePositionBuffer();
-  void CreateNormalBuffer();
-  void CreateColorBuffer();
-  void CreateTexCoordBuffer();
+  // Attribute and instance buffers may pick a usage; indices are always
+  // static.
+  void CreatePositionBuffer(BufferUsage usage = BufferUsage::Static);
+  void CreateNormalBuffer(BufferUsage usage = BufferUsage::Static);
+  void CreateColorBuffer(BufferUsage usage = BufferUsage::Static);
+  void CreateTexCoordBuffer(BufferUsage usage = BufferUsage::Static);
   void CreateIndexBuffer();
+  // Draws with the index buffer of other, e.g. to let instances of a mesh
+  // hold one copy of its indices. UpdateIndices writes to the shared
+  // buffer; call CreateIndexBuffer first to stop sharing.
+  void ShareIndexBuffer(const VertexArray& other);
+  void CreateInstanceBuffer(BufferUsage usage = BufferUsage::Stream);
+  // Replaces the per-attribute buffers above with a single buffer holding
+  // whole vertices laid out by format.
+  void CreateInterleavedBuffer(const VertexFormat& format,
+                               BufferUsage usage = BufferUsage::Static);
   void UpdatePositions(const PositionArray& positions) const;
   void UpdateNormals(const NormalArray& normals) const;
   void UpdateColors(const ColorArray& colors) const;
   void UpdateTexCoords(const TexCoordArray& tex_coords) const;
+  // Uploads 16-bit indices when every index fits, halving index bandwidth,
+  // and 32-bit ones otherwise.
   void UpdateIndices(const IndexArray& indices) const;
+  void UpdateInstances(const InstanceArray& instances) const;
+  // Uploads only instances [first, first + count); see VertexBuffer.
+  void UpdateInstances(const InstanceArray& instances,
+                       size_t first,
+                       size_t count) const;
+  void UpdateInterleaved(const std::vector<unsigned char>& vertices) const;
+  // Allocates num_bytes of interleaved vertices, to be filled in byte
+  // ranges by the overload below.
+  void ResizeInterleaved(size_t num_bytes) const;
+  void UpdateInterleaved(const std::vector<unsigned char>& vertices,
+                         size_t first,
+                         size_t count) const;
+  // The Link*Buffer methods fall back to the interleaved buffer when the
+  // attribute has no buffer of its own.
   void LinkPositionBuffer(GLuint attr_idx) const;
   void LinkNormalBuffer(GLuint attr_idx) const;
   void LinkColorBuffer(GLuint attr_idx) const;
   void LinkTexCoordBuffer(GLuint attr_idx) const;
+  // Links one attribute of the interleaved buffer, honoring its offset and
+  // the vertex stride.
+  void LinkAttribute(VertexAttribute attribute, GLuint attr_idx) const;
+  // Instance data occupies kInstanceAttributeSlots consecutive attribute
+  // locations starting at first_attr_idx: four for the transform, one for
+  // the color and three for the normal matrix.
+  void LinkInstanceBuffer(GLuint first_attr_idx) const;
 
   bool HasPositionBuffer() const {
-    return pos_buf_ != nullptr;
+    return pos_buf_ != nullptr || HasInterleaved(VertexAttribute::Position);
   }
 
   bool HasNormalBuffer() const {
-    return normal_buf_ != nullptr;
+    return normal_buf_ != nullptr || HasInterleaved(VertexAttribute::Normal);
   }
 
   bool HasColorBuffer() const {
-    return color_buf_ != nullptr;
+    return color_buf_ != nullptr || HasInterleaved(VertexAttribute::Color);
   }
 
   bool HasTexCoordBuffer() const {
-    return tex_coord_buf_ != nullptr;
+    return tex_coord_buf_ != nullptr ||
+           HasInterleaved(VertexAttribute::TexCoord);
+  }
+
+  bool HasInterleavedBuffer() const {
+    return interleaved_buf_ != nullptr;
+  }
+
+  bool HasInterleaved(VertexAttribute attribute) const {
+    return interleaved_buf_ != nullptr && format_.Has(attribute);
   }
 
   bool HasIndexBuffer() const {
     return idx_buf_ != nullptr;
   }
+  bool IsIndexBufferShared() const {
+    return idx_buf_.use_count() > 1;
+  }
+  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, as chosen by UpdateIndices.
+  GLenum GetIndexType() const {
+    return index_type_;
+  }
+
+  // With an instance buffer, every draw is instanced once per element of the
+  // last uploaded InstanceArray.
+  bool HasInstanceBuffer() const {
+    return instance_buf_ != nullptr;
+  }
+  BufferUsage GetInstanceUsage() const {
+    return instance_buf_->GetUsage();
+  }
+
+  static const GLuint kInstanceAttributeSlots = 8;
+
+  // Attribute layouts are linked once per shader program and remembered
+  // here. Creating a new buffer invalidates all links.
+  bool IsLinkedWith(size_t program_id) const;
+  void MarkLinkedWith(size_t program_id);
 
   void SetDrawMode(DrawMode mode);
   void SetPolygonMode(PolygonMode mode);
+  PolygonMode GetPolygonMode() const {
+    return polygon_mode_;
+  }
+  // Binds the VAO, sets the polygon mode and draws.
   void Render(size_t start_index, size_t num_indices) const;
   void Render() const;
+  // Draws assuming the VAO is already bound and the polygon mode is set, so
+  // that consecutive draws of the same VAO share the state changes.
+  void Draw(size_t start_index, size_t num_indices) const;
 
  private:
   // Buffers are invisible to the outside.
@@ -73,14 +149,38 @@ class VertexArray : public IBindable {
   using NormalBuffer = VertexBuffer<glm::vec3, GL_ARRAY_BUFFER>;
   using ColorBuffer = VertexBuffer<glm::vec4, GL_ARRAY_BUFFER>;
   using TexCoordBuffer = VertexBuffer<glm::vec2, GL_ARRAY_BUFFER>;
-  using IndexBuffer = VertexBuffer<unsigned int, GL_ELEMENT_ARRAY_BUFFER>;
+  // Raw bytes of either 16-bit or 32-bit indices; see index_type_.
+  using IndexBuffer = VertexBuffer<unsigned char, GL_ELEMENT_ARRAY_BUFFER>;
+  using InstanceBuffer = VertexBuffer<InstanceData, GL_ARRAY_BUFFER>;
+  using InterleavedBuffer = VertexBuffer<unsigned char, GL_ARRAY_BUFFER>;
+
+  void ResetAttributeLinks();
+  // Ring buffers move to a new region on every update.
+  void RelinkInterleavedRing() const;
+  GLint& AttributeIndex(VertexAttribute attribute) const {
+    return attr_indices_[static_cast<size_t>(attribute)];
+  }
 
   std::unique_ptr<PositionBuffer> pos_buf_;
   std::unique_ptr<NormalBuffer> normal_buf_;
   std::unique_ptr<ColorBuffer> color_buf_;
   std::unique_ptr<TexCoordBuffer> tex_coord_buf_;
-  std::unique_ptr<IndexBuffer> idx_buf_;
-
+  std::shared_ptr<IndexBuffer> idx_buf_;
+  std::unique_ptr<InstanceBuffer> instance_buf_;
+  std::unique_ptr<InterleavedBuffer> interleaved_buf_;
+  VertexFormat format_;
+
+  // Attribute locations the attributes were last linked to, or -1, indexed
+  // by VertexAttribute. Ring buffers move to a new region on every update
+  // and are relinked there.
+  mutable GLint attr_indices_[kNumVertexAttributes];
+
+  mutable GLenum index_type_;
+  mutable size_t num_indices_;
+  // Indices converted to index_type_, kept to avoid reallocating.
+  mutable std::vector<unsigned char> index_data_;
+
+  std::vector<size_t> linked_program_ids_;
   DrawMode draw_mode_;
   PolygonMode polygon_mode_;
   GLuint handle_{GLuint(-1)};
@@ -3,6 +3,9 @@
 
 #include "BindableBuffer.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <vector>
 
 #include <glad/glad.h>
@@ -11,32 +14,213 @@
 #include "gloo/utils.hpp"
 
 namespace GLOO {
+// How a buffer is expected to change over its lifetime.
+enum class BufferUsage {
+  // Uploaded once or rarely; every update reallocates the storage.
+  Static,
+  // Updated in place with glBufferSubData; storage only grows.
+  Dynamic,
+  // Rewritten every frame; the old storage is orphaned before each upload
+  // so that the driver never has to wait for pending draws.
+  Stream,
+  // Rewritten every frame into one of kRingSize regions of a single
+  // buffer, guarded by fences. Draws must read from GetOffset().
+  StreamRing
+};
+
 template <class T, GLenum target>
 class VertexBuffer : public BindableBuffer {
  public:
-  VertexBuffer(GLenum usage);
+  VertexBuffer(BufferUsage usage);
+  ~VertexBuffer();
   void Update(const std::vector<T>& array);
+  // Uploads only elements [first, first + count) of array, leaving the
+  // rest of the buffer as it is. Stream buffers do not keep their
+  // contents, and a changed size needs new storage, so both upload all of
+  // array instead.
+  void Update(const std::vector<T>& array, size_t first, size_t count);
+  // Sets the size to size elements without uploading any, e.g. to fill
+  // the buffer in ranges. The contents are undefined until written.
+  void Resize(size_t size);
   size_t GetSize() const {
     return size_;
   }
+  // Byte offset of the most recently written data within the buffer.
+  size_t GetOffset() const {
+    return region_ * capacity_ * sizeof(T);
+  }
+  BufferUsage GetUsage() const {
+    return usage_;
+  }
+  bool IsRing() const {
+    return usage_ == BufferUsage::StreamRing;
+  }
+
+  static const size_t kRingSize = 3;
 
  private:
+  void Allocate(size_t capacity);
+  void UpdateRing(const std::vector<T>& array);
+  void DeleteFences();
+
   size_t size_;
-  GLenum usage_;
+  // Number of elements the storage (or each ring region) can hold.
+  size_t capacity_;
+  size_t region_;
+  BufferUsage usage_;
+  GLsync fences_[kRingSize];
 };
 
 template <class T, GLenum target>
-VertexBuffer<T, target>::VertexBuffer(GLenum usage)
-    : BindableBuffer(target), usage_(usage) {
+VertexBuffer<T, target>::VertexBuffer(BufferUsage usage)
+    : BindableBuffer(target),
+      size_(0),
+      capacity_(0),
+      region_(0),
+      usage_(usage),
+      fences_() {
+}
+
+template <class T, GLenum target>
+VertexBuffer<T, target>::~VertexBuffer() {
+  DeleteFences();
 }
 
 template <class T, GLenum target>
 void VertexBuffer<T, target>::Update(const std::vector<T>& array) {
   BindGuard bg(this);
-  GL_CHECK(
-      glBufferData(target_, sizeof(T) * array.size(), array.data(), usage_));
+  GLsizeiptr num_bytes = sizeof(T) * array.size();
+  switch (usage_) {
+    case BufferUsage::Static:
+      GL_CHECK(
+          glBufferData(target_, num_bytes, array.data(), GL_STATIC_DRAW));
+      capacity_ = array.size();
+      break;
+    case BufferUsage::Dynamic:
+      if (array.size() > capacity_) {
+        Allocate(array.size());
+      }
+      if (num_bytes > 0) {
+        GL_CHECK(glBufferSubData(target_, 0, num_bytes, array.data()));
+      }
+      break;
+    case BufferUsage::Stream:
+      if (array.size() > capacity_) {
+        Allocate(array.size());
+      } else {
+        // Orphan the old storage; pending draws keep using it.
+        GL_CHECK(glBufferData(target_, sizeof(T) * capacity_, nullptr,
+                              GL_STREAM_DRAW));
+      }
+      if (num_bytes > 0) {
+        GL_CHECK(glBufferSubData(target_, 0, num_bytes, array.data()));
+      }
+      break;
+    case BufferUsage::StreamRing:
+      UpdateRing(array);
+      break;
+  }
   size_ = array.size();
 }
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::Update(const std::vector<T>& array,
+                                     size_t first,
+                                     size_t count) {
+  if (first + count > array.size()) {
+    throw std::out_of_range("Vertex buffer update range out of bounds!");
+  }
+  bool keeps_contents =
+      usage_ == BufferUsage::Static || usage_ == BufferUsage::Dynamic;
+  if (!keeps_contents || array.size() != size_) {
+    Update(array);
+    return;
+  }
+  if (count == 0) {
+    return;
+  }
+  BindGuard bg(this);
+  GL_CHECK(glBufferSubData(target_, sizeof(T) * first, sizeof(T) * count,
+                           array.data() + first));
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::Resize(size_t size) {
+  BindGuard bg(this);
+  if (usage_ == BufferUsage::Static) {
+    GL_CHECK(glBufferData(target_, sizeof(T) * size, nullptr,
+                          GL_STATIC_DRAW));
+    capacity_ = size;
+  } else if (size > capacity_) {
+    // As in UpdateRing, fresh storage has no pending readers.
+    DeleteFences();
+    region_ = 0;
+    Allocate(size);
+  }
+  size_ = size;
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::Allocate(size_t capacity) {
+  // Grow geometrically so that slowly growing arrays do not reallocate on
+  // every update.
+  capacity_ = std::max(capacity, capacity_ + capacity_ / 2);
+  size_t num_regions = usage_ == BufferUsage::StreamRing ? kRingSize : 1;
+  GLenum gl_usage =
+      usage_ == BufferUsage::Dynamic ? GL_DYNAMIC_DRAW : GL_STREAM_DRAW;
+  GL_CHECK(glBufferData(target_, sizeof(T) * capacity_ * num_regions, nullptr,
+                        gl_usage));
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::UpdateRing(const std::vector<T>& array) {
+  if (array.size() > capacity_) {
+    // Fresh storage has no pending readers.
+    DeleteFences();
+    Allocate(array.size());
+    region_ = 0;
+  } else {
+    // Every draw reading the current region has been issued by now.
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    GL_CHECK_ERROR();
+    region_ = (region_ + 1) % kRingSize;
+    if (fences_[region_] != nullptr) {
+      const GLuint64 kTimeoutNs = 1000000000;
+      GLenum status = glClientWaitSync(fences_[region_],
+                                       GL_SYNC_FLUSH_COMMANDS_BIT, kTimeoutNs);
+      glDeleteSync(fences_[region_]);
+      fences_[region_] = nullptr;
+      if (status == GL_WAIT_FAILED) {
+        throw std::runtime_error("Waiting on a vertex buffer fence failed!");
+      }
+    }
+  }
+  if (array.empty()) {
+    return;
+  }
+
+  GLsizeiptr num_bytes = sizeof(T) * array.size();
+  void* dst = glMapBufferRange(
+      target_, GetOffset(), num_bytes,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+          GL_MAP_UNSYNCHRONIZED_BIT);
+  GL_CHECK_ERROR();
+  if (dst == nullptr) {
+    throw std::runtime_error("Failed to map vertex buffer region!");
+  }
+  std::memcpy(dst, array.data(), num_bytes);
+  GL_CHECK(glUnmapBuffer(target_));
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::DeleteFences() {
+  for (size_t i = 0; i < kRingSize; i++) {
+    if (fences_[i] != nullptr) {
+      glDeleteSync(fences_[i]);
+      fences_[i] = nullptr;
+    }
+  }
+}
 }  // namespace GLOO
 
 #endif
@@ -0,0 +1,154 @@
+#include "VertexFormat.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <glm/gtc/packing.hpp>
+
+namespace {
+size_t GetTypeSize(GLenum type) {
+  switch (type) {
+    case GL_FLOAT:
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+      return 4;
+    case GL_HALF_FLOAT:
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+      return 2;
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+      return 1;
+    default:
+      throw std::runtime_error("Unsupported vertex attribute type!");
+  }
+}
+
+size_t GetAttributeSize(GLint num_components, GLenum type) {
+  // Packed types hold all components in a single 32-bit word.
+  if (type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV)
+    return 4;
+  return num_components * GetTypeSize(type);
+}
+
+template <class T>
+void WriteFixedPoint(const glm::vec4& value,
+                     GLint num_components,
+                     bool normalized,
+                     float min_value,
+                     float max_value,
+                     unsigned char* dst) {
+  for (GLint c = 0; c < num_components; c++) {
+    float v = value[c];
+    if (normalized) {
+      v = glm::clamp(v, min_value < 0.0f ? -1.0f : 0.0f, 1.0f) * max_value;
+    }
+    T fixed = static_cast<T>(std::round(glm::clamp(v, min_value, max_value)));
+    std::memcpy(dst + c * sizeof(T), &fixed, sizeof(T));
+  }
+}
+}  // namespace
+
+namespace GLOO {
+VertexFormat::VertexFormat() : stride_(0) {
+}
+
+VertexFormat& VertexFormat::Add(VertexAttribute attribute,
+                                GLint num_components,
+                                GLenum type,
+                                bool normalized,
+                                bool integer) {
+  if (Has(attribute)) {
+    throw std::runtime_error("Vertex attribute added twice to a format!");
+  }
+  VertexAttributeFormat format;
+  format.attribute = attribute;
+  format.num_components = num_components;
+  format.type = type;
+  format.normalized = normalized;
+  format.integer = integer;
+  format.offset = stride_;
+  attributes_.push_back(format);
+
+  size_t size = GetAttributeSize(num_components, type);
+  stride_ += (size + 3) / 4 * 4;
+  return *this;
+}
+
+const VertexAttributeFormat* VertexFormat::Find(
+    VertexAttribute attribute) const {
+  for (const VertexAttributeFormat& format : attributes_) {
+    if (format.attribute == attribute)
+      return &format;
+  }
+  return nullptr;
+}
+
+bool VertexFormat::operator==(const VertexFormat& other) const {
+  if (attributes_.size() != other.attributes_.size())
+    return false;
+  for (size_t i = 0; i < attributes_.size(); i++) {
+    const VertexAttributeFormat& a = attributes_[i];
+    const VertexAttributeFormat& b = other.attributes_[i];
+    if (a.attribute != b.attribute || a.num_components != b.num_components ||
+        a.type != b.type || a.normalized != b.normalized ||
+        a.integer != b.integer || a.offset != b.offset)
+      return false;
+  }
+  return true;
+}
+
+void VertexFormat::Write(const VertexAttributeFormat& format,
+                         const glm::vec4& value,
+                         unsigned char* vertex_data) {
+  unsigned char* dst = vertex_data + format.offset;
+  switch (format.type) {
+    case GL_FLOAT:
+      std::memcpy(dst, &value[0], format.num_components * sizeof(float));
+      break;
+    case GL_HALF_FLOAT:
+      for (GLint c = 0; c < format.num_components; c++) {
+        glm::uint16 half = glm::packHalf1x16(value[c]);
+        std::memcpy(dst + c * sizeof(half), &half, sizeof(half));
+      }
+      break;
+    case GL_INT_2_10_10_10_REV: {
+      glm::uint32 packed = glm::packSnorm3x10_1x2(value);
+      std::memcpy(dst, &packed, sizeof(packed));
+      break;
+    }
+    case GL_UNSIGNED_BYTE:
+      WriteFixedPoint<std::uint8_t>(value, format.num_components,
+                                    format.normalized, 0.0f, 255.0f, dst);
+      break;
+    case GL_UNSIGNED_SHORT:
+      WriteFixedPoint<std::uint16_t>(value, format.num_components,
+                                     format.normalized, 0.0f, 65535.0f, dst);
+      break;
+    case GL_UNSIGNED_INT:
+      WriteFixedPoint<std::uint32_t>(value, format.num_components,
+                                     format.normalized, 0.0f, 4294967295.0f,
+                                     dst);
+      break;
+    case GL_SHORT:
+      WriteFixedPoint<std::int16_t>(value, format.num_components,
+                                    format.normalized, -32767.0f, 32767.0f,
+                                    dst);
+      break;
+    default:
+      throw std::runtime_error("Cannot write vertex attribute of this type!");
+  }
+}
+
+VertexFormat VertexFormat::PackedSkinned() {
+  VertexFormat format;
+  format.Add(VertexAttribute::Position, 3, GL_FLOAT)
+      .Add(VertexAttribute::Normal, 4, GL_INT_2_10_10_10_REV, true)
+      .Add(VertexAttribute::TexCoord, 2, GL_HALF_FLOAT)
+      .Add(VertexAttribute::JointIndices, 4, GL_UNSIGNED_BYTE, false, true)
+      .Add(VertexAttribute::JointWeights, 4, GL_UNSIGNED_BYTE, true);
+  return format;
+}
+}  // namespace GLOO
@@ -0,0 +1,78 @@
+#ifndef GLOO_VERTEX_FORMAT_H_
+#define GLOO_VERTEX_FORMAT_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace GLOO {
+enum class VertexAttribute {
+  Position,
+  Normal,
+  Color,
+  TexCoord,
+  JointIndices,
+  JointWeights
+};
+const size_t kNumVertexAttributes = 6;
+
+// Placement of one attribute inside an interleaved vertex.
+struct VertexAttributeFormat {
+  VertexAttribute attribute;
+  GLint num_components;
+  GLenum type;
+  // Fixed-point values are mapped to [0, 1] or [-1, 1].
+  bool normalized;
+  // Read by the shader as integers (glVertexAttribIPointer).
+  bool integer;
+  size_t offset;
+};
+
+// Describes how the attributes of one vertex are laid out in an interleaved
+// vertex buffer. Attributes are placed in the order they are added, each
+// aligned to four bytes.
+class VertexFormat {
+ public:
+  VertexFormat();
+
+  VertexFormat& Add(VertexAttribute attribute,
+                    GLint num_components,
+                    GLenum type,
+                    bool normalized = false,
+                    bool integer = false);
+
+  // Returns nullptr if the attribute is not part of the format.
+  const VertexAttributeFormat* Find(VertexAttribute attribute) const;
+  bool Has(VertexAttribute attribute) const {
+    return Find(attribute) != nullptr;
+  }
+  const std::vector<VertexAttributeFormat>& GetAttributes() const {
+    return attributes_;
+  }
+  size_t GetStride() const {
+    return stride_;
+  }
+  bool operator==(const VertexFormat& other) const;
+  bool operator!=(const VertexFormat& other) const {
+    return !(*this == other);
+  }
+
+  // Converts value to the attribute's type and writes it to the vertex
+  // starting at vertex_data.
+  static void Write(const VertexAttributeFormat& format,
+                    const glm::vec4& value,
+                    unsigned char* vertex_data);
+
+  // 28 bytes per vertex: float position, 10-bit signed normal, half-float
+  // texture coordinates, four 8-bit joint indices and four 8-bit weights.
+  static VertexFormat PackedSkinned();
+
+ private:
+  std::vector<VertexAttributeFormat> attributes_;
+  size_t stride_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,84 @@
+#include "AnimationParser.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+template <class T>
+using KeyMap = std::map<int, std::vector<std::pair<float, T>>>;
+
+// Sorts the keyframes of every joint into a track.
+template <class T>
+void BuildTracks(KeyMap<T>& keys,
+                 const std::string& file_path,
+                 std::vector<GLOO::AnimationTrack<T>>& tracks,
+                 float& duration) {
+  for (auto& joint_keys : keys) {
+    std::vector<std::pair<float, T>>& track_keys = joint_keys.second;
+    std::stable_sort(track_keys.begin(), track_keys.end(),
+                     [](const std::pair<float, T>& a,
+                        const std::pair<float, T>& b) {
+                       return a.first < b.first;
+                     });
+    GLOO::AnimationTrack<T> track;
+    track.joint = joint_keys.first;
+    track.times.reserve(track_keys.size());
+    track.values.reserve(track_keys.size());
+    for (const auto& key : track_keys) {
+      if (!track.times.empty() && track.times.back() == key.first) {
+        throw std::runtime_error("Two keyframes of joint " +
+                                 std::to_string(track.joint) + " at time " +
+                                 std::to_string(key.first) + " in " +
+                                 file_path + "!");
+      }
+      track.times.push_back(key.first);
+      track.values.push_back(key.second);
+    }
+    duration = std::max(duration, track.times.back());
+    tracks.push_back(std::move(track));
+  }
+}
+}  // namespace
+
+namespace GLOO {
+bool AnimationParser::Parse(const std::string& file_path,
+                            AnimationClip& clip) {
+  std::ifstream file(file_path);
+  if (!file)
+    return false;
+
+  KeyMap<glm::quat> rotation_keys;
+  KeyMap<glm::vec3> translation_keys;
+  std::string line;
+  for (size_t line_number = 1; std::getline(file, line); line_number++) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream ss(line);
+    std::string type;
+    if (!(ss >> type))
+      continue;
+    int joint;
+    float time;
+    glm::vec3 value;
+    bool ok = bool(ss >> joint >> time >> value.x >> value.y >> value.z) &&
+              joint >= 0 && time >= 0.0f;
+    if (ok && type == "rotation") {
+      rotation_keys[joint].emplace_back(time, glm::quat(value));
+    } else if (ok && type == "translation") {
+      translation_keys[joint].emplace_back(time, value);
+    } else {
+      throw std::runtime_error("Malformed line " + std::to_string(line_number) +
+                               " in animation file " + file_path + "!");
+    }
+  }
+
+  clip = AnimationClip();
+  BuildTracks(rotation_keys, file_path, clip.rotation_tracks, clip.duration);
+  BuildTracks(translation_keys, file_path, clip.translation_tracks,
+              clip.duration);
+  return true;
+}
+}  // namespace GLOO
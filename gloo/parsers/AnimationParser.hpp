@@ -0,0 +1,23 @@
+#ifndef GLOO_ANIMATION_PARSER_H_
+#define GLOO_ANIMATION_PARSER_H_
+
+#include <string>
+
+#include "gloo/animation/AnimationClip.hpp"
+
+namespace GLOO {
+// Reads a clip from a text file with one keyframe per line ('#' starts a
+// comment):
+//   rotation JOINT TIME RX RY RZ
+//   translation JOINT TIME X Y Z
+// Rotations are Euler angles in radians, as set by the joint sliders, and
+// translations are offsets from the parent joint. Keyframes of a track may
+// come in any order, but not twice at the same time.
+class AnimationParser {
+ public:
+  // Returns false if the file does not exist; throws if it is malformed.
+  static bool Parse(const std::string& file_path, AnimationClip& clip);
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,137 @@
+#include "CharacterParser.hpp"
+
+#include <fstream>
+#include <future>
+#include <iostream>
+
+#include "gloo/MeshLoader.hpp"
+#include "gloo/MeshOptimizer.hpp"
+#include "gloo/parsers/ObjParser.hpp"
+
+namespace GLOO {
+const uint32_t CharacterParser::kVersion;
+
+bool CharacterParser::Parse(const std::string& prefix, CharacterData& data) {
+  // The files are independent until the weights are matched with the
+  // skeleton and the optimized mesh, so they are parsed concurrently. Each
+  // task writes its own members of data.
+  std::vector<unsigned int> vertex_remap;
+  std::vector<float> weights;
+  auto skeleton = std::async(std::launch::async, [&prefix, &data]() {
+    return ParseSkeleton(prefix + ".skel", data);
+  });
+  auto mesh = std::async(std::launch::async, [&prefix, &data, &vertex_remap]() {
+    return ParseMesh(prefix + ".obj", data, vertex_remap);
+  });
+  // The weights are read on this thread meanwhile.
+  bool success = ParseWeights(prefix + ".attach", weights);
+  // Every task is joined before anything is combined, even on failure.
+  success = skeleton.get() && success;
+  success = mesh.get() && success;
+  return success &&
+         ParseAttachment(prefix + ".attach", weights, vertex_remap, data);
+}
+
+bool CharacterParser::ParseSkeleton(const std::string& file_path,
+                                    CharacterData& data) {
+  std::ifstream fs(file_path);
+  if (!fs) {
+    std::cerr << "ERROR: Unable to open skeleton file " + file_path + "!"
+              << std::endl;
+    return false;
+  }
+  glm::vec3 position;
+  int parent;
+  while (fs >> position.x >> position.y >> position.z >> parent) {
+    data.joint_positions.push_back(position);
+    data.joint_parents.push_back(parent);
+  }
+  if (!ComputeBindMatrices(data.joint_positions, data.joint_parents,
+                           data.bind_matrices)) {
+    std::cerr << "ERROR: Invalid joint hierarchy in " + file_path + "!"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool CharacterParser::ParseMesh(const std::string& file_path,
+                                CharacterData& data,
+                                std::vector<unsigned int>& vertex_remap) {
+  bool success;
+  auto parsed_data = ObjParser::Parse(file_path, success);
+  if (!success || !parsed_data.positions || !parsed_data.indices) {
+    std::cerr << "ERROR: No mesh in " + file_path + "!" << std::endl;
+    return false;
+  }
+  for (unsigned int index : *parsed_data.indices) {
+    if (index >= parsed_data.positions->size()) {
+      std::cerr << "ERROR: Vertex index out of range in " + file_path + "!"
+                << std::endl;
+      return false;
+    }
+  }
+  vertex_remap = MeshLoader::Optimize(parsed_data);
+  data.positions = std::move(*parsed_data.positions);
+  data.indices = std::move(*parsed_data.indices);
+
+  FindIncidentTriangles(data.indices, data.positions.size(),
+                        data.incident_offsets, data.incident_triangles);
+  // Only the mesh members, as the skeleton may still be being parsed.
+  CharacterView mesh;
+  mesh.indices = data.indices;
+  mesh.incident_offsets = data.incident_offsets;
+  mesh.incident_triangles = data.incident_triangles;
+  data.normals.resize(data.positions.size());
+  ComputeVertexNormals(mesh, data.positions.data(), data.normals.data());
+  return true;
+}
+
+bool CharacterParser::ParseWeights(const std::string& file_path,
+                                   std::vector<float>& weights) {
+  std::ifstream fs(file_path);
+  if (!fs) {
+    std::cerr << "ERROR: Unable to open attachment file " + file_path + "!"
+              << std::endl;
+    return false;
+  }
+  float weight;
+  while (fs >> weight) {
+    weights.push_back(weight);
+  }
+  return true;
+}
+
+bool CharacterParser::ParseAttachment(
+    const std::string& file_path,
+    const std::vector<float>& weights,
+    const std::vector<unsigned int>& vertex_remap,
+    CharacterData& data) {
+  // One weight per bone and vertex, in .obj vertex order.
+  size_t num_bones = data.bind_matrices.size();
+  size_t num_vertices = data.positions.size();
+  if (num_bones == 0 || weights.size() != num_vertices * num_bones) {
+    std::cerr << "ERROR: " + file_path + " does not have one weight per "
+                 "bone and vertex!"
+              << std::endl;
+    return false;
+  }
+
+  // Keep only the nonzero weights, in the optimized vertex order.
+  std::vector<uint32_t> source_vertices(num_vertices);
+  for (size_t v = 0; v < num_vertices; v++) {
+    source_vertices[vertex_remap[v]] = static_cast<uint32_t>(v);
+  }
+  data.influence_offsets.assign(1, 0);
+  for (size_t v = 0; v < num_vertices; v++) {
+    const float* row = &weights[source_vertices[v] * num_bones];
+    for (size_t j = 0; j < num_bones; j++) {
+      if (row[j] != 0.0f)
+        data.influences.push_back({static_cast<uint32_t>(j), row[j]});
+    }
+    data.influence_offsets.push_back(
+        static_cast<uint32_t>(data.influences.size()));
+  }
+  return true;
+}
+}  // namespace GLOO
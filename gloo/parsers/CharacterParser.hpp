@@ -0,0 +1,45 @@
+#ifndef GLOO_CHARACTER_PARSER_H_
+#define GLOO_CHARACTER_PARSER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gloo/CharacterData.hpp"
+
+namespace GLOO {
+// Builds a character from its text sources: PREFIX.skel (one "x y z
+// parent" line per joint), PREFIX.obj and PREFIX.attach (one line of bone
+// weights per .obj vertex). Derived data such as the bind matrices, the
+// bind-pose normals and the mesh adjacency is computed here, once, so that
+// it can be stored in a CharacterBundle.
+class CharacterParser {
+ public:
+  // Bumped whenever the derived data changes, e.g. with a new mesh
+  // optimization, so that characters cached by older code are not reused.
+  static const uint32_t kVersion = 1;
+
+  // Returns false if a file is missing or inconsistent with the others.
+  static bool Parse(const std::string& prefix, CharacterData& data);
+
+ private:
+  static bool ParseSkeleton(const std::string& file_path,
+                            CharacterData& data);
+  // Also computes the adjacency and the normals. Returns the vertex remap
+  // table of the mesh optimization.
+  static bool ParseMesh(const std::string& file_path,
+                        CharacterData& data,
+                        std::vector<unsigned int>& vertex_remap);
+  // Reads the .attach weights as they are in the file.
+  static bool ParseWeights(const std::string& file_path,
+                           std::vector<float>& weights);
+  // Checks the weights against the parsed skeleton and mesh and stores the
+  // nonzero ones in the optimized vertex order.
+  static bool ParseAttachment(const std::string& file_path,
+                              const std::vector<float>& weights,
+                              const std::vector<unsigned int>& vertex_remap,
+                              CharacterData& data);
+};
+}  // namespace GLOO
+
+#endif
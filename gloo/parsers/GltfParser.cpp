@@ -0,0 +1,718 @@
+#include "GltfParser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "gloo/MappedFile.hpp"
+
+namespace {
+const uint32_t kGlbMagic = 0x46546c67;  // "glTF"
+const uint32_t kGlbVersion = 2;
+const uint32_t kJsonChunk = 0x4e4f534a;  // "JSON"
+const uint32_t kBinChunk = 0x004e4942;  // "BIN\0"
+const int kMaxJsonDepth = 64;
+
+// Accessor component types, and the primitive mode of triangle lists.
+const int kUnsignedByte = 5121;
+const int kUnsignedShort = 5123;
+const int kUnsignedInt = 5125;
+const int kFloat = 5126;
+const int kTriangles = 4;
+
+void Fail(const std::string& file_path, const std::string& reason) {
+  throw std::runtime_error("Invalid glTF file " + file_path + ": " + reason);
+}
+
+template <class T>
+T Load(const char* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+// Just enough of a JSON document model for the glTF header.
+struct JsonValue {
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+  JsonValue() : type(Type::Null), number(0.0) {
+  }
+
+  bool IsNull() const {
+    return type == Type::Null;
+  }
+  // Member named key, or null if there is none.
+  const JsonValue& Get(const char* key) const;
+  // Array element i, or null if there is none.
+  const JsonValue& At(size_t i) const;
+  size_t GetSize() const {
+    return type == Type::Array ? elements.size() : 0;
+  }
+
+  Type type;
+  // Numbers, and booleans as 0 or 1.
+  double number;
+  std::string string;
+  // Array elements, or object member values named by keys.
+  std::vector<JsonValue> elements;
+  std::vector<std::string> keys;
+};
+
+const JsonValue kNullValue;
+
+const JsonValue& JsonValue::Get(const char* key) const {
+  if (type == Type::Object) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] == key)
+        return elements[i];
+    }
+  }
+  return kNullValue;
+}
+
+const JsonValue& JsonValue::At(size_t i) const {
+  return i < GetSize() ? elements[i] : kNullValue;
+}
+
+class JsonReader {
+ public:
+  JsonReader(const char* begin, const char* end, const std::string& file_path)
+      : p_(begin), end_(end), file_path_(file_path) {
+  }
+
+  void Read(JsonValue& document) {
+    ReadValue(document, 0);
+    SkipSpaces();
+    if (p_ != end_)
+      Fail(file_path_, "trailing characters after the JSON document");
+  }
+
+ private:
+  void ReadValue(JsonValue& value, int depth) {
+    if (depth > kMaxJsonDepth)
+      Fail(file_path_, "JSON nested too deeply");
+    SkipSpaces();
+    if (p_ == end_)
+      Fail(file_path_, "unexpected end of JSON");
+    if (Consume('{')) {
+      value.type = JsonValue::Type::Object;
+      SkipSpaces();
+      if (Consume('}'))
+        return;
+      do {
+        SkipSpaces();
+        value.keys.emplace_back();
+        ReadString(value.keys.back());
+        SkipSpaces();
+        Expect(':');
+        value.elements.emplace_back();
+        ReadValue(value.elements.back(), depth + 1);
+        SkipSpaces();
+      } while (Consume(','));
+      Expect('}');
+    } else if (Consume('[')) {
+      value.type = JsonValue::Type::Array;
+      SkipSpaces();
+      if (Consume(']'))
+        return;
+      do {
+        value.elements.emplace_back();
+        ReadValue(value.elements.back(), depth + 1);
+        SkipSpaces();
+      } while (Consume(','));
+      Expect(']');
+    } else if (*p_ == '"') {
+      value.type = JsonValue::Type::String;
+      ReadString(value.string);
+    } else if (ConsumeWord("true")) {
+      value.type = JsonValue::Type::Bool;
+      value.number = 1.0;
+    } else if (ConsumeWord("false")) {
+      value.type = JsonValue::Type::Bool;
+      value.number = 0.0;
+    } else if (ConsumeWord("null")) {
+      value.type = JsonValue::Type::Null;
+    } else {
+      value.type = JsonValue::Type::Number;
+      ReadNumber(value.number);
+    }
+  }
+
+  void ReadString(std::string& string) {
+    Expect('"');
+    while (true) {
+      if (p_ == end_)
+        Fail(file_path_, "unterminated JSON string");
+      char c = *p_++;
+      if (c == '"')
+        return;
+      if (c != '\\') {
+        string += c;
+        continue;
+      }
+      if (p_ == end_)
+        Fail(file_path_, "unterminated JSON string");
+      c = *p_++;
+      switch (c) {
+        case 'b':
+          string += '\b';
+          break;
+        case 'f':
+          string += '\f';
+          break;
+        case 'n':
+          string += '\n';
+          break;
+        case 'r':
+          string += '\r';
+          break;
+        case 't':
+          string += '\t';
+          break;
+        case 'u':
+          AppendUtf8(ReadCodePoint(), string);
+          break;
+        default:
+          string += c;
+      }
+    }
+  }
+
+  // The code point of a \u escape whose backslash and 'u' were consumed,
+  // combining surrogate pairs.
+  uint32_t ReadCodePoint() {
+    uint32_t code_point = ReadHex4();
+    if (code_point >= 0xd800 && code_point < 0xdc00 && end_ - p_ >= 6 &&
+        p_[0] == '\\' && p_[1] == 'u') {
+      p_ += 2;
+      uint32_t low = ReadHex4();
+      code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+    }
+    return code_point;
+  }
+
+  uint32_t ReadHex4() {
+    if (end_ - p_ < 4)
+      Fail(file_path_, "bad JSON escape");
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+      int digit = GetHexDigit(*p_++);
+      if (digit < 0)
+        Fail(file_path_, "bad JSON escape");
+      value = value * 16 + digit;
+    }
+    return value;
+  }
+
+  static int GetHexDigit(char c) {
+    if (c >= '0' && c <= '9')
+      return c - '0';
+    if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+    return -1;
+  }
+
+  static void AppendUtf8(uint32_t code_point, std::string& string) {
+    if (code_point < 0x80) {
+      string += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+      string += static_cast<char>(0xc0 | (code_point >> 6));
+      string += static_cast<char>(0x80 | (code_point & 0x3f));
+    } else if (code_point < 0x10000) {
+      string += static_cast<char>(0xe0 | (code_point >> 12));
+      string += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+      string += static_cast<char>(0x80 | (code_point & 0x3f));
+    } else {
+      string += static_cast<char>(0xf0 | (code_point >> 18));
+      string += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+      string += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+      string += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+  }
+
+  void ReadNumber(double& number) {
+    // Copied out, as the chunk is not null-terminated.
+    std::string token;
+    while (p_ != end_ && ((*p_ >= '0' && *p_ <= '9') || *p_ == '-' ||
+                          *p_ == '+' || *p_ == '.' || *p_ == 'e' ||
+                          *p_ == 'E')) {
+      token += *p_++;
+    }
+    char* token_end;
+    number = std::strtod(token.c_str(), &token_end);
+    if (token.empty() || *token_end != '\0')
+      Fail(file_path_, "unexpected character in JSON");
+  }
+
+  void SkipSpaces() {
+    while (p_ != end_ &&
+           (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+      p_++;
+    }
+  }
+
+  bool Consume(char c) {
+    if (p_ == end_ || *p_ != c)
+      return false;
+    p_++;
+    return true;
+  }
+
+  bool ConsumeWord(const char* word) {
+    size_t length = std::strlen(word);
+    if (static_cast<size_t>(end_ - p_) < length ||
+        std::memcmp(p_, word, length) != 0) {
+      return false;
+    }
+    p_ += length;
+    return true;
+  }
+
+  void Expect(char c) {
+    if (!Consume(c))
+      Fail(file_path_, std::string("expected '") + c + "' in JSON");
+  }
+
+  const char* p_;
+  const char* end_;
+  const std::string& file_path_;
+};
+
+struct GltfFile {
+  std::string path;
+  JsonValue root;
+  // The GLB binary chunk, the only buffer supported.
+  const char* bin;
+  size_t bin_size;
+};
+
+// A non-negative integer member, or default_value if it is absent.
+size_t GetInteger(const GltfFile& gltf,
+                  const JsonValue& value,
+                  size_t default_value,
+                  const std::string& what) {
+  if (value.IsNull())
+    return default_value;
+  if (value.type != JsonValue::Type::Number || value.number < 0.0 ||
+      value.number > 9007199254740992.0 ||
+      value.number != std::floor(value.number)) {
+    Fail(gltf.path, "bad " + what);
+  }
+  return static_cast<size_t>(value.number);
+}
+
+// An index into an array of count elements.
+size_t GetIndex(const GltfFile& gltf,
+                const JsonValue& value,
+                size_t count,
+                const std::string& what) {
+  if (value.IsNull())
+    Fail(gltf.path, "missing " + what);
+  size_t index = GetInteger(gltf, value, 0, what);
+  if (index >= count)
+    Fail(gltf.path, what + " out of range");
+  return index;
+}
+
+// A typed, strided array in the binary chunk.
+struct Accessor {
+  const char* data;
+  size_t count;
+  size_t stride;
+  int component_type;
+  int num_components;
+  bool normalized;
+};
+
+size_t GetComponentSize(int component_type) {
+  switch (component_type) {
+    case kUnsignedByte:
+      return 1;
+    case kUnsignedShort:
+      return 2;
+    case kUnsignedInt:
+    case kFloat:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+int GetNumComponents(const std::string& type) {
+  if (type == "SCALAR")
+    return 1;
+  if (type == "VEC2")
+    return 2;
+  if (type == "VEC3")
+    return 3;
+  if (type == "VEC4")
+    return 4;
+  if (type == "MAT4")
+    return 16;
+  return 0;
+}
+
+Accessor GetAccessor(const GltfFile& gltf, const JsonValue& index_value) {
+  const JsonValue& accessors = gltf.root.Get("accessors");
+  size_t index =
+      GetIndex(gltf, index_value, accessors.GetSize(), "accessor index");
+  const JsonValue& json = accessors.At(index);
+  std::string name = "accessor " + std::to_string(index);
+  if (!json.Get("sparse").IsNull())
+    Fail(gltf.path, name + " is sparse, which is not supported");
+
+  Accessor accessor;
+  accessor.count = GetInteger(gltf, json.Get("count"), 0, name + " count");
+  accessor.component_type = static_cast<int>(
+      GetInteger(gltf, json.Get("componentType"), 0, name + " type"));
+  accessor.num_components = GetNumComponents(json.Get("type").string);
+  accessor.normalized = json.Get("normalized").number != 0.0;
+  size_t element_size =
+      GetComponentSize(accessor.component_type) * accessor.num_components;
+  if (element_size == 0)
+    Fail(gltf.path, name + " has an unsupported type");
+
+  const JsonValue& views = gltf.root.Get("bufferViews");
+  const JsonValue& view = views.At(GetIndex(
+      gltf, json.Get("bufferView"), views.GetSize(), name + " buffer view"));
+  const JsonValue& buffers = gltf.root.Get("buffers");
+  size_t buffer =
+      GetIndex(gltf, view.Get("buffer"), buffers.GetSize(), "buffer index");
+  if (buffer != 0 || !buffers.At(0).Get("uri").IsNull() ||
+      gltf.bin == nullptr) {
+    Fail(gltf.path, name + " is not in the binary chunk");
+  }
+  size_t view_offset =
+      GetInteger(gltf, view.Get("byteOffset"), 0, "buffer view offset");
+  size_t view_length =
+      GetInteger(gltf, view.Get("byteLength"), 0, "buffer view length");
+  size_t offset = GetInteger(gltf, json.Get("byteOffset"), 0, name + " offset");
+  accessor.stride =
+      GetInteger(gltf, view.Get("byteStride"), element_size, "byte stride");
+  if (view_offset > gltf.bin_size ||
+      view_length > gltf.bin_size - view_offset ||
+      accessor.stride < element_size) {
+    Fail(gltf.path, "bad buffer view of " + name);
+  }
+  if (accessor.count > 0 &&
+      (offset > view_length || view_length - offset < element_size ||
+       accessor.count - 1 >
+           (view_length - offset - element_size) / accessor.stride)) {
+    Fail(gltf.path, name + " is out of its buffer view");
+  }
+  accessor.data = gltf.bin + view_offset + offset;
+  return accessor;
+}
+
+void CheckType(const GltfFile& gltf,
+               const Accessor& accessor,
+               bool type_supported,
+               int num_components,
+               const std::string& what) {
+  if (!type_supported || accessor.num_components != num_components)
+    Fail(gltf.path, what + " has an unsupported type");
+}
+
+// Component c of element i, for integer component types.
+uint32_t ReadUnsigned(const Accessor& accessor, size_t i, int c) {
+  const char* element = accessor.data + i * accessor.stride;
+  switch (accessor.component_type) {
+    case kUnsignedByte:
+      return Load<uint8_t>(element + c);
+    case kUnsignedShort:
+      return Load<uint16_t>(element + 2 * c);
+    default:
+      return Load<uint32_t>(element + 4 * c);
+  }
+}
+
+// Component c of element i, for float and normalized integer types.
+float ReadFloat(const Accessor& accessor, size_t i, int c) {
+  const char* element = accessor.data + i * accessor.stride;
+  switch (accessor.component_type) {
+    case kUnsignedByte:
+      return Load<uint8_t>(element + c) / 255.0f;
+    case kUnsignedShort:
+      return Load<uint16_t>(element + 2 * c) / 65535.0f;
+    default:
+      return Load<float>(element + 4 * c);
+  }
+}
+
+// Copies float elements of num_components each, in one go when they are
+// tightly packed.
+void CopyFloats(const Accessor& accessor, int num_components, float* out) {
+  size_t element_size = num_components * sizeof(float);
+  if (accessor.stride == element_size) {
+    std::memcpy(out, accessor.data, accessor.count * element_size);
+    return;
+  }
+  for (size_t i = 0; i < accessor.count; i++) {
+    std::memcpy(out + i * num_components, accessor.data + i * accessor.stride,
+                element_size);
+  }
+}
+
+void ReadPrimitive(const GltfFile& gltf,
+                   const JsonValue& primitive,
+                   size_t num_bones,
+                   GLOO::CharacterData& data) {
+  if (GetInteger(gltf, primitive.Get("mode"), kTriangles, "mode") !=
+      kTriangles) {
+    Fail(gltf.path, "only triangle lists are supported");
+  }
+  const JsonValue& attributes = primitive.Get("attributes");
+  Accessor positions = GetAccessor(gltf, attributes.Get("POSITION"));
+  CheckType(gltf, positions, positions.component_type == kFloat, 3,
+            "POSITION");
+  size_t base_vertex = data.positions.size();
+  size_t num_vertices = positions.count;
+  data.positions.resize(base_vertex + num_vertices);
+  if (num_vertices > 0)
+    CopyFloats(positions, 3, glm::value_ptr(data.positions[base_vertex]));
+
+  std::vector<Accessor> joints, weights;
+  for (int set = 0;; set++) {
+    std::string suffix = "_" + std::to_string(set);
+    const JsonValue& joints_index = attributes.Get(("JOINTS" + suffix).c_str());
+    if (joints_index.IsNull())
+      break;
+    joints.push_back(GetAccessor(gltf, joints_index));
+    weights.push_back(
+        GetAccessor(gltf, attributes.Get(("WEIGHTS" + suffix).c_str())));
+    CheckType(gltf, joints.back(),
+              joints.back().component_type == kUnsignedByte ||
+                  joints.back().component_type == kUnsignedShort,
+              4, "JOINTS" + suffix);
+    CheckType(gltf, weights.back(),
+              weights.back().component_type == kFloat ||
+                  (weights.back().normalized &&
+                   weights.back().component_type != kUnsignedInt),
+              4, "WEIGHTS" + suffix);
+    if (joints.back().count != num_vertices ||
+        weights.back().count != num_vertices) {
+      Fail(gltf.path, "vertex attributes of different lengths");
+    }
+  }
+  if (joints.empty())
+    Fail(gltf.path, "skinned primitive without JOINTS_0");
+
+  // Nonzero weights in increasing bone order, summing repeated bones.
+  data.influences.reserve(data.influences.size() +
+                          4 * joints.size() * num_vertices);
+  data.influence_offsets.reserve(data.influence_offsets.size() + num_vertices);
+  std::vector<GLOO::JointInfluence> vertex_influences;
+  for (size_t v = 0; v < num_vertices; v++) {
+    vertex_influences.clear();
+    for (size_t set = 0; set < joints.size(); set++) {
+      for (int c = 0; c < 4; c++) {
+        float weight = ReadFloat(weights[set], v, c);
+        if (weight == 0.0f)
+          continue;
+        uint32_t bone = ReadUnsigned(joints[set], v, c);
+        if (bone >= num_bones)
+          Fail(gltf.path, "joint index out of range");
+        vertex_influences.push_back({bone, weight});
+      }
+    }
+    // Insertion sort, as there are only a few.
+    for (size_t i = 1; i < vertex_influences.size(); i++) {
+      GLOO::JointInfluence influence = vertex_influences[i];
+      size_t k = i;
+      for (; k > 0 && vertex_influences[k - 1].bone > influence.bone; k--) {
+        vertex_influences[k] = vertex_influences[k - 1];
+      }
+      vertex_influences[k] = influence;
+    }
+    for (size_t i = 0; i < vertex_influences.size(); i++) {
+      if (i > 0 && vertex_influences[i].bone == data.influences.back().bone)
+        data.influences.back().weight += vertex_influences[i].weight;
+      else
+        data.influences.push_back(vertex_influences[i]);
+    }
+    data.influence_offsets.push_back(
+        static_cast<uint32_t>(data.influences.size()));
+  }
+
+  const JsonValue& indices_index = primitive.Get("indices");
+  size_t base_index = data.indices.size();
+  if (indices_index.IsNull()) {
+    data.indices.resize(base_index + num_vertices);
+    for (size_t i = 0; i < num_vertices; i++) {
+      data.indices[base_index + i] = static_cast<unsigned int>(base_vertex + i);
+    }
+  } else {
+    Accessor indices = GetAccessor(gltf, indices_index);
+    CheckType(gltf, indices, indices.component_type != kFloat, 1, "indices");
+    data.indices.resize(base_index + indices.count);
+    for (size_t i = 0; i < indices.count; i++) {
+      uint32_t index = ReadUnsigned(indices, i, 0);
+      if (index >= num_vertices)
+        Fail(gltf.path, "vertex index out of range");
+      data.indices[base_index + i] =
+          static_cast<unsigned int>(base_vertex + index);
+    }
+  }
+  if ((data.indices.size() - base_index) % 3 != 0)
+    Fail(gltf.path, "triangle list with a partial triangle");
+}
+
+// Builds the joint hierarchy of the skin, where joint j of the skin becomes
+// joint j + 1 under an added root.
+void ReadSkeleton(const GltfFile& gltf,
+                  const JsonValue& skin,
+                  GLOO::CharacterData& data) {
+  const JsonValue& nodes = gltf.root.Get("nodes");
+  size_t num_nodes = nodes.GetSize();
+  std::vector<int> node_parents(num_nodes, -1);
+  for (size_t n = 0; n < num_nodes; n++) {
+    const JsonValue& children = nodes.At(n).Get("children");
+    for (size_t c = 0; c < children.GetSize(); c++) {
+      size_t child =
+          GetIndex(gltf, children.At(c), num_nodes, "child node index");
+      if (node_parents[child] != -1)
+        Fail(gltf.path, "node with two parents");
+      node_parents[child] = static_cast<int>(n);
+    }
+  }
+
+  const JsonValue& skin_joints = skin.Get("joints");
+  size_t num_skin_joints = skin_joints.GetSize();
+  if (num_skin_joints == 0)
+    Fail(gltf.path, "skin without joints");
+  std::vector<int> node_joints(num_nodes, -1);
+  std::vector<size_t> joint_nodes(num_skin_joints);
+  for (size_t j = 0; j < num_skin_joints; j++) {
+    joint_nodes[j] =
+        GetIndex(gltf, skin_joints.At(j), num_nodes, "joint node index");
+    node_joints[joint_nodes[j]] = static_cast<int>(j);
+  }
+
+  // Joints sit at the origin of their bind-pose frames, which the inverse
+  // bind matrices map mesh space to.
+  std::vector<glm::vec3> world_positions(num_skin_joints + 1, glm::vec3(0.0f));
+  const JsonValue& matrices_index = skin.Get("inverseBindMatrices");
+  if (!matrices_index.IsNull()) {
+    Accessor matrices = GetAccessor(gltf, matrices_index);
+    CheckType(gltf, matrices, matrices.component_type == kFloat, 16,
+              "inverseBindMatrices");
+    if (matrices.count < num_skin_joints)
+      Fail(gltf.path, "too few inverse bind matrices");
+    std::vector<glm::mat4> inverse_binds(matrices.count);
+    CopyFloats(matrices, 16, glm::value_ptr(inverse_binds[0]));
+    for (size_t j = 0; j < num_skin_joints; j++) {
+      world_positions[j + 1] = glm::vec3(glm::inverse(inverse_binds[j])[3]);
+    }
+  }
+
+  data.joint_positions.assign(1, glm::vec3(0.0f));
+  data.joint_parents.assign(1, -1);
+  for (size_t j = 0; j < num_skin_joints; j++) {
+    // The closest ancestor node that is a joint too, if any.
+    int node = node_parents[joint_nodes[j]];
+    for (size_t steps = 0; node != -1 && node_joints[node] == -1; steps++) {
+      if (steps == num_nodes)
+        Fail(gltf.path, "cycle in the node hierarchy");
+      node = node_parents[node];
+    }
+    int parent = node == -1 ? 0 : node_joints[node] + 1;
+    data.joint_parents.push_back(parent);
+    data.joint_positions.push_back(world_positions[j + 1] -
+                                   world_positions[parent]);
+  }
+  if (!GLOO::ComputeBindMatrices(data.joint_positions, data.joint_parents,
+                                 data.bind_matrices)) {
+    Fail(gltf.path, "cycle in the joint hierarchy");
+  }
+}
+}  // namespace
+
+namespace GLOO {
+bool GltfParser::Parse(const std::string& file_path, CharacterData& data) {
+  MappedFile file;
+  if (!file.Open(file_path))
+    return false;
+  const char* bytes = file.GetData();
+  size_t size = file.GetSize();
+
+  // A 12-byte header, then chunks of an 8-byte header and 4-byte aligned
+  // data: JSON first, then the optional binary chunk.
+  const size_t kHeaderSize = 12;
+  const size_t kChunkHeaderSize = 8;
+  if (size < kHeaderSize + kChunkHeaderSize ||
+      Load<uint32_t>(bytes) != kGlbMagic) {
+    Fail(file_path, "not a GLB file");
+  }
+  if (Load<uint32_t>(bytes + 4) != kGlbVersion)
+    Fail(file_path, "only glTF 2.0 is supported");
+  // The declared length bounds the chunks; the file may have trailing
+  // bytes, but must hold at least one chunk header.
+  size_t declared_size = Load<uint32_t>(bytes + 8);
+  if (declared_size < kHeaderSize + kChunkHeaderSize || declared_size > size)
+    Fail(file_path, "invalid length in the header");
+  size = declared_size;
+  GltfFile gltf;
+  gltf.path = file_path;
+  gltf.bin = nullptr;
+  gltf.bin_size = 0;
+  bool has_json = false;
+  for (size_t offset = kHeaderSize; size - offset >= kChunkHeaderSize;) {
+    size_t chunk_size = Load<uint32_t>(bytes + offset);
+    uint32_t chunk_type = Load<uint32_t>(bytes + offset + 4);
+    const char* chunk = bytes + offset + kChunkHeaderSize;
+    if (chunk_size > size - offset - kChunkHeaderSize)
+      Fail(file_path, "truncated chunk");
+    if (chunk_type == kJsonChunk && !has_json) {
+      JsonReader(chunk, chunk + chunk_size, file_path).Read(gltf.root);
+      has_json = true;
+    } else if (chunk_type == kBinChunk && gltf.bin == nullptr) {
+      gltf.bin = chunk;
+      gltf.bin_size = chunk_size;
+    }
+    offset += kChunkHeaderSize + (chunk_size + 3) / 4 * 4;
+    if (offset > size)
+      break;
+  }
+  if (!has_json)
+    Fail(file_path, "no JSON chunk");
+
+  // The first node with a skinned mesh.
+  const JsonValue& nodes = gltf.root.Get("nodes");
+  const JsonValue* skinned_node = nullptr;
+  for (size_t n = 0; n < nodes.GetSize() && skinned_node == nullptr; n++) {
+    if (!nodes.At(n).Get("mesh").IsNull() && !nodes.At(n).Get("skin").IsNull())
+      skinned_node = &nodes.At(n);
+  }
+  if (skinned_node == nullptr)
+    Fail(file_path, "no skinned mesh");
+  const JsonValue& skins = gltf.root.Get("skins");
+  const JsonValue& skin = skins.At(GetIndex(gltf, skinned_node->Get("skin"),
+                                            skins.GetSize(), "skin index"));
+  const JsonValue& meshes = gltf.root.Get("meshes");
+  const JsonValue& mesh = meshes.At(GetIndex(gltf, skinned_node->Get("mesh"),
+                                             meshes.GetSize(), "mesh index"));
+
+  data = CharacterData();
+  ReadSkeleton(gltf, skin, data);
+  const JsonValue& primitives = mesh.Get("primitives");
+  data.influence_offsets.assign(1, 0);
+  for (size_t p = 0; p < primitives.GetSize(); p++) {
+    ReadPrimitive(gltf, primitives.At(p), data.bind_matrices.size(), data);
+  }
+  if (data.positions.empty())
+    Fail(file_path, "skinned mesh without vertices");
+
+  FindIncidentTriangles(data.indices, data.positions.size(),
+                        data.incident_offsets, data.incident_triangles);
+  data.normals.resize(data.positions.size());
+  ComputeVertexNormals(data.GetView(), data.positions.data(),
+                       data.normals.data());
+  return true;
+}
+}  // namespace GLOO
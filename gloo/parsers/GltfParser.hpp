@@ -0,0 +1,28 @@
+#ifndef GLOO_GLTF_PARSER_H_
+#define GLOO_GLTF_PARSER_H_
+
+#include <string>
+
+#include "gloo/CharacterData.hpp"
+
+namespace GLOO {
+// Imports the first skinned mesh of a binary glTF 2.0 (.glb) file as a
+// character. Vertex, index, weight and matrix arrays are copied straight
+// out of the mapped binary chunk, which is read in native byte order, so
+// little-endian hosts only.
+//
+// The character's skeleton is the skin's joint hierarchy under an added
+// root joint at the origin, so that glTF joint j is drawn by bone j. As in
+// .skel files, joints are only translated relative to their parents: they
+// sit where the inverse bind matrices put them, and their rest rotations
+// are dropped. Triangle list primitives are merged into one mesh with up
+// to four weights per vertex for each JOINTS_n/WEIGHTS_n pair.
+class GltfParser {
+ public:
+  // Returns false if the file does not exist; throws if it is malformed or
+  // uses features beyond the above.
+  static bool Parse(const std::string& file_path, CharacterData& data);
+};
+}  // namespace GLOO
+
+#endif
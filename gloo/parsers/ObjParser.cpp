@@ -1,97 +1,415 @@
 #include "ObjParser.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <thread>
+#include <vector>
 
+#include "gloo/MappedFile.hpp"
 #include "gloo/utils.hpp"
 
+namespace {
+// Powers of ten that are exact in double precision.
+const double kPowersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                              1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                              1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Whitespace as skipped by stream extraction, except for the newlines that
+// separate lines.
+inline bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline void SkipSpaces(const char*& p, const char* end) {
+  while (p != end && IsSpace(*p))
+    p++;
+}
+
+inline const char* FindLineEnd(const char* p, const char* end) {
+  auto line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+  return line_end == nullptr ? end : line_end;
+}
+
+// Reads the next whitespace-delimited token into [begin, p).
+inline const char* ReadToken(const char*& p, const char* end) {
+  SkipSpaces(p, end);
+  const char* begin = p;
+  while (p != end && !IsSpace(*p))
+    p++;
+  return begin;
+}
+
+template <size_t N>
+inline bool TokenIs(const char* begin,
+                    const char* end,
+                    const char (&command)[N]) {
+  return static_cast<size_t>(end - begin) == N - 1 &&
+         std::memcmp(begin, command, N - 1) == 0;
+}
+
+// Parses a decimal number the way stream extraction into a float does and
+// advances p past it; returns 0 if there is no number. Up to 15 or so
+// significant digits with small exponents, which covers nearly all OBJ
+// coordinates, take Clinger's fast path: the mantissa and the power of ten
+// are exact in double precision, so one multiplication or division rounds
+// correctly, and the rounding to float is then correct too unless the
+// double lands exactly halfway between two floats. Anything else goes
+// through strtof.
+float ParseFloat(const char*& p, const char* end) {
+  SkipSpaces(p, end);
+  const char* start = p;
+  bool negative = false;
+  if (p != end && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    p++;
+  }
+  uint64_t mantissa = 0;
+  int exponent = 0;
+  bool any_digit = false;
+  bool overflow = false;
+  for (; p != end && IsDigit(*p); p++) {
+    any_digit = true;
+    if (mantissa < (uint64_t(1) << 53))
+      mantissa = mantissa * 10 + (*p - '0');
+    else
+      overflow = true;
+  }
+  if (p != end && *p == '.') {
+    p++;
+    for (; p != end && IsDigit(*p); p++) {
+      any_digit = true;
+      if (mantissa < (uint64_t(1) << 53)) {
+        mantissa = mantissa * 10 + (*p - '0');
+        exponent--;
+      } else {
+        overflow = true;
+      }
+    }
+  }
+  if (!any_digit) {
+    p = start;
+    return 0.0f;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool negative_exponent = false;
+    if (q != end && (*q == '+' || *q == '-')) {
+      negative_exponent = *q == '-';
+      q++;
+    }
+    if (q != end && IsDigit(*q)) {
+      int explicit_exponent = 0;
+      for (; q != end && IsDigit(*q); q++) {
+        if (explicit_exponent < 10000)
+          explicit_exponent = explicit_exponent * 10 + (*q - '0');
+      }
+      exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+      p = q;
+    }
+  }
+
+  if (!overflow && mantissa <= (uint64_t(1) << 53) && exponent >= -22 &&
+      exponent <= 22) {
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0)
+      value /= kPowersOf10[-exponent];
+    else
+      value *= kPowersOf10[exponent];
+    // The 29 low mantissa bits are the ones dropped when rounding to float.
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint64_t kDroppedMask = (uint64_t(1) << 29) - 1;
+    if ((bits & kDroppedMask) != (uint64_t(1) << 28)) {
+      float result = static_cast<float>(value);
+      return negative ? -result : result;
+    }
+  }
+  char buffer[64];
+  size_t length = p - start;
+  if (length < sizeof(buffer)) {
+    std::memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    return std::strtof(buffer, nullptr);
+  }
+  return std::strtof(std::string(start, p).c_str(), nullptr);
+}
+
+// Parses the position index of a face corner written as "v", "v/vt",
+// "v//vn" or "v/vt/vn" and returns it zero-based. Negative indices count
+// back from the last position read so far.
+unsigned int ParseFaceIndex(const char*& p,
+                            const char* end,
+                            size_t num_positions) {
+  SkipSpaces(p, end);
+  bool negative = false;
+  if (p != end && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    p++;
+  }
+  unsigned long value = 0;
+  for (; p != end && IsDigit(*p); p++) {
+    value = value * 10 + (*p - '0');
+  }
+  // Texture coordinate and normal indices are not used.
+  while (p != end && !IsSpace(*p))
+    p++;
+  if (negative)
+    return static_cast<unsigned int>(num_positions - value);
+  // Minus 1 because OBJ indices start with 1.
+  return static_cast<unsigned int>(value - 1);
+}
+
+// Chunks are at least this large, so that small files are parsed on the
+// calling thread and large ones do not pay for threads that parse little.
+const size_t kMinChunkSize = 1 << 20;
+
+struct ElementCounts {
+  size_t positions = 0;
+  size_t normals = 0;
+  size_t tex_coords = 0;
+  size_t faces = 0;
+};
+
+// Command that affects the state carried across lines, recorded while the
+// chunks are parsed in parallel and replayed in file order afterwards.
+struct ObjEvent {
+  enum class Type { Group, UseMaterial, MaterialLibrary, Skipped, Unknown };
+  Type type;
+  // The group or material name, the library path or the command.
+  std::string argument;
+  // Number of indices in the file before this command.
+  size_t num_indices;
+};
+
+// Range of whole lines of the file, parsed by one thread.
+struct ObjChunk {
+  const char* begin;
+  const char* end;
+  ElementCounts counts;
+  // Elements in all preceding chunks, i.e. where this chunk's elements go
+  // in the output arrays.
+  ElementCounts offsets;
+  std::vector<ObjEvent> events;
+};
+
+// Splits [begin, end) into at most max_chunks line-aligned chunks.
+std::vector<ObjChunk> SplitIntoChunks(const char* begin,
+                                      const char* end,
+                                      size_t max_chunks) {
+  size_t size = end - begin;
+  size_t chunk_size =
+      std::max(kMinChunkSize, (size + max_chunks - 1) / max_chunks);
+  std::vector<ObjChunk> chunks;
+  const char* p = begin;
+  while (p < end) {
+    ObjChunk chunk;
+    chunk.begin = p;
+    if (static_cast<size_t>(end - p) <= chunk_size) {
+      chunk.end = end;
+    } else {
+      const char* line_end = FindLineEnd(p + chunk_size - 1, end);
+      chunk.end = line_end == end ? end : line_end + 1;
+    }
+    p = chunk.end;
+    chunks.push_back(std::move(chunk));
+  }
+  return chunks;
+}
+
+// Runs task(0), ..., task(count - 1) concurrently, one on the calling
+// thread and the others on new threads.
+template <class Task>
+void RunInParallel(size_t count, const Task& task) {
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < count; i++) {
+    threads.emplace_back(task, i);
+  }
+  if (count > 0)
+    task(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+// Counts the lines of each element type, so that the arrays are allocated
+// once and each chunk knows where its elements go.
+ElementCounts CountElements(const char* p, const char* end) {
+  ElementCounts counts;
+  while (p < end) {
+    const char* line_end = FindLineEnd(p, end);
+    const char* command = ReadToken(p, line_end);
+    if (TokenIs(command, p, "v"))
+      counts.positions++;
+    else if (TokenIs(command, p, "vn"))
+      counts.normals++;
+    else if (TokenIs(command, p, "vt"))
+      counts.tex_coords++;
+    else if (TokenIs(command, p, "f"))
+      counts.faces++;
+    p = line_end + 1;
+  }
+  return counts;
+}
+
+// Parses the elements of a chunk straight into their place in the output
+// arrays, which are already sized for the whole file.
+void ParseChunk(ObjChunk& chunk, GLOO::ObjParser::ParsedData& data) {
+  glm::vec3* positions =
+      data.positions ? data.positions->data() + chunk.offsets.positions
+                     : nullptr;
+  glm::vec3* normals =
+      data.normals ? data.normals->data() + chunk.offsets.normals : nullptr;
+  glm::vec2* tex_coords =
+      data.tex_coords ? data.tex_coords->data() + chunk.offsets.tex_coords
+                      : nullptr;
+  unsigned int* indices =
+      data.indices ? data.indices->data() + 3 * chunk.offsets.faces
+                   : nullptr;
+  size_t num_positions = chunk.offsets.positions;
+  size_t num_indices = 3 * chunk.offsets.faces;
+
+  const char* p = chunk.begin;
+  while (p < chunk.end) {
+    const char* line_end = FindLineEnd(p, chunk.end);
+    const char* command = ReadToken(p, line_end);
+    if (p == command || *command == '#') {
+      // Empty line or comment.
+    } else if (TokenIs(command, p, "v")) {
+      glm::vec3& position = *positions++;
+      position.x = ParseFloat(p, line_end);
+      position.y = ParseFloat(p, line_end);
+      position.z = ParseFloat(p, line_end);
+      num_positions++;
+    } else if (TokenIs(command, p, "vn")) {
+      glm::vec3& normal = *normals++;
+      normal.x = ParseFloat(p, line_end);
+      normal.y = ParseFloat(p, line_end);
+      normal.z = ParseFloat(p, line_end);
+    } else if (TokenIs(command, p, "vt")) {
+      glm::vec2& uv = *tex_coords++;
+      uv.s = ParseFloat(p, line_end);
+      uv.t = ParseFloat(p, line_end);
+    } else if (TokenIs(command, p, "f")) {
+      for (int t = 0; t < 3; t++) {
+        *indices++ = ParseFaceIndex(p, line_end, num_positions);
+      }
+      num_indices += 3;
+    } else {
+      ObjEvent event;
+      event.num_indices = num_indices;
+      if (TokenIs(command, p, "g")) {
+        event.type = ObjEvent::Type::Group;
+      } else if (TokenIs(command, p, "usemtl")) {
+        event.type = ObjEvent::Type::UseMaterial;
+      } else if (TokenIs(command, p, "mtllib")) {
+        event.type = ObjEvent::Type::MaterialLibrary;
+      } else if (TokenIs(command, p, "o") || TokenIs(command, p, "s")) {
+        event.type = ObjEvent::Type::Skipped;
+      } else {
+        event.type = ObjEvent::Type::Unknown;
+      }
+      if (event.type == ObjEvent::Type::Skipped ||
+          event.type == ObjEvent::Type::Unknown) {
+        event.argument.assign(command, p);
+      } else {
+        const char* argument = ReadToken(p, line_end);
+        event.argument.assign(argument, p);
+      }
+      chunk.events.push_back(std::move(event));
+    }
+    p = line_end + 1;
+  }
+}
+}  // namespace
+
 namespace GLOO {
 ObjParser::ParsedData ObjParser::Parse(const std::string& file_path,
                                        bool& success) {
   success = false;
-  std::fstream fs(file_path);
-  if (!fs) {
+  MappedFile file;
+  if (!file.Open(file_path)) {
     std::cerr << "ERROR: Unable to open OBJ file " + file_path + "!"
               << std::endl;
     return {};
   }
 
   std::string base_path = GetBasePath(file_path);
+  const char* begin = file.GetData();
+  const char* end = begin + file.GetSize();
+  size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<ObjChunk> chunks = SplitIntoChunks(begin, end, num_threads);
+
+  // Count the elements of each chunk, then place the chunks in the output
+  // arrays by prefix sums over the counts.
+  RunInParallel(chunks.size(), [&chunks](size_t i) {
+    chunks[i].counts = CountElements(chunks[i].begin, chunks[i].end);
+  });
+  ElementCounts totals;
+  for (auto& chunk : chunks) {
+    chunk.offsets = totals;
+    totals.positions += chunk.counts.positions;
+    totals.normals += chunk.counts.normals;
+    totals.tex_coords += chunk.counts.tex_coords;
+    totals.faces += chunk.counts.faces;
+  }
 
   ParsedData data;
-  MaterialDict material_dict;
+  if (totals.positions > 0)
+    data.positions = make_unique<PositionArray>(totals.positions);
+  if (totals.normals > 0)
+    data.normals = make_unique<NormalArray>(totals.normals);
+  if (totals.tex_coords > 0)
+    data.tex_coords = make_unique<TexCoordArray>(totals.tex_coords);
+  if (totals.faces > 0)
+    data.indices = make_unique<IndexArray>(3 * totals.faces);
+  RunInParallel(chunks.size(),
+                [&chunks, &data](size_t i) { ParseChunk(chunks[i], data); });
 
+  // Groups span chunks, so they are assembled from the recorded commands in
+  // file order.
+  MaterialDict material_dict;
   MeshGroup current_group;
-  std::string line;
-  while (std::getline(fs, line)) {
-    std::stringstream ss(line);
-    std::string command;
-    ss >> command;
-    if (command == "#" || command == "") {
-      continue;
-    } else if (command == "v") {
-      glm::vec3 p;
-      ss >> p.x >> p.y >> p.z;
-      if (data.positions == nullptr)
-        data.positions = make_unique<PositionArray>();
-      data.positions->emplace_back(std::move(p));
-    } else if (command == "vn") {
-      glm::vec3 n;
-      ss >> n.x >> n.y >> n.z;
-      if (data.normals == nullptr)
-        data.normals = make_unique<NormalArray>();
-      data.normals->emplace_back(std::move(n));
-    } else if (command == "vt") {
-      glm::vec2 uv;
-      ss >> uv.s >> uv.t;
-      if (data.tex_coords == nullptr)
-        data.tex_coords = make_unique<TexCoordArray>();
-      data.tex_coords->emplace_back(std::move(uv));
-    } else if (command == "f") {
-      if (data.indices == nullptr)
-        data.indices = make_unique<IndexArray>();
-      for (int t = 0; t < 3; t++) {
-        std::string str;
-        ss >> str;
-        unsigned int idx;
-        if (str.find('/') == std::string::npos) {
-          idx = std::stoul(str);
-        } else {
-          idx = std::stoul(Split(str, '/')[0]);
-        }
-        // Minus 1 because OBJ indices start with 1.
-        data.indices->push_back(idx - 1);
-      }
-    } else if (command == "g") {
-      if (current_group.name != "") {
-        current_group.num_indices =
-            data.indices->size() - current_group.start_face_index;
-        data.groups.push_back(std::move(current_group));
+  for (const auto& chunk : chunks) {
+    for (const auto& event : chunk.events) {
+      switch (event.type) {
+        case ObjEvent::Type::Group:
+          if (current_group.name != "") {
+            current_group.num_indices =
+                event.num_indices - current_group.start_face_index;
+            data.groups.push_back(std::move(current_group));
+            current_group = MeshGroup();
+          }
+          current_group.name = event.argument;
+          current_group.start_face_index = event.num_indices;
+          break;
+        case ObjEvent::Type::UseMaterial:
+          current_group.material_name = event.argument;
+          break;
+        case ObjEvent::Type::MaterialLibrary:
+          material_dict = ParseMTL(base_path + event.argument);
+          break;
+        case ObjEvent::Type::Skipped:
+          std::cout << "Skipped command: " << event.argument << std::endl;
+          break;
+        case ObjEvent::Type::Unknown:
+          std::cerr << "Unknown obj command: " << event.argument << std::endl;
+          break;
       }
-      ss >> current_group.name;
-      if (data.indices == nullptr)
-        current_group.start_face_index = 0;
-      else
-        current_group.start_face_index = data.indices->size();
-    } else if (command == "usemtl") {
-      ss >> current_group.material_name;
-    } else if (command == "mtllib") {
-      std::string mtl_file;
-      ss >> mtl_file;
-      material_dict = ParseMTL(base_path + mtl_file);
-    } else if (command == "o" || command == "s") {
-      std::cout << "Skipped command: " << command << std::endl;
-    } else {
-      std::cerr << "Unknown obj command: " << command << std::endl;
-      success = false;
-      continue;
     }
   }
 
   if (current_group.name != "") {
     current_group.num_indices =
-        data.indices->size() - current_group.start_face_index;
+        3 * totals.faces - current_group.start_face_index;
     data.groups.push_back(std::move(current_group));
   }
 
@@ -0,0 +1,20 @@
+#include "InstancedPhongShader.hpp"
+
+#include <stdexcept>
+
+namespace GLOO {
+InstancedPhongShader::InstancedPhongShader()
+    : PhongShader(std::unordered_map<GLenum, std::string>{
+          {GL_VERTEX_SHADER, "instanced_phong.vert"},
+          {GL_FRAGMENT_SHADER, "phong.frag"}}) {
+}
+
+void InstancedPhongShader::AssociateVertexArray(
+    VertexArray& vertex_array) const {
+  if (!vertex_array.HasInstanceBuffer()) {
+    throw std::runtime_error("Instanced Phong shader requires instances!");
+  }
+  PhongShader::AssociateVertexArray(vertex_array);
+  vertex_array.LinkInstanceBuffer(GetAttributeLocation("instance_transform"));
+}
+}  // namespace GLOO
@@ -0,0 +1,19 @@
+#ifndef GLOO_INSTANCED_PHONG_SHADER_H_
+#define GLOO_INSTANCED_PHONG_SHADER_H_
+
+#include "PhongShader.hpp"
+
+namespace GLOO {
+// Phong shading for vertex objects carrying instance data. Each instance is
+// transformed by model_matrix * InstanceData::transform and tints the
+// material with InstanceData::color.
+class InstancedPhongShader : public PhongShader {
+ public:
+  InstancedPhongShader();
+
+ protected:
+  void AssociateVertexArray(VertexArray& vertex_array) const override;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,20 @@
+#include "InstancedSimpleShader.hpp"
+
+#include <stdexcept>
+
+namespace GLOO {
+InstancedSimpleShader::InstancedSimpleShader()
+    : SimpleShader(std::unordered_map<GLenum, std::string>(
+          {{GL_VERTEX_SHADER, "instanced_simple.vert"},
+           {GL_FRAGMENT_SHADER, "simple.frag"}})) {
+}
+
+void InstancedSimpleShader::AssociateVertexArray(
+    VertexArray& vertex_array) const {
+  if (!vertex_array.HasInstanceBuffer()) {
+    throw std::runtime_error("Instanced simple shader requires instances!");
+  }
+  SimpleShader::AssociateVertexArray(vertex_array);
+  vertex_array.LinkInstanceBuffer(GetAttributeLocation("instance_transform"));
+}
+}  // namespace GLOO
@@ -0,0 +1,18 @@
+#ifndef GLOO_INSTANCED_SIMPLE_SHADER_H_
+#define GLOO_INSTANCED_SIMPLE_SHADER_H_
+
+#include "SimpleShader.hpp"
+
+namespace GLOO {
+// Instanced variant of SimpleShader; the material color is tinted by
+// InstanceData::color.
+class InstancedSimpleShader : public SimpleShader {
+ public:
+  InstancedSimpleShader();
+
+ protected:
+  void AssociateVertexArray(VertexArray& vertex_array) const override;
+};
+}  // namespace GLOO
+
+#endif
@@ -10,17 +10,30 @@
 #include "gloo/components/RenderingComponent.hpp"
 #include "gloo/components/MaterialComponent.hpp"
 #include "gloo/SceneNode.hpp"
+#include "gloo/gl_wrapper/BindGuard.hpp"
+#include "gloo/LightClusterGrid.hpp"
 #include "gloo/lights/AmbientLight.hpp"
 #include "gloo/lights/PointLight.hpp"
 #include "gloo/lights/DirectionalLight.hpp"
 
 namespace GLOO {
 PhongShader::PhongShader()
-    : ShaderProgram(std::unordered_map<GLenum, std::string>{
+    : PhongShader(std::unordered_map<GLenum, std::string>{
           {GL_VERTEX_SHADER, "phong.vert"},
           {GL_FRAGMENT_SHADER, "phong.frag"}}) {
 }
 
+PhongShader::PhongShader(
+    const std::unordered_map<GLenum, std::string>& shader_filenames)
+    : ShaderProgram(shader_filenames) {
+  // Samplers of different types must never share a texture unit, even when
+  // clustered lighting is off, so assign the light buffer units up front.
+  BindGuard shader_bg(this);
+  SetUniform("light_data", kLightDataTextureUnit);
+  SetUniform("cluster_data", kLightDataTextureUnit + 1);
+  SetUniform("cluster_light_indices", kLightDataTextureUnit + 2);
+}
+
 void PhongShader::AssociateVertexArray(VertexArray& vertex_array) const {
   if (!vertex_array.HasPositionBuffer()) {
     throw std::runtime_error("Phong shader requires vertex positions!");
@@ -35,33 +48,20 @@ void PhongShader::AssociateVertexArray(VertexArray& vertex_array) const {
   }
 }
 
-void PhongShader::SetTargetNode(const SceneNode& node,
-                                const glm::mat4& model_matrix) const {
-  // Associate the right VAO before rendering.
-  AssociateVertexArray(node.GetComponentPtr<RenderingComponent>()
-                           ->GetVertexObjectPtr()
-                           ->GetVertexArray());
-
-  // Set transform.
+void PhongShader::SetModelMatrix(const glm::mat4& model_matrix) const {
   glm::mat3 normal_matrix =
       glm::transpose(glm::inverse(glm::mat3(model_matrix)));
   SetUniform("model_matrix", model_matrix);
   SetUniform("normal_matrix", normal_matrix);
+}
 
-  // Set material.
-  MaterialComponent* material_component_ptr =
-      node.GetComponentPtr<MaterialComponent>();
-  const Material* material_ptr;
-  if (material_component_ptr == nullptr) {
-    material_ptr = &Material::GetDefault();
-  } else {
-    material_ptr = &material_component_ptr->GetMaterial();
-  }
+void PhongShader::SetMaterial(const Material* material) const {
+  const Material* material_ptr =
+      material == nullptr ? &Material::GetDefault() : material;
   SetUniform("material.ambient", material_ptr->GetAmbientColor());
   SetUniform("material.diffuse", material_ptr->GetDiffuseColor());
   SetUniform("material.specular", material_ptr->GetSpecularColor());
   SetUniform("material.shininess", material_ptr->GetShininess());
-
 }
 
 void PhongShader::SetCamera(const CameraComponent& camera) const {
@@ -79,6 +79,7 @@ void PhongShader::SetLightSource(const LightComponent& component) const {
 
   // First disable all lights.
   // In a single rendering pass, only one light of one type is enabled.
+  SetUniform("clustered_lighting", false);
   SetUniform("ambient_light.enabled", false);
   SetUniform("point_light.enabled", false);
   SetUniform("directional_light.enabled", false);
@@ -110,4 +111,15 @@ void PhongShader::SetLightSource(const LightComponent& component) const {
   }
 }
 
+void PhongShader::SetLightClusters(const LightClusterGrid& clusters) const {
+  clusters.BindTextures(kLightDataTextureUnit);
+  SetUniform("clustered_lighting", true);
+  SetUniform("cluster_ambient", clusters.GetAmbientColor());
+  SetUniform("num_global_lights", clusters.GetNumGlobalLights());
+  SetUniform("cluster_dims", clusters.GetDimensions());
+  SetUniform("cluster_tile_size", clusters.GetTileSize());
+  SetUniform("cluster_near", clusters.GetNearPlane());
+  SetUniform("cluster_log_scale", clusters.GetLogDepthScale());
+}
+
 }  // namespace GLOO
@@ -7,14 +7,21 @@ namespace GLOO {
 class PhongShader : public ShaderProgram {
  public:
   PhongShader();
-  void SetTargetNode(const SceneNode& node,
-                     const glm::mat4& model_matrix) const override;
+  void SetModelMatrix(const glm::mat4& model_matrix) const override;
+  void SetMaterial(const Material* material) const override;
   void SetCamera(const CameraComponent& camera) const override;
   void SetLightSource(const LightComponent& componentt) const override;
+  void SetLightClusters(const LightClusterGrid& clusters) const override;
 
+ protected:
+  // For variants that share the Phong fragment shader.
+  explicit PhongShader(
+      const std::unordered_map<GLenum, std::string>& shader_filenames);
+  void AssociateVertexArray(VertexArray& vertex_array) const override;
 
  private:
-  void AssociateVertexArray(VertexArray& vertex_array) const;
+  // First of the three texture units holding the clustered light buffers.
+  static const int kLightDataTextureUnit = 0;
 };
 }  // namespace GLOO
 
@@ -1,5 +1,7 @@
 #include "ShaderProgram.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <stdexcept>
 #include <unordered_map>
@@ -9,24 +11,105 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <gloo/utils.hpp>
+#include "gloo/DerivedDataCache.hpp"
+#include "gloo/SceneNode.hpp"
+#include "gloo/components/RenderingComponent.hpp"
+#include "gloo/components/MaterialComponent.hpp"
+
+namespace {
+size_t next_program_id = 1;
+
+// Linked programs are cached as driver-specific binaries under the project
+// root, in at most this many bytes.
+const char kProgramCacheDir[] = "cache/shaders/";
+const uint64_t kProgramCacheBytes = 16ull << 20;
+
+// ARB_get_program_binary, core since GL 4.1. The bundled GLAD is generated
+// for GL 3.3 core without it, so its enums and entry points are declared
+// here and loaded by ShaderProgram::LoadBinaryFunctions.
+const GLenum kProgramBinaryRetrievableHint = 0x8257;
+const GLenum kProgramBinaryLength = 0x8741;
+const GLenum kNumProgramBinaryFormats = 0x87FE;
+typedef void(APIENTRYP GetProgramBinaryProc)(GLuint program,
+                                             GLsizei buf_size,
+                                             GLsizei* length,
+                                             GLenum* binary_format,
+                                             void* binary);
+typedef void(APIENTRYP ProgramBinaryProc)(GLuint program,
+                                          GLenum binary_format,
+                                          const void* binary,
+                                          GLsizei length);
+typedef void(APIENTRYP ProgramParameteriProc)(GLuint program,
+                                              GLenum pname,
+                                              GLint value);
+GetProgramBinaryProc get_program_binary = nullptr;
+ProgramBinaryProc program_binary = nullptr;
+ProgramParameteriProc program_parameteri = nullptr;
+// Whether the functions are loaded and the driver offers a binary format.
+bool supports_binaries = false;
+
+// Only used on the render thread, like the programs themselves.
+GLOO::DerivedDataCache& GetProgramCache() {
+  static GLOO::DerivedDataCache cache(
+      GLOO::GetProjectRootDir() + kProgramCacheDir, kProgramCacheBytes);
+  return cache;
+}
+
+std::string GetGLString(GLenum name) {
+  const GLubyte* str = glGetString(name);
+  return str == nullptr ? "" : reinterpret_cast<const char*>(str);
+}
+
+// Binaries only load into the driver that produced them, so the driver is
+// part of the key along with the sources. Empty if a source is missing.
+std::string MakeProgramKey(
+    const std::unordered_map<GLenum, std::string>& shader_filenames) {
+  std::vector<std::pair<GLenum, std::string>> stages(shader_filenames.begin(),
+                                                     shader_filenames.end());
+  std::sort(stages.begin(), stages.end());
+  std::vector<std::string> file_paths;
+  std::string salt = "program/";
+  for (auto& stage : stages) {
+    file_paths.push_back(GLOO::GetShaderGLSLDir() + stage.second);
+    salt += std::to_string(stage.first) + "/";
+  }
+  salt += GetGLString(GL_VENDOR) + "/" + GetGLString(GL_RENDERER) + "/" +
+          GetGLString(GL_VERSION);
+  return GLOO::DerivedDataCache::MakeKey(file_paths, salt);
+}
+}  // namespace
 
 namespace GLOO {
 ShaderProgram::ShaderProgram(
-    const std::unordered_map<GLenum, std::string>& shader_filenames) {
+    const std::unordered_map<GLenum, std::string>& shader_filenames)
+    : program_id_(next_program_id++) {
   assert(shader_filenames.count(GL_VERTEX_SHADER) == 1);
   assert(shader_filenames.count(GL_FRAGMENT_SHADER) == 1);
+  shader_program_ = glCreateProgram();
+  GL_CHECK_ERROR();
+
+  // Compiling and linking dominates startup, so linked programs are
+  // reused from earlier runs when the driver accepts them.
+  std::string key;
+  if (SupportsBinaries()) {
+    key = MakeProgramKey(shader_filenames);
+    if (!key.empty() && LoadBinary(shader_program_, key))
+      return;
+  }
+
   for (auto& kv : shader_filenames) {
     std::string shader_path = GetShaderGLSLDir() + kv.second;
     shader_handles_[kv.first] = LoadShaderFile(kv.first, shader_path);
   }
 
-  shader_program_ = glCreateProgram();
-  GL_CHECK_ERROR();
-
   for (auto& kv : shader_handles_) {
     GL_CHECK(glAttachShader(shader_program_, kv.second));
   }
 
+  if (!key.empty()) {
+    GL_CHECK(program_parameteri(shader_program_,
+                                kProgramBinaryRetrievableHint, GL_TRUE));
+  }
   GL_CHECK(glLinkProgram(shader_program_));
   GLint link_status;
   GL_CHECK(glGetProgramiv(shader_program_, GL_LINK_STATUS, &link_status));
@@ -44,6 +127,8 @@ ShaderProgram::ShaderProgram(
     GL_CHECK(glDetachShader(shader_program_, handle));
     GL_CHECK(glDeleteShader(handle));
   }
+  if (!key.empty())
+    SaveBinary(shader_program_, key);
 }
 
 ShaderProgram::~ShaderProgram() {
@@ -64,6 +149,134 @@ GLint ShaderProgram::GetAttributeLocation(const std::string& name) const {
   return loc;
 }
 
+void ShaderProgram::LinkVertexArray(VertexArray& vertex_array) const {
+  if (vertex_array.IsLinkedWith(program_id_)) {
+    return;
+  }
+  AssociateVertexArray(vertex_array);
+  vertex_array.MarkLinkedWith(program_id_);
+}
+
+void ShaderProgram::SetTargetNode(const SceneNode& node,
+                                  const glm::mat4& local_to_world_mat) const {
+  // Associate the right VAO before rendering.
+  LinkVertexArray(node.GetComponentPtr<RenderingComponent>()
+                      ->GetVertexObjectPtr()
+                      ->GetVertexArray());
+  SetModelMatrix(local_to_world_mat);
+
+  MaterialComponent* material_component_ptr =
+      node.GetComponentPtr<MaterialComponent>();
+  SetMaterial(material_component_ptr == nullptr
+                  ? nullptr
+                  : &material_component_ptr->GetMaterial());
+}
+
+GLint ShaderProgram::GetUniformLocation(const std::string& name) const {
+  auto itr = uniform_locations_.find(name);
+  if (itr != uniform_locations_.end()) {
+    return itr->second;
+  }
+  GLint loc = glGetUniformLocation(shader_program_, name.c_str());
+  GL_CHECK_ERROR();
+  uniform_locations_[name] = loc;
+  return loc;
+}
+
+void ShaderProgram::LoadBinaryFunctions(GLADloadproc load) {
+  GLint major = 0;
+  GLint minor = 0;
+  GL_CHECK(glGetIntegerv(GL_MAJOR_VERSION, &major));
+  GL_CHECK(glGetIntegerv(GL_MINOR_VERSION, &minor));
+  // Program binaries are core in GL 4.1 and an extension before.
+  bool supported = major > 4 || (major == 4 && minor >= 1);
+  GLint num_extensions = 0;
+  if (!supported) {
+    GL_CHECK(glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions));
+  }
+  for (GLint i = 0; i < num_extensions && !supported; i++) {
+    const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+    GL_CHECK_ERROR();
+    supported = extension != nullptr &&
+                std::strcmp(reinterpret_cast<const char*>(extension),
+                            "GL_ARB_get_program_binary") == 0;
+  }
+  if (!supported) {
+    return;
+  }
+  get_program_binary =
+      reinterpret_cast<GetProgramBinaryProc>(load("glGetProgramBinary"));
+  program_binary =
+      reinterpret_cast<ProgramBinaryProc>(load("glProgramBinary"));
+  program_parameteri =
+      reinterpret_cast<ProgramParameteriProc>(load("glProgramParameteri"));
+  if (get_program_binary == nullptr || program_binary == nullptr ||
+      program_parameteri == nullptr) {
+    return;
+  }
+  // Drivers may offer no binary format at all.
+  GLint num_formats = 0;
+  GL_CHECK(glGetIntegerv(kNumProgramBinaryFormats, &num_formats));
+  supports_binaries = num_formats > 0;
+}
+
+bool ShaderProgram::SupportsBinaries() {
+  return supports_binaries;
+}
+
+// Cached binaries are the GLenum format followed by the program binary.
+bool ShaderProgram::LoadBinary(GLuint program, const std::string& key) {
+  DerivedDataCache& cache = GetProgramCache();
+  std::string cached_path = cache.Find(key);
+  if (cached_path.empty())
+    return false;
+  std::ifstream ifs(cached_path, std::ios::binary);
+  std::vector<char> data(std::istreambuf_iterator<char>{ifs}, {});
+  GLenum format;
+  if (data.size() > sizeof(format)) {
+    std::memcpy(&format, data.data(), sizeof(format));
+    GL_CHECK(program_binary(program, format, data.data() + sizeof(format),
+                            (GLsizei)(data.size() - sizeof(format))));
+    GLint link_status;
+    GL_CHECK(glGetProgramiv(program, GL_LINK_STATUS, &link_status));
+    if (link_status == GL_TRUE)
+      return true;
+  }
+  // Drivers may reject their own binaries, e.g. after an update that kept
+  // the version string; the program is then compiled and cached again.
+  cache.Remove(key);
+  return false;
+}
+
+void ShaderProgram::SaveBinary(GLuint program, const std::string& key) {
+  GLint length = 0;
+  GL_CHECK(glGetProgramiv(program, kProgramBinaryLength, &length));
+  if (length <= 0)
+    return;
+  GLenum format;
+  std::vector<char> data(sizeof(format) + length);
+  GLsizei written = 0;
+  GL_CHECK(get_program_binary(program, length, &written, &format,
+                              data.data() + sizeof(format)));
+  std::memcpy(data.data(), &format, sizeof(format));
+
+  DerivedDataCache& cache = GetProgramCache();
+  std::string staging_path = cache.GetStagingPath(key);
+  {
+    std::ofstream ofs(staging_path, std::ios::binary);
+    ofs.write(data.data(), sizeof(format) + written);
+    if (!ofs) {
+      std::cerr << "WARNING: Unable to write " << staging_path << std::endl;
+      return;
+    }
+  }
+  try {
+    cache.Insert(key, staging_path);
+  } catch (const std::runtime_error& e) {
+    std::cerr << "WARNING: " << e.what() << std::endl;
+  }
+}
+
 GLuint ShaderProgram::LoadShaderFile(GLenum type, const std::string& file) {
   std::ifstream ifs(file, std::ifstream::in);
   std::string shader_code(std::istreambuf_iterator<char>{ifs}, {});
@@ -98,34 +311,41 @@ GLuint ShaderProgram::LoadShaderFile(GLenum type, const std::string& file) {
 
 void ShaderProgram::SetUniform(const std::string& name,
                                const glm::mat4& value) const {
-  GLint loc = glGetUniformLocation(shader_program_, name.c_str());
-  GL_CHECK_ERROR();
+  GLint loc = GetUniformLocation(name);
   GL_CHECK(glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value)));
 }
 
 void ShaderProgram::SetUniform(const std::string& name,
                                const glm::mat3& value) const {
-  GLint loc = glGetUniformLocation(shader_program_, name.c_str());
-  GL_CHECK_ERROR();
+  GLint loc = GetUniformLocation(name);
   GL_CHECK(glUniformMatrix3fv(loc, 1, GL_FALSE, glm::value_ptr(value)));
 }
 
 void ShaderProgram::SetUniform(const std::string& name,
                                const glm::vec3& value) const {
-  GLint loc = glGetUniformLocation(shader_program_, name.c_str());
-  GL_CHECK_ERROR();
+  GLint loc = GetUniformLocation(name);
   GL_CHECK(glUniform3fv(loc, 1, glm::value_ptr(value)));
 }
 
+void ShaderProgram::SetUniform(const std::string& name,
+                               const glm::vec2& value) const {
+  GLint loc = GetUniformLocation(name);
+  GL_CHECK(glUniform2fv(loc, 1, glm::value_ptr(value)));
+}
+
+void ShaderProgram::SetUniform(const std::string& name,
+                               const glm::ivec3& value) const {
+  GLint loc = GetUniformLocation(name);
+  GL_CHECK(glUniform3iv(loc, 1, glm::value_ptr(value)));
+}
+
 void ShaderProgram::SetUniform(const std::string& name, float value) const {
-  GLint loc = glGetUniformLocation(shader_program_, name.c_str());
-  GL_CHECK_ERROR();
+  GLint loc = GetUniformLocation(name);
   GL_CHECK(glUniform1f(loc, value));
 }
 
 void ShaderProgram::SetUniform(const std::string& name, int value) const {
-  GLint loc = glGetUniformLocation(shader_program_, name.c_str());
-  GL_CHECK_ERROR();
+  GLint loc = GetUniformLocation(name);
   GL_CHECK(glUniform1i(loc, value));
 }
 }  // namespace GLOO
@@ -14,6 +14,8 @@
 namespace GLOO {
 class CameraComponent;
 class LightComponent;
+class LightClusterGrid;
+class Material;
 class SceneNode;
 
 class ShaderProgram : public IBindable {
@@ -24,31 +26,69 @@ class ShaderProgram : public IBindable {
   void Bind() const override;
   void Unbind() const override;
   GLint GetAttributeLocation(const std::string& name) const;
+  // Unique for the lifetime of the process, unlike GL program handles.
+  size_t GetProgramId() const {
+    return program_id_;
+  }
+
+  // Links the attribute layout of vertex_array to this program. The result
+  // is cached in the vertex array, so repeated calls are free.
+  void LinkVertexArray(VertexArray& vertex_array) const;
 
   // The following Set* methods are called by the renderer, thus const.
+  // SetTargetNode is a shorthand for LinkVertexArray, SetModelMatrix and
+  // SetMaterial on the node's components.
   virtual void SetTargetNode(const SceneNode& node,
-                             const glm::mat4& local_to_world_mat) const {
+                             const glm::mat4& local_to_world_mat) const;
+  virtual void SetModelMatrix(const glm::mat4& local_to_world_mat) const {
+  }
+  // material may be null, in which case the shader's default is used.
+  virtual void SetMaterial(const Material* material) const {
   }
   virtual void SetCamera(const CameraComponent& camera) const {
   }
   virtual void SetLightSource(const LightComponent& light) const {
   }
+  // Provides all lights at once for single-pass clustered shading.
+  virtual void SetLightClusters(const LightClusterGrid& clusters) const {
+  }
+
+  // Loads the entry points of program binaries, which the bundled GLAD
+  // does not cover, with the loader GLAD was loaded with. Without this
+  // call after gladLoadGLLoader, programs are compiled on every run.
+  static void LoadBinaryFunctions(GLADloadproc load);
 
  protected:
+  // Specifies the attribute pointers of vertex_array for this program.
+  virtual void AssociateVertexArray(VertexArray& vertex_array) const {
+  }
+
   // Protected because only shader subclasses have information to the names.
   void SetUniform(const std::string& name, const glm::mat4& value) const;
   void SetUniform(const std::string& name, const glm::mat3& value) const;
   void SetUniform(const std::string& name, const glm::vec3& value) const;
+  void SetUniform(const std::string& name, const glm::vec2& value) const;
+  void SetUniform(const std::string& name, const glm::ivec3& value) const;
   void SetUniform(const std::string& name, float value) const;
   void SetUniform(const std::string& name, int value) const;
 
  private:
   static GLuint LoadShaderFile(GLenum type, const std::string& file);
+  // Linked programs are cached on disk as driver-specific binaries, keyed
+  // by the driver and the sources' contents.
+  static bool SupportsBinaries();
+  // Returns false if there is no cached binary the driver accepts.
+  static bool LoadBinary(GLuint program, const std::string& key);
+  static void SaveBinary(GLuint program, const std::string& key);
+  GLint GetUniformLocation(const std::string& name) const;
 
   const static int kErrorLogBufferSize = 512;
 
   std::unordered_map<GLenum, GLuint> shader_handles_;
   GLuint shader_program_;
+  size_t program_id_;
+  // Uniform locations are looked up once and cached by name.
+  mutable std::unordered_map<std::string, GLint> uniform_locations_;
 };
 }  // namespace GLOO
 
@@ -0,0 +1,25 @@
+#ifndef GLOO_SHADER_REGISTRY_H_
+#define GLOO_SHADER_REGISTRY_H_
+
+#include <memory>
+#include <typeinfo>
+
+#include "gloo/AssetRegistry.hpp"
+
+namespace GLOO {
+// Process-wide source of shader programs. Shader classes fix their source
+// files and take no defines, so one program per class is shared by every
+// node drawn with it, for as long as any of them is alive. Render thread
+// only, as programs are GL objects.
+class ShaderRegistry {
+ public:
+  template <class T>
+  static std::shared_ptr<T> Get() {
+    static AssetRegistry<T> registry;
+    return registry.GetOrCreate(typeid(T).name(),
+                                []() { return std::make_shared<T>(); });
+  }
+};
+}  // namespace GLOO
+
+#endif
@@ -15,11 +15,16 @@
 
 namespace GLOO {
 SimpleShader::SimpleShader()
-    : ShaderProgram(std::unordered_map<GLenum, std::string>(
+    : SimpleShader(std::unordered_map<GLenum, std::string>(
           {{GL_VERTEX_SHADER, "simple.vert"},
            {GL_FRAGMENT_SHADER, "simple.frag"}})) {
 }
 
+SimpleShader::SimpleShader(
+    const std::unordered_map<GLenum, std::string>& shader_filenames)
+    : ShaderProgram(shader_filenames) {
+}
+
 void SimpleShader::AssociateVertexArray(VertexArray& vertex_array) const {
   if (!vertex_array.HasPositionBuffer()) {
     throw std::runtime_error("Simple shader requires vertex positions!");
@@ -27,25 +32,16 @@ void SimpleShader::AssociateVertexArray(VertexArray& vertex_array) const {
   vertex_array.LinkPositionBuffer(GetAttributeLocation("vertex_position"));
 }
 
-void SimpleShader::SetTargetNode(const SceneNode& node,
-                                 const glm::mat4& model_matrix) const {
-  // Associate the right VAO before rendering.
-  AssociateVertexArray(node.GetComponentPtr<RenderingComponent>()
-                           ->GetVertexObjectPtr()
-                           ->GetVertexArray());
-
-  // Set transform.
+void SimpleShader::SetModelMatrix(const glm::mat4& model_matrix) const {
   SetUniform("model_matrix", model_matrix);
+}
 
-  // Set material.
-  MaterialComponent* material_component_ptr =
-      node.GetComponentPtr<MaterialComponent>();
-  if (material_component_ptr == nullptr) {
+void SimpleShader::SetMaterial(const Material* material) const {
+  if (material == nullptr) {
     // Default material: greenish.
     SetUniform("material_color", glm::vec3(0.0f, 0.7f, 0.2f));
   } else {
-    SetUniform("material_color",
-               material_component_ptr->GetMaterial().GetDiffuseColor());
+    SetUniform("material_color", material->GetDiffuseColor());
   }
 }
 
@@ -8,12 +8,15 @@ namespace GLOO {
 class SimpleShader : public ShaderProgram {
  public:
   SimpleShader();
-  void SetTargetNode(const SceneNode& node,
-                     const glm::mat4& model_matrix) const override;
+  void SetModelMatrix(const glm::mat4& model_matrix) const override;
+  void SetMaterial(const Material* material) const override;
   void SetCamera(const CameraComponent& camera) const override;
 
- private:
-  void AssociateVertexArray(VertexArray& vertex_array) const;
+ protected:
+  // For variants that share the simple fragment shader.
+  explicit SimpleShader(
+      const std::unordered_map<GLenum, std::string>& shader_filenames);
+  void AssociateVertexArray(VertexArray& vertex_array) const override;
 };
 }  // namespace GLOO
 
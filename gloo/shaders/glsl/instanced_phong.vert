@@ -0,0 +1,32 @@
+#version 330 core
+
+uniform mat4 model_matrix;
+uniform mat3 normal_matrix;
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+
+layout(location = 0) in vec3 vertex_position;
+layout(location = 1) in vec3 vertex_normal;
+layout(location = 2) in vec2 vertex_tex_coord;
+// Per-instance attributes, see VertexArray::LinkInstanceBuffer.
+layout(location = 3) in mat4 instance_transform;
+layout(location = 7) in vec4 vertex_instance_color;
+layout(location = 8) in mat3 instance_normal_matrix;
+
+out vec3 world_position;
+out vec3 world_normal;
+out vec2 tex_coord;
+out float view_depth;
+out vec4 instance_color;
+
+void main() {
+    world_position = vec3(model_matrix * instance_transform *
+        vec4(vertex_position, 1.0));
+    world_normal = normal_matrix * instance_normal_matrix * vertex_normal;
+
+    tex_coord = vertex_tex_coord;
+    instance_color = vertex_instance_color;
+    vec4 view_position = view_matrix * vec4(world_position, 1.0);
+    view_depth = -view_position.z;
+    gl_Position = projection_matrix * view_position;
+}
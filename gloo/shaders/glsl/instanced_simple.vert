@@ -0,0 +1,19 @@
+#version 330 core
+
+uniform mat4 model_matrix;
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+
+layout(location = 0) in vec3 vertex_position;
+// Per-instance attributes, see VertexArray::LinkInstanceBuffer.
+layout(location = 3) in mat4 instance_transform;
+layout(location = 7) in vec4 vertex_instance_color;
+
+out vec4 instance_color;
+
+void main() {
+    instance_color = vertex_instance_color;
+    vec3 world_position = vec3(model_matrix * instance_transform *
+        vec4(vertex_position, 1.0));
+    gl_Position = projection_matrix * view_matrix * vec4(world_position, 1.0);
+}
@@ -31,6 +31,8 @@ struct Material {
 in vec3 world_position;
 in vec3 world_normal;
 in vec2 tex_coord;
+in float view_depth;
+in vec4 instance_color;
 
 uniform vec3 camera_position;
 
@@ -38,9 +40,26 @@ uniform Material material; // material properties of the object
 uniform AmbientLight ambient_light;
 uniform PointLight point_light; 
 uniform DirectionalLight directional_light;
+
+// Single-pass clustered lighting. Each light takes 4 texels in light_data:
+// (position or direction, type), (diffuse, range), (specular, 0),
+// (attenuation, 0). cluster_data holds (offset, count) ranges into
+// cluster_light_indices.
+uniform bool clustered_lighting;
+uniform samplerBuffer light_data;
+uniform usamplerBuffer cluster_data;
+uniform usamplerBuffer cluster_light_indices;
+uniform vec3 cluster_ambient;
+uniform int num_global_lights;
+uniform ivec3 cluster_dims;
+uniform vec2 cluster_tile_size;
+uniform float cluster_near;
+uniform float cluster_log_scale;
+
 vec3 CalcAmbientLight();
-vec3 CalcPointLight(vec3 normal, vec3 view_dir);
-vec3 CalcDirectionalLight(vec3 normal, vec3 view_dir);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 view_dir);
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 view_dir);
+vec3 CalcClusteredLights(vec3 normal, vec3 view_dir);
 
 void main() {
     vec3 normal = normalize(world_normal);
@@ -48,37 +67,42 @@ void main() {
 
     frag_color = vec4(0.0);
 
+    if (clustered_lighting) {
+        frag_color = vec4(CalcClusteredLights(normal, view_dir), 1.0);
+        return;
+    }
+
     if (ambient_light.enabled) {
         frag_color += vec4(CalcAmbientLight(), 1.0);
     }
     
     if (point_light.enabled) {
-        frag_color += vec4(CalcPointLight(normal, view_dir), 1.0);
+        frag_color += vec4(CalcPointLight(point_light, normal, view_dir), 1.0);
     }
 
     if (directional_light.enabled) {
-        frag_color += vec4(CalcDirectionalLight(normal, view_dir), 1.0);
+        frag_color += vec4(CalcDirectionalLight(directional_light, normal,
+            view_dir), 1.0);
     }
 }
 
 vec3 GetAmbientColor() {
-    return material.ambient;
+    return material.ambient * instance_color.rgb;
 }
 
 vec3 GetDiffuseColor() {
-    return material.diffuse;
+    return material.diffuse * instance_color.rgb;
 }
 
 vec3 GetSpecularColor() {
-    return material.specular;
+    return material.specular * instance_color.rgb;
 }
 
 vec3 CalcAmbientLight() {
     return ambient_light.ambient * GetAmbientColor();
 }
 
-vec3 CalcPointLight(vec3 normal, vec3 view_dir) {
-    PointLight light = point_light;
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 view_dir) {
     vec3 light_dir = normalize(light.position - world_position);
 
     float diffuse_intensity = max(dot(normal, light_dir), 0.0);
@@ -98,8 +122,7 @@ vec3 CalcPointLight(vec3 normal, vec3 view_dir) {
     return attenuation * (diffuse_color + specular_color);
 }
 
-vec3 CalcDirectionalLight(vec3 normal, vec3 view_dir) {
-    DirectionalLight light = directional_light;
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 view_dir) {
     vec3 light_dir = normalize(-light.direction);
     float diffuse_intensity = max(dot(normal, light_dir), 0.0);
     vec3 diffuse_color = diffuse_intensity * light.diffuse * GetDiffuseColor();
@@ -114,3 +137,38 @@ vec3 CalcDirectionalLight(vec3 normal, vec3 view_dir) {
     return final_color;
 }
 
+vec3 CalcPackedLight(int index, vec3 normal, vec3 view_dir) {
+    vec4 position_type = texelFetch(light_data, index * 4);
+    vec4 diffuse_range = texelFetch(light_data, index * 4 + 1);
+    vec4 specular = texelFetch(light_data, index * 4 + 2);
+    if (position_type.w > 0.5) {
+        DirectionalLight light = DirectionalLight(true, position_type.xyz,
+            diffuse_range.rgb, specular.rgb);
+        return CalcDirectionalLight(light, normal, view_dir);
+    }
+    vec4 attenuation = texelFetch(light_data, index * 4 + 3);
+    PointLight light = PointLight(true, position_type.xyz, diffuse_range.rgb,
+        specular.rgb, attenuation.xyz);
+    return CalcPointLight(light, normal, view_dir);
+}
+
+vec3 CalcClusteredLights(vec3 normal, vec3 view_dir) {
+    vec3 color = cluster_ambient * GetAmbientColor();
+    for (int i = 0; i < num_global_lights; i++) {
+        color += CalcPackedLight(i, normal, view_dir);
+    }
+
+    ivec2 tile = ivec2(gl_FragCoord.xy / cluster_tile_size);
+    int slice = int(max(log(view_depth / cluster_near), 0.0) *
+        cluster_log_scale);
+    ivec3 cell = clamp(ivec3(tile, slice), ivec3(0), cluster_dims - 1);
+    int cluster = (cell.z * cluster_dims.y + cell.y) * cluster_dims.x + cell.x;
+
+    uvec2 range = texelFetch(cluster_data, cluster).xy;
+    for (uint k = 0u; k < range.y; k++) {
+        int light_index = int(texelFetch(cluster_light_indices,
+            int(range.x + k)).x);
+        color += CalcPackedLight(light_index, normal, view_dir);
+    }
+    return color;
+}
@@ -12,6 +12,8 @@ layout(location = 2) in vec2 vertex_tex_coord;
 out vec3 world_position;
 out vec3 world_normal;
 out vec2 tex_coord;
+out float view_depth;
+out vec4 instance_color;
 
 void main() {
     world_position = vec3(model_matrix * 
@@ -19,5 +21,8 @@ void main() {
     world_normal = normal_matrix * vertex_normal;
 
     tex_coord = vertex_tex_coord;
-    gl_Position = projection_matrix * view_matrix * vec4(world_position, 1.0);
+    instance_color = vec4(1.0);
+    vec4 view_position = view_matrix * vec4(world_position, 1.0);
+    view_depth = -view_position.z;
+    gl_Position = projection_matrix * view_position;
 }
@@ -1,9 +1,11 @@
 #version 330 core
 
+in vec4 instance_color;
+
 out vec4 frag_color;
 
 uniform vec3 material_color; 
 
 void main() {
-    frag_color = vec4(material_color, 1.0);
+    frag_color = vec4(material_color * instance_color.rgb, 1.0);
 }
@@ -6,7 +6,10 @@ uniform mat4 projection_matrix;
 
 layout(location = 0) in vec3 vertex_position;
 
+out vec4 instance_color;
+
 void main() {
+    instance_color = vec4(1.0);
     vec3 world_position = vec3(model_matrix * vec4(vertex_position, 1.0));
     gl_Position = projection_matrix * view_matrix * vec4(world_position, 1.0);
 }
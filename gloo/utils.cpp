@@ -1,6 +1,7 @@
 #include "utils.hpp"
 
 #include <cstdio>
+#include <cstdlib>
 
 #include <iostream>
 #include <fstream>
@@ -68,4 +69,26 @@ std::string GetAssetDir() {
   return GetProjectRootDir() + "assets/";
 }
 
+std::string GetCanonicalPath(const std::string& path) {
+#ifdef _WIN32
+  char* resolved = _fullpath(nullptr, path.c_str(), 0);
+#else
+  char* resolved = realpath(path.c_str(), nullptr);
+#endif
+  if (resolved != nullptr) {
+    std::string canonical = resolved;
+    free(resolved);
+    return canonical;
+  }
+  std::string base_path = GetBasePath(path);
+  if (base_path.empty() || base_path.size() == path.size())
+    return path;
+  // Keeps the separator, as GetBasePath does.
+  std::string canonical_base =
+      GetCanonicalPath(base_path.substr(0, base_path.size() - 1));
+  if (canonical_base == base_path.substr(0, base_path.size() - 1))
+    return path;
+  return canonical_base + path.substr(base_path.size() - 1);
+}
+
 }  // namespace GLOO
@@ -50,6 +50,12 @@ std::string GetProjectRootDir();
 std::string GetShaderGLSLDir();
 std::string GetAssetDir();
 
+// Absolute path without symbolic links or "." and ".." components, so that
+// different spellings of one file compare equal. A path that does not
+// exist is resolved through its base directory; one that cannot be
+// resolved at all is returned unchanged.
+std::string GetCanonicalPath(const std::string& path);
+
 // C++11 does not have make_unique sadly; it appeared in C++14.
 // MSVC already has make_unique defined.
 #ifdef _WIN32
@@ -8,7 +8,9 @@
 #include "gloo/components/ShadingComponent.hpp"
 #include "gloo/components/MaterialComponent.hpp"
 #include "gloo/debug/PrimitiveFactory.hpp"
+#include "gloo/debug/Profiler.hpp"
 #include "gloo/shaders/PhongShader.hpp"
+#include "gloo/shaders/ShaderRegistry.hpp"
 
 namespace GLOO {
 	MousePicker::MousePicker(Scene* scene, ArcBallCameraNode* camera, SkeletonNode* skeleton) : SceneNode() {
@@ -21,8 +23,8 @@ namespace GLOO {
 		camera_pos_ = glm::vec3(0.0f);
 		sphere_hit_ = nullptr;
 		auto selected_node = make_unique<SceneNode>();
-		selected_node->CreateComponent<ShadingComponent>(std::make_shared<PhongShader>());
-		selected_node->CreateComponent<RenderingComponent>(PrimitiveFactory::CreateSphere(0.026f, 25, 25));
+		selected_node->CreateComponent<ShadingComponent>(ShaderRegistry::Get<PhongShader>());
+		selected_node->CreateComponent<RenderingComponent>(PrimitiveFactory::GetSphere(0.026f, 25, 25));
 		glm::vec3 color(0.0f, 1.0f, 0.0f);
 		auto material = std::make_shared<Material>(color, color, color, 0);
 		selected_node->CreateComponent<MaterialComponent>(material);
@@ -58,7 +60,15 @@ namespace GLOO {
 				}
 				
 				if (!rotating_) {
-					auto new_sphere = FindSphereHit(current_ray_, skeleton_ptr_->GetSpherePtrs());
+					SceneNode* new_sphere;
+					{
+						ScopedTimer timer("Joint picking");
+						new_sphere = skeleton_ptr_->PickJointSphere(camera_pos_, current_ray_);
+					}
+					if (new_sphere == nullptr) {
+						ScopedTimer timer("Mesh picking");
+						new_sphere = skeleton_ptr_->PickMeshJoint(camera_pos_, current_ray_);
+					}
 					if (new_sphere != nullptr) {
 						if (sphere_hit_ != nullptr) {
 							int num_children = sphere_hit_->GetChildrenCount();
@@ -138,7 +148,7 @@ namespace GLOO {
 	void MousePicker::CastRay(glm::vec3 ray) {
 		//std::cout << "Casting Ray" << std::endl;
 		auto line = std::make_shared<VertexObject>();
-		auto line_shader = std::make_shared<SimpleShader>();
+		auto line_shader = ShaderRegistry::Get<SimpleShader>();
 		auto indices = IndexArray();
 		indices.push_back(0);
 		indices.push_back(1);
@@ -149,8 +159,8 @@ namespace GLOO {
 		float length = 10.0f;
 
 		auto sphere_node = make_unique<SceneNode>();
-		sphere_node->CreateComponent<ShadingComponent>(std::make_shared<PhongShader>());
-		sphere_node->CreateComponent<RenderingComponent>(PrimitiveFactory::CreateSphere(0.005f, 25, 25));
+		sphere_node->CreateComponent<ShadingComponent>(ShaderRegistry::Get<PhongShader>());
+		sphere_node->CreateComponent<RenderingComponent>(PrimitiveFactory::GetSphere(0.005f, 25, 25));
 		sphere_node->GetTransform().SetPosition(pos);
 		AddChild(std::move(sphere_node));
 
@@ -169,34 +179,17 @@ namespace GLOO {
 		AddChild(std::move(line_node));
 	}
 
-	SceneNode* MousePicker::FindSphereHit(glm::vec3 ray, std::vector<SceneNode*> nodes) {
+	SceneNode* MousePicker::FindSphereHit(glm::vec3 ray, const std::vector<SceneNode*>& nodes) {
 		SceneNode* sphere_hit_ptr = nullptr;
-		std::vector<float> sphere_hit_distances;
-		std::vector<SceneNode*> sphere_hit_ptrs;
-		bool hit_registered = false;
+		float nearest_dist = 0.0f;
 		for (auto sphere_ptr : nodes) {
 			float sphere_dist = CheckCollision(ray, sphere_ptr);
-			//std::cout << sphere_dist << std::endl;
-			if (sphere_dist >= 0) {
-				hit_registered = true;
-				sphere_hit_distances.push_back(sphere_dist);
-				sphere_hit_ptrs.push_back(sphere_ptr);
+			if (sphere_dist >= 0 && (sphere_hit_ptr == nullptr || sphere_dist < nearest_dist)) {
+				nearest_dist = sphere_dist;
+				sphere_hit_ptr = sphere_ptr;
 			}
 		}
-		if (hit_registered) {
-			float nearest_dist = sphere_hit_distances[0];
-			auto nearest_sphere = sphere_hit_ptrs[0];
-			for (int i = 1; i < sphere_hit_distances.size(); i++) {
-				if (sphere_hit_distances[i] < nearest_dist) {
-					nearest_dist = sphere_hit_distances[i];
-					nearest_sphere = sphere_hit_ptrs[i];
-				}
-			}
-			sphere_hit_ptr = nearest_sphere;
-		}
-		
 		return sphere_hit_ptr;
-
 	}
 
 	
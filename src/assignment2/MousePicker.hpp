@@ -25,7 +25,7 @@ namespace GLOO {
         glm::vec2 GetNormalizedDeviceCoords(glm::vec2 mouse_position);
         glm::vec4 GetEyeCoords(glm::vec4 clip_coords);
         glm::vec3 GetWorldCoords(glm::vec4 eye_coords);
-        SceneNode* FindSphereHit(glm::vec3 ray, std::vector<SceneNode*> nodes);
+        SceneNode* FindSphereHit(glm::vec3 ray, const std::vector<SceneNode*>& nodes);
         void RotateJoint(SceneNode* node, int axis, float amount);
         float CheckCollision(glm::vec3 ray, SceneNode* sphere);
         void RotateGizmo(glm::dvec2 pos, SceneNode* node, int axis);
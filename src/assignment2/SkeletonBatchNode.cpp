@@ -0,0 +1,117 @@
+#include "SkeletonBatchNode.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "gloo/utils.hpp"
+#include "gloo/debug/PrimitiveFactory.hpp"
+#include "gloo/components/RenderingComponent.hpp"
+#include "gloo/components/ShadingComponent.hpp"
+#include "gloo/components/MaterialComponent.hpp"
+#include "gloo/shaders/InstancedPhongShader.hpp"
+#include "gloo/shaders/InstancedSimpleShader.hpp"
+#include "gloo/shaders/ShaderRegistry.hpp"
+#include "SkeletonNode.hpp"
+
+namespace {
+bool IsEqual(const GLOO::InstanceData& a, const GLOO::InstanceData& b) {
+  return std::memcmp(&a, &b, sizeof(GLOO::InstanceData)) == 0;
+}
+
+// Uploads the range of instances that differs from the last upload, if
+// any. Joints not moving since the last frame are not uploaded again.
+void UploadChanged(GLOO::VertexObject& mesh,
+                   const GLOO::InstanceArray& instances) {
+  if (!mesh.HasInstances() ||
+      mesh.GetInstances().size() != instances.size()) {
+    mesh.UpdateInstances(instances, 0, instances.size());
+    return;
+  }
+  const GLOO::InstanceArray& uploaded = mesh.GetInstances();
+  size_t first = 0;
+  size_t end = instances.size();
+  while (first < end && IsEqual(uploaded[first], instances[first])) {
+    first++;
+  }
+  while (end > first && IsEqual(uploaded[end - 1], instances[end - 1])) {
+    end--;
+  }
+  if (first < end) {
+    mesh.UpdateInstances(instances, first, end - first);
+  }
+}
+}  // namespace
+
+namespace GLOO {
+SkeletonBatchNode::SkeletonBatchNode() : SceneNode() {
+  // Not shared with other nodes, as they hold this node's instances.
+  meshes_[size_t(Batch::Joints)] =
+      PrimitiveFactory::CreateSphere(0.025f, 25, 25);
+  meshes_[size_t(Batch::Bones)] =
+      PrimitiveFactory::CreateCylinder(0.015f, 1, 25);
+  meshes_[size_t(Batch::GizmoSpheres)] =
+      PrimitiveFactory::CreateSphere(0.01f, 25, 25);
+  // A segment along x; each gizmo line instance rotates it onto its axis.
+  float length = .05f;
+  meshes_[size_t(Batch::GizmoLines)] = PrimitiveFactory::CreateLineSegment(
+      glm::vec3(-1.f * length, 0.f, 0.f), glm::vec3(1.f * length, 0.f, 0.f));
+  // Create the instance buffers before the first frame links the VAOs.
+  UpdateInstances();
+
+  auto instanced_phong = ShaderRegistry::Get<InstancedPhongShader>();
+  // Gizmo colors come from the instances; white keeps them unchanged.
+  glm::vec3 white(1.0f);
+  auto gizmo_material = std::make_shared<Material>(white, white, white, 0);
+  for (size_t b = 0; b < kNumBatches; b++) {
+    auto batch_node = make_unique<SceneNode>();
+    auto& rc = batch_node->CreateComponent<RenderingComponent>(meshes_[b]);
+    if (b == size_t(Batch::GizmoLines)) {
+      batch_node->CreateComponent<ShadingComponent>(
+          ShaderRegistry::Get<InstancedSimpleShader>());
+      rc.SetDrawMode(DrawMode::Lines);
+    } else {
+      batch_node->CreateComponent<ShadingComponent>(instanced_phong);
+    }
+    if (b == size_t(Batch::GizmoSpheres) || b == size_t(Batch::GizmoLines)) {
+      batch_node->CreateComponent<MaterialComponent>(gizmo_material);
+    }
+    AddChild(std::move(batch_node));
+  }
+}
+
+SkeletonBatchNode::~SkeletonBatchNode() {
+  // SetBatches calls Remove, which modifies skeletons_.
+  std::vector<SkeletonNode*> skeletons = skeletons_;
+  for (SkeletonNode* skeleton : skeletons) {
+    skeleton->SetBatches(nullptr);
+  }
+}
+
+void SkeletonBatchNode::Add(SkeletonNode& skeleton) {
+  skeletons_.push_back(&skeleton);
+}
+
+void SkeletonBatchNode::Remove(SkeletonNode& skeleton) {
+  skeletons_.erase(
+      std::remove(skeletons_.begin(), skeletons_.end(), &skeleton),
+      skeletons_.end());
+}
+
+void SkeletonBatchNode::Update(double delta_time) {
+  // Gizmo visibility changes without a joint change, so the instances are
+  // refreshed every frame.
+  UpdateInstances();
+}
+
+void SkeletonBatchNode::UpdateInstances() {
+  for (InstanceArray& instances : instances_) {
+    instances.clear();
+  }
+  for (SkeletonNode* skeleton : skeletons_) {
+    skeleton->AppendInstances(*this);
+  }
+  for (size_t b = 0; b < kNumBatches; b++) {
+    UploadChanged(*meshes_[b], instances_[b]);
+  }
+}
+}  // namespace GLOO
@@ -0,0 +1,44 @@
+#ifndef SKELETON_BATCH_NODE_H_
+#define SKELETON_BATCH_NODE_H_
+
+#include "gloo/SceneNode.hpp"
+#include "gloo/VertexObject.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace GLOO {
+class SkeletonNode;
+
+// Draws the joints, bones and gizmos of every SkeletonNode registered with
+// it in one instanced draw call per batch, however many characters the
+// scene holds. Add it to the scene after the skeletons, so that its Update
+// sees the joint edits of the same frame.
+class SkeletonBatchNode : public SceneNode {
+ public:
+  enum class Batch { Joints, Bones, GizmoSpheres, GizmoLines };
+  static const size_t kNumBatches = 4;
+
+  SkeletonBatchNode();
+  // Unregisters the skeletons still registered.
+  ~SkeletonBatchNode();
+  // Use SkeletonNode::SetBatches, which keeps both sides in sync.
+  void Add(SkeletonNode& skeleton);
+  void Remove(SkeletonNode& skeleton);
+  void Update(double delta_time) override;
+  // Collects and uploads the instances of all skeletons, for callers that
+  // render without updating the scene.
+  void UpdateInstances();
+  // Instances are relative to this node.
+  InstanceArray& GetInstances(Batch batch) {
+    return instances_[static_cast<size_t>(batch)];
+  }
+
+ private:
+  std::vector<SkeletonNode*> skeletons_;
+  std::shared_ptr<VertexObject> meshes_[kNumBatches];
+  InstanceArray instances_[kNumBatches];
+};
+}  // namespace GLOO
+
+#endif
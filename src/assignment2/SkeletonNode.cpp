@@ -1,25 +1,226 @@
 #include "SkeletonNode.hpp"
 
+#include "SkeletonBatchNode.hpp"
 #include "gloo/utils.hpp"
 #include "gloo/InputManager.hpp"
-#include "gloo/MeshLoader.hpp"
 #include "gloo/debug/PrimitiveFactory.hpp"
+#include "gloo/debug/Profiler.hpp"
 #include "gloo/components/RenderingComponent.hpp"
 #include "gloo/components/ShadingComponent.hpp"
 #include "gloo/components/MaterialComponent.hpp"
 #include "gloo/shaders/PhongShader.hpp"
-#include "gloo/shaders/SimpleShader.hpp"
-#include <fstream>
+#include "gloo/shaders/ShaderRegistry.hpp"
 #include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+const glm::vec3 kGizmoColors[3] = {glm::vec3(1.0f, 0.f, 0.f),
+                                   glm::vec3(0.0f, 1.f, 0.f),
+                                   glm::vec3(0.0f, 0.f, 1.f)};
+// Rotate the x-aligned gizmo line onto the y, z and x axes respectively.
+const glm::mat4 kGizmoLineBases[3] = {
+    glm::mat4(glm::vec4(0.f, 1.f, 0.f, 0.f), glm::vec4(0.f, 0.f, 1.f, 0.f),
+              glm::vec4(1.f, 0.f, 0.f, 0.f), glm::vec4(0.f, 0.f, 0.f, 1.f)),
+    glm::mat4(glm::vec4(0.f, 0.f, 1.f, 0.f), glm::vec4(1.f, 0.f, 0.f, 0.f),
+              glm::vec4(0.f, 1.f, 0.f, 0.f), glm::vec4(0.f, 0.f, 0.f, 1.f)),
+    glm::mat4(1.0f)};
+
+// Render thread time spent per frame on uploading a loaded character.
+const double kUploadBudgetMs = 4.0;
+// Vertices of the bind mesh packed and uploaded per step, small enough to
+// stay well within the budget.
+const size_t kUploadChunkVertices = 1 << 14;
+
+GLOO::InstanceData MakeInstance(const glm::mat4& transform,
+                                const glm::vec4& color) {
+  GLOO::InstanceData instance;
+  instance.transform = transform;
+  instance.color = color;
+  instance.normal_matrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+  return instance;
+}
+}  // namespace
 
 namespace GLOO {
 SkeletonNode::SkeletonNode(const std::string& filename)
-    : SceneNode(), draw_mode_(DrawMode::Skeleton) {
-  LoadAllFiles(filename);
-  DecorateTree();
+    : SceneNode(),
+      draw_mode_(DrawMode::Skeleton),
+      batches_(nullptr),
+      load_progress_(MeshLoader::GetCharacterProgress(filename)),
+      placeholder_ptr_(nullptr),
+      loaded_(false),
+      last_pose_id_(0),
+      skinned_pose_id_(0),
+      pose_pending_(false),
+      stop_skinning_(false) {
+  // Parsing a large character takes seconds, so it runs on another thread
+  // while the first frames show a placeholder.
+  // Nodes showing the same files share the load and the character.
+  pending_character_ = std::async(std::launch::async, [filename]() {
+    return MeshLoader::ImportCharacterShared(filename);
+  });
+
+  auto placeholder = make_unique<SceneNode>();
+  placeholder->CreateComponent<ShadingComponent>(
+      ShaderRegistry::Get<PhongShader>());
+  placeholder->CreateComponent<RenderingComponent>(
+      PrimitiveFactory::GetSphere(0.1f, 25, 25));
+  placeholder_ptr_ = placeholder.get();
+  AddChild(std::move(placeholder));
+}
+
+SkeletonNode::~SkeletonNode() {
+  SetBatches(nullptr);
+  StopSkinningThread();
+}
+
+void SkeletonNode::SetBatches(SkeletonBatchNode* batches) {
+  if (batches_ != nullptr)
+    batches_->Remove(*this);
+  batches_ = batches;
+  if (batches_ != nullptr)
+    batches_->Add(*this);
+}
+
+void SkeletonNode::WaitForLoad() {
+  if (loaded_)
+    return;
+  if (pending_character_.valid()) {
+    loaded_character_ = pending_character_.get();
+    QueueUploads();
+  }
+  uploads_.Flush();
+  WaitForSkinning();
+}
+
+void SkeletonNode::PollLoading() {
+  if (pending_character_.valid() &&
+      pending_character_.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+    // Rethrows what the loading thread threw.
+    loaded_character_ = pending_character_.get();
+    QueueUploads();
+  }
+  uploads_.Run(kUploadBudgetMs);
+  if (!loaded_ && uploads_.GetNumPushed() > 0) {
+    load_progress_->Report("Uploading",
+                           0.9f + 0.1f * uploads_.GetNumFinished() /
+                                      uploads_.GetNumPushed());
+  }
+}
+
+void SkeletonNode::QueueUploads() {
+  character_ = loaded_character_->view;
+  uploads_.Push([this]() {
+    LoadSkeleton();
+    return true;
+  });
+  uploads_.Push([this]() {
+    LoadMesh();
+    return true;
+  });
+  // Also finishes an upload that another node sharing the mesh started.
+  uploads_.Push([this]() {
+    return bind_mesh_->UploadVertices(kUploadChunkVertices);
+  });
+  uploads_.Push([this]() {
+    DecorateTree();
+    return true;
+  });
+  uploads_.Push([this]() {
+    placeholder_ptr_->SetActive(false);
+    StartSkinningThread();
+    loaded_ = true;
+    // Force initial update, with the slider values set while loading.
+    OnJointChanged(false);
+    return true;
+  });
+}
 
-  // Force initial update.
-  OnJointChanged(false);
+void SkeletonNode::StartSkinningThread() {
+  skinning_thread_ = std::thread(&SkeletonNode::SkinningLoop, this);
+}
+
+void SkeletonNode::StopSkinningThread() {
+  {
+    std::lock_guard<std::mutex> lock(skinning_mutex_);
+    stop_skinning_ = true;
+  }
+  pose_posted_.notify_one();
+  if (skinning_thread_.joinable())
+    skinning_thread_.join();
+}
+
+void SkeletonNode::SkinningLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(skinning_mutex_);
+      pose_posted_.wait(lock,
+                        [this] { return pose_pending_ || stop_skinning_; });
+      if (stop_skinning_)
+        return;
+      pose_pending_ = false;
+    }
+    // Poses posted while the previous one was being skinned are skipped;
+    // only the newest matters.
+    if (!poses_.Acquire())
+      continue;
+    const PoseSnapshot& pose = poses_.GetReadBuffer();
+
+    auto start = std::chrono::steady_clock::now();
+    SkinnedSnapshot& skinned = skinned_meshes_.GetWriteBuffer();
+    ComputeNewPositions(pose.skinning_matrices, skinned.positions);
+    CalculateNormals(skinned.positions, skinned.normals);
+    if (skinned.bvh.IsEmpty()) {
+      skinned.bvh.Build(skinned.positions, loaded_character_->mesh_indices);
+    } else {
+      skinned.bvh.Refit(skinned.positions);
+    }
+    skinned.pose_id = pose.pose_id;
+    std::chrono::duration<float, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    skinned.skinning_ms = elapsed.count();
+    skinned_meshes_.Publish();
+
+    {
+      std::lock_guard<std::mutex> lock(skinning_mutex_);
+      skinned_pose_id_ = pose.pose_id;
+    }
+    pose_skinned_.notify_all();
+  }
+}
+
+void SkeletonNode::WaitForSkinning() {
+  {
+    std::unique_lock<std::mutex> lock(skinning_mutex_);
+    pose_skinned_.wait(lock,
+                       [this] { return skinned_pose_id_ >= last_pose_id_; });
+  }
+  UploadSkinnedSnapshot();
+}
+
+void SkeletonNode::UploadSkinnedSnapshot() {
+  if (!skinned_meshes_.Acquire())
+    return;
+  // The GL upload stays on this thread, which owns the context.
+  SkinnedSnapshot& skinned = skinned_meshes_.GetReadBuffer();
+  if (skinned_mesh_ == nullptr) {
+    skinned_mesh_ = std::make_shared<VertexObject>(VertexLayout::Interleaved);
+    // Skinned positions and normals are re-uploaded on every pose change.
+    skinned_mesh_->SetBufferUsage(BufferUsage::StreamRing);
+    skinned_mesh_->ShareIndices(*bind_mesh_);
+    ssd_ptr_->GetComponentPtr<RenderingComponent>()->SetVertexObject(
+        skinned_mesh_);
+  }
+  // One repack, upload and ring advance per pose. The arrays are swapped
+  // with the previous pose's rather than copied, so the skinning thread
+  // refills full-size arrays without allocating. Picking only reads the
+  // snapshot's BVH.
+  skinned_mesh_->SwapPositionsAndNormals(skinned.positions, skinned.normals);
+  Profiler::GetInstance().Record("Skinning (worker thread)", false,
+                                 skinned.skinning_ms);
 }
 
 void SkeletonNode::ToggleDrawMode() {
@@ -30,23 +231,63 @@ void SkeletonNode::ToggleDrawMode() {
   // Hint: you may find SceneNode::SetActive convenient here as
   // inactive nodes will not be picked up by the renderer.
 
-  if (draw_mode_ == DrawMode::SSD) {
-      for (auto joint : joint_ptrs_) {
-          joint->SetActive(false);
-      }
-      ssd_ptr_->SetActive(true);
+  // The skeleton view stops appending to the shared batches in SSD mode.
+  ssd_ptr_->SetActive(draw_mode_ == DrawMode::SSD);
+}
+
+SceneNode* SkeletonNode::PickJointSphere(const glm::vec3& origin,
+                                         const glm::vec3& direction) const {
+  float t;
+  int sphere = picking_bvh_.Intersect(origin, direction, t);
+  return sphere == -1 ? nullptr : sphere_nodes_ptrs_[sphere];
+}
+
+SceneNode* SkeletonNode::PickMeshJoint(const glm::vec3& origin,
+                                       const glm::vec3& direction) const {
+  if (draw_mode_ != DrawMode::SSD)
+    return nullptr;
+  // The snapshot last uploaded is the one on screen.
+  const SkinnedSnapshot& skinned = skinned_meshes_.GetReadBuffer();
+  glm::mat4 world_to_local =
+      glm::inverse(GetTransform().GetLocalToWorldMatrix());
+  glm::vec3 local_origin = glm::vec3(world_to_local * glm::vec4(origin, 1.0f));
+  glm::vec3 local_direction =
+      glm::vec3(world_to_local * glm::vec4(direction, 0.0f));
+  RayHit hit;
+  if (!skinned.bvh.Intersect(local_origin, local_direction, hit))
+    return nullptr;
+
+  // Interpolate the weights of the triangle's vertices to the hit point.
+  const unsigned int* triangle =
+      &loaded_character_->mesh_indices[3 * hit.triangle];
+  float barycentrics[3] = {1.0f - hit.u - hit.v, hit.u, hit.v};
+  std::vector<float> bone_weights(b_matrices.size(), 0.0f);
+  for (int c = 0; c < 3; c++) {
+    for (uint32_t i = character_.influence_offsets[triangle[c]];
+         i < character_.influence_offsets[triangle[c] + 1]; i++) {
+      const JointInfluence& influence = character_.influences[i];
+      bone_weights[influence.bone] += barycentrics[c] * influence.weight;
+    }
   }
-  else {
-      for (auto joint : joint_ptrs_) {
-          joint->SetActive(true);
-      }
-      ssd_ptr_->SetActive(false);
+  int best_joint = -1;
+  float best_weight = 0.0f;
+  for (size_t j = 0; j < bone_weights.size(); j++) {
+    if (bone_weights[j] > best_weight) {
+      best_weight = bone_weights[j];
+      // Bone j belongs to joint j + 1, as the root has no bone.
+      best_joint = static_cast<int>(j) + 1;
+    }
   }
-  
-}
 
-std::vector<SceneNode*> SkeletonNode::GetSpherePtrs() {
-    return sphere_nodes_ptrs_;
+  // Joints sharing a position with another one have no sphere of their
+  // own; select the closest ancestor that does.
+  for (int joint = best_joint; joint != -1; joint = joint_parents_[joint]) {
+    for (size_t i = 0; i < sphere_joint_indices_.size(); i++) {
+      if (sphere_joint_indices_[i] == joint)
+        return sphere_nodes_ptrs_[i];
+    }
+  }
+  return nullptr;
 }
 
 void SkeletonNode::DecorateTree() {
@@ -58,9 +299,9 @@ void SkeletonNode::DecorateTree() {
   // only need to update the VertexObject - updating vertex positions and
   // recalculating the normals, etc.).
 
-    shader_ = std::make_shared<PhongShader>();
-    sphere_mesh_ = PrimitiveFactory::CreateSphere(0.025f, 25, 25);
-    cylinder_mesh_ = PrimitiveFactory::CreateCylinder(0.015f, 1, 25);
+    shader_ = ShaderRegistry::Get<PhongShader>();
+    // Joints, bones and gizmos are plain transform nodes used for picking;
+    // they are drawn by the batches passed to SetBatches.
     std::vector<glm::vec3> origins;
     for (int i = 0; i < joint_ptrs_.size(); i++) {
         int child_count = joint_ptrs_[i]->GetChildrenCount();
@@ -69,10 +310,9 @@ void SkeletonNode::DecorateTree() {
         if (!(check_exists) && check_zero) {
             origins.push_back(joint_ptrs_[i]->GetTransform().GetPosition());
             auto sphere_node = make_unique<SceneNode>();
-            sphere_node->CreateComponent<ShadingComponent>(shader_);
-            sphere_node->CreateComponent<RenderingComponent>(sphere_mesh_);
             auto sphere_node_ptr = sphere_node.get();
             sphere_nodes_ptrs_.push_back(sphere_node_ptr);
+            sphere_joint_indices_.push_back(i);
             joint_ptrs_[i]->AddChild(std::move(sphere_node));
 
             std::vector<glm::vec3> offsets;
@@ -81,57 +321,12 @@ void SkeletonNode::DecorateTree() {
             offsets.push_back(glm::vec3(0.0f, 1.0f * scale, 0.0f));
             offsets.push_back(glm::vec3(0.0f, 0.0f, 1.0f * scale));
 
-            std::vector<glm::vec3> color;
-            color.push_back(glm::vec3(1.0f, 0.f, 0.f));
-            color.push_back(glm::vec3(0.0f, 1.f, 0.f));
-            color.push_back(glm::vec3(0.0f, 0.f, 1.f));
-
             for (int num = 0; num < 3; num++) {
                 auto small_sphere_node = make_unique<SceneNode>();
-                small_sphere_node->CreateComponent<ShadingComponent>(shader_);
-                small_sphere_node->CreateComponent<RenderingComponent>(PrimitiveFactory::CreateSphere(0.01f, 25, 25));
                 small_sphere_node->GetTransform().SetPosition(offsets[num]);
-                auto material = std::make_shared<Material>(color[num], color[num], color[num], 0);
-                small_sphere_node->CreateComponent<MaterialComponent>(material);
                 small_sphere_node->SetActive(false);
                 small_sphere_node->SetGizmoAxis(num);
 
-                auto line = std::make_shared<VertexObject>();
-                auto line_shader = std::make_shared<SimpleShader>();
-                auto indices = IndexArray();
-                indices.push_back(0);
-                indices.push_back(1);
-                line->UpdateIndices(make_unique<IndexArray>(indices));
-                auto positions = make_unique<PositionArray>();
-                float length = .05f;
-                if (num == 0) {
-                    positions->push_back(glm::vec3(0.f, -1.f * length, 0.f));
-                    positions->push_back(glm::vec3(0.f, 1.f * length, 0.f));
-                }
-                else if (num == 1) {
-                    positions->push_back(glm::vec3(0.f, 0.f, -1.f * length));
-                    positions->push_back(glm::vec3(0.f, 0.f, 1.f * length));
-                }
-                else {
-                    positions->push_back(glm::vec3(-1.f * length, 0.f, 0.f));
-                    positions->push_back(glm::vec3(1.f * length, 0.f, 0.f));
-                }
-                
-                line->UpdatePositions(std::move(positions));
-
-                auto line_node = make_unique<SceneNode>();
-                line_node->CreateComponent<ShadingComponent>(line_shader);
-                auto& rc_line = line_node->CreateComponent<RenderingComponent>(line);
-                rc_line.SetDrawMode(GLOO::DrawMode::Lines);
-                auto material_new = std::make_shared<Material>(color[num], color[num], color[num], 0.0f);
-                line_node->CreateComponent<MaterialComponent>(material);
-
-
-                small_sphere_node->AddChild(std::move(line_node));
-
-
-
-
                 sphere_node_ptr->AddToGizmoPtrs(small_sphere_node.get());
                 sphere_node_ptr->AddChild(std::move(small_sphere_node));
             }
@@ -146,8 +341,6 @@ void SkeletonNode::DecorateTree() {
             if (!check_child_exists && check_child_zero) {
                 child_origins.push_back(joint_ptrs_[i]->GetChild(j).GetTransform().GetPosition());
                 auto cylinder_node = make_unique<SceneNode>();
-                cylinder_node->CreateComponent<ShadingComponent>(shader_);
-                cylinder_node->CreateComponent<RenderingComponent>(cylinder_mesh_);
 
                 glm::vec3 joint_pos = joint_ptrs_[i]->GetChild(j).GetTransform().GetPosition();
                 float height = glm::length(joint_pos);
@@ -159,15 +352,15 @@ void SkeletonNode::DecorateTree() {
                 cylinder_node->GetTransform().SetRotation(rot_axis, rot_angle);
 
                 cylinder_nodes_ptrs_.push_back(cylinder_node.get());
+                cylinder_joint_indices_.push_back(i);
                 joint_ptrs_[i]->AddChild(std::move(cylinder_node));
             }
         }
     }
-    
-    
+
     auto mesh_node = make_unique<SceneNode>();
     mesh_node->CreateComponent<ShadingComponent>(shader_);
-    mesh_node->CreateComponent<RenderingComponent>(bind_pose_mesh_);
+    mesh_node->CreateComponent<RenderingComponent>(bind_mesh_);
     mesh_node->CreateComponent<MaterialComponent>(std::make_shared<Material>(Material::GetDefault()));
     glm::vec3 color = glm::vec3(.7f);
     mesh_node->GetComponentPtr<MaterialComponent>()->GetMaterial().SetAmbientColor(color);
@@ -182,6 +375,11 @@ void SkeletonNode::DecorateTree() {
 }
 
 void SkeletonNode::Update(double delta_time) {
+  if (!loaded_) {
+    PollLoading();
+    return;
+  }
+
   // Prevent multiple toggle.
   static bool prev_released = true;
   if (InputManager::GetInstance().IsKeyPressed('S')) {
@@ -192,6 +390,89 @@ void SkeletonNode::Update(double delta_time) {
   } else if (InputManager::GetInstance().IsKeyReleased('S')) {
     prev_released = true;
   }
+
+  UploadSkinnedSnapshot();
+  UpdateJointMatrices();
+  UpdatePickingSpheres();
+}
+
+void SkeletonNode::UpdateJointMatrices() {
+  // Joint matrices relative to this node, parents before children.
+  for (int joint : joint_order_) {
+    glm::mat4 local =
+        joint_ptrs_[joint]->GetTransform().GetLocalToParentMatrix();
+    int parent = joint_parents_[joint];
+    joint_matrices_[joint] =
+        parent == -1 ? local : joint_matrices_[parent] * local;
+  }
+}
+
+void SkeletonNode::UpdatePickingSpheres() {
+  // Same radius as the rendered joint spheres.
+  const float kRadius = 0.025f;
+  glm::mat4 local_to_world = GetTransform().GetLocalToWorldMatrix();
+  picking_spheres_.resize(sphere_nodes_ptrs_.size());
+  for (size_t i = 0; i < sphere_nodes_ptrs_.size(); i++) {
+    glm::mat4 sphere_matrix =
+        local_to_world * joint_matrices_[sphere_joint_indices_[i]] *
+        sphere_nodes_ptrs_[i]->GetTransform().GetLocalToParentMatrix();
+    picking_spheres_[i].center = glm::vec3(sphere_matrix[3]);
+    picking_spheres_[i].radius = kRadius;
+  }
+  picking_bvh_.Build(picking_spheres_);
+}
+
+void SkeletonNode::AppendInstances(SkeletonBatchNode& batches) {
+  if (!loaded_ || draw_mode_ != DrawMode::Skeleton || !IsActive())
+    return;
+  // Gizmo drags after this node's Update move joints too.
+  UpdateJointMatrices();
+  glm::mat4 to_batches =
+      glm::inverse(batches.GetTransform().GetLocalToWorldMatrix()) *
+      GetTransform().GetLocalToWorldMatrix();
+
+  glm::vec4 white(1.0f);
+  InstanceArray& joints =
+      batches.GetInstances(SkeletonBatchNode::Batch::Joints);
+  for (size_t i = 0; i < sphere_nodes_ptrs_.size(); i++) {
+    joints.push_back(MakeInstance(
+        to_batches * joint_matrices_[sphere_joint_indices_[i]] *
+            sphere_nodes_ptrs_[i]->GetTransform().GetLocalToParentMatrix(),
+        white));
+  }
+
+  InstanceArray& bones = batches.GetInstances(SkeletonBatchNode::Batch::Bones);
+  for (size_t i = 0; i < cylinder_nodes_ptrs_.size(); i++) {
+    bones.push_back(MakeInstance(
+        to_batches * joint_matrices_[cylinder_joint_indices_[i]] *
+            cylinder_nodes_ptrs_[i]->GetTransform().GetLocalToParentMatrix(),
+        white));
+  }
+
+  // Each visible gizmo sphere also draws its line, rotated onto its axis.
+  InstanceArray& gizmo_spheres =
+      batches.GetInstances(SkeletonBatchNode::Batch::GizmoSpheres);
+  InstanceArray& gizmo_lines =
+      batches.GetInstances(SkeletonBatchNode::Batch::GizmoLines);
+  for (size_t i = 0; i < sphere_nodes_ptrs_.size(); i++) {
+    SceneNode* sphere_node = sphere_nodes_ptrs_[i];
+    glm::mat4 sphere_matrix =
+        to_batches * joint_matrices_[sphere_joint_indices_[i]] *
+        sphere_node->GetTransform().GetLocalToParentMatrix();
+    for (size_t g = 0; g < sphere_node->GetChildrenCount(); g++) {
+      SceneNode& gizmo = sphere_node->GetChild(g);
+      if (!gizmo.IsActive()) {
+        continue;
+      }
+      int axis = gizmo.GetGizmoAxis();
+      glm::mat4 gizmo_matrix =
+          sphere_matrix * gizmo.GetTransform().GetLocalToParentMatrix();
+      glm::vec4 color(kGizmoColors[axis], 1.0f);
+      gizmo_spheres.push_back(MakeInstance(gizmo_matrix, color));
+      gizmo_lines.push_back(
+          MakeInstance(gizmo_matrix * kGizmoLineBases[axis], color));
+    }
+  }
 }
 
 void SkeletonNode::OnJointChanged(bool from_gizmo) {
@@ -201,10 +482,14 @@ void SkeletonNode::OnJointChanged(bool from_gizmo) {
   // The indices of linked_angles_ align with the order of the joints in .skel
   // files. For instance, *linked_angles_[0] corresponds to the first line of
   // the .skel file.
-    
+    if (!loaded_)
+        return;
+    ScopedTimer timer("SkeletonNode::OnJointChanged");
+
     if (!from_gizmo) {
         if (linked_angles_.size() > 0) {
-            for (int i = 0; i < joint_ptrs_.size(); i++) {
+            for (int i = 0;
+                 i < joint_ptrs_.size() && i < linked_angles_.size(); i++) {
 
                 glm::vec3 rot_vec = glm::vec3(linked_angles_[i]->rx, linked_angles_[i]->ry, linked_angles_[i]->rz);
 
@@ -215,41 +500,74 @@ void SkeletonNode::OnJointChanged(bool from_gizmo) {
     
     
     CalculateTMatrices();
-    ComputeNewPositions();
-    CalculateNormals();
+    PoseSnapshot& pose = poses_.GetWriteBuffer();
+    pose.pose_id = ++last_pose_id_;
+    pose.skinning_matrices.resize(t_matrices.size());
+    for (size_t j = 0; j < t_matrices.size(); j++) {
+        pose.skinning_matrices[j] = t_matrices[j] * b_matrices[j];
+    }
+    poses_.Publish();
+    {
+        std::lock_guard<std::mutex> lock(skinning_mutex_);
+        pose_pending_ = true;
+    }
+    pose_posted_.notify_one();
+}
+
+void SkeletonNode::GetBindPose(Pose& pose) const {
+  pose.Resize(joint_ptrs_.size());
+  for (size_t i = 0; i < joint_ptrs_.size(); i++) {
+    pose.rotations[i] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    pose.translations[i] = character_.joint_positions[i];
+  }
+}
+
+void SkeletonNode::ApplyPose(const Pose& pose) {
+  if (!loaded_)
+    return;
+  size_t num_joints = std::min(joint_ptrs_.size(), pose.GetNumJoints());
+  for (size_t i = 0; i < num_joints; i++) {
+    Transform& transform = joint_ptrs_[i]->GetTransform();
+    transform.SetRotation(pose.rotations[i]);
+    transform.SetPosition(pose.translations[i]);
+  }
+  // Skips reading the sliders, as gizmo edits do.
+  OnJointChanged(true);
+}
+
+void SkeletonNode::ApplyPose(const PoseBuffer& pose) {
+  if (!loaded_)
+    return;
+  size_t num_joints = std::min(joint_ptrs_.size(), pose.GetNumJoints());
+  for (size_t i = 0; i < num_joints; i++) {
+    Transform& transform = joint_ptrs_[i]->GetTransform();
+    transform.SetRotation(pose.GetRotation(i));
+    transform.SetPosition(pose.GetTranslation(i));
+  }
+  OnJointChanged(true);
 }
 
 void SkeletonNode::LinkRotationControl(const std::vector<EulerAngle*>& angles) {
   linked_angles_ = angles;
 }
 
-void SkeletonNode::ComputeNewPositions() {
-    auto new_positions = make_unique<PositionArray>();
-
-    for (int i = 0; i < orig_positions_.size(); i++) {
+void SkeletonNode::ComputeNewPositions(
+    const std::vector<glm::mat4>& skinning_matrices,
+    PositionArray& positions) const {
+    const ArrayView<glm::vec3>& bind_positions = character_.positions;
+    positions.resize(bind_positions.size());
+    for (size_t i = 0; i < bind_positions.size(); i++) {
+        glm::vec4 bind_pos = glm::vec4(bind_positions[i], 1.0f);
         glm::vec4 new_pos = glm::vec4(0.0f);
-        for (int j = 0; j < joint_ptrs_.size() - 1; j++) {
-            new_pos += vertex_weights_[i][j]*t_matrices[j]*b_matrices[j]*glm::vec4(orig_positions_[i],1.0f);
+        // Only the bones with nonzero weight on this vertex.
+        for (uint32_t k = character_.influence_offsets[i];
+             k < character_.influence_offsets[i + 1]; k++) {
+            const JointInfluence& influence = character_.influences[k];
+            new_pos += influence.weight *
+                       (skinning_matrices[influence.bone] * bind_pos);
         }
-        new_positions->push_back(glm::vec3(new_pos[0],new_pos[1],new_pos[2]));
+        positions[i] = glm::vec3(new_pos[0], new_pos[1], new_pos[2]);
     }
-    bind_pose_mesh_->UpdatePositions(std::move(new_positions));
-}
-
-void SkeletonNode::FindIncidentTriangles() {
-    auto indices = bind_pose_mesh_->GetIndices();
-    auto positions = bind_pose_mesh_->GetPositions();
-    std::vector<std::vector<int>> incident_tris;
-    for (int position_index = 0; position_index < positions.size(); position_index++) {
-        std::vector<int> tris;
-        for (int i = 0; i < indices.size() - 2; i += 3) {
-            if (indices[i] == position_index || indices[i + 1] == position_index || indices[i + 2] == position_index) {
-                tris.push_back(i / 3);
-            }
-        }
-        incident_tris.push_back(tris);
-    }
-    incident_triangles_ = incident_tris;
 }
 
 void SkeletonNode::CalculateTMatrices() {
@@ -264,117 +582,60 @@ void SkeletonNode::CalculateTMatrices() {
 
 }
 
-void SkeletonNode::CalculateBMatrices() {
-    for (int i = 1; i < joint_ptrs_.size(); i++) {
-        b_matrices.push_back(glm::inverse(joint_ptrs_[i]->GetTransform().GetLocalToWorldMatrix()));
-    }
-}
-
-void SkeletonNode::CalculateNormals() {
-    auto indices = bind_pose_mesh_->GetIndices();
-    auto positions = bind_pose_mesh_->GetPositions();
-    auto new_normals = make_unique<NormalArray>();
-    for (int position_index = 0; position_index < positions.size(); position_index++) {
-        glm::vec3 vertex_norm = glm::vec3(0.0f);
-        for (int tri : incident_triangles_[position_index]) {
-            glm::vec3 a = positions[indices[(tri * 3)]];
-            glm::vec3 b = positions[indices[(tri * 3)+1]];
-            glm::vec3 c = positions[indices[(tri * 3)+2]];
-
-            glm::vec3 u = b - a;
-            glm::vec3 v = c - a;
-
-            glm::vec3 tri_norm = glm::normalize(glm::cross(u, v));
-
-            vertex_norm += tri_norm * FindTriArea(a, b, c);
-        }
-        new_normals->push_back(glm::normalize(vertex_norm));
-    }
-    
-    bind_pose_mesh_->UpdateNormals(std::move(new_normals));
-}
-
-float SkeletonNode::FindTriArea(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
-    float u_mag = glm::length(glm::cross(b - a, c - a));
-    return u_mag / 2;
+void SkeletonNode::CalculateNormals(const PositionArray& positions,
+                                    NormalArray& normals) const {
+    normals.resize(positions.size());
+    ComputeVertexNormals(character_, positions.data(), normals.data());
 }
-void SkeletonNode::LoadSkeletonFile(const std::string& path) {
-    std::vector<glm::vec3> joint_positions;
-    std::vector<int> joint_parents;
-
-    std::ifstream infile(path);
-    float x, y, z;
-    int parent_index;
-    while (infile >> x >> y >> z >> parent_index)
-    {
-        //std::cout << x << " " << y << " " << z << " " << parent_index << std::endl;
-        joint_positions.push_back(glm::vec3(x, y, z));
-        joint_parents.push_back(parent_index);
-    }
-
-    joint_ptrs_.resize(joint_parents.size());
-    RecursiveAddJoints(*this, -1, joint_positions, joint_parents);
-
-    
-    //std::cout << joint_ptrs_[1]->GetChildrenCount() << std::endl;
 
+void SkeletonNode::LoadSkeleton() {
+    joint_parents_.assign(character_.joint_parents.begin(),
+                          character_.joint_parents.end());
+    joint_ptrs_.resize(joint_parents_.size());
+    joint_matrices_.resize(joint_parents_.size());
+    RecursiveAddJoints(*this, -1);
+    CheckJointPositions();
+    b_matrices.assign(character_.bind_matrices.begin(),
+                      character_.bind_matrices.end());
 }
 
-void SkeletonNode::RecursiveAddJoints(SceneNode& parent, int parent_index, std::vector<glm::vec3> positions, std::vector<int> joint_parents) {
-    int current_child = 0;
-    //std::cout << "Finding " << parent_index << "'s" << std::endl;
-
-    for (int i = 0; i < joint_parents.size(); i++) {
-        if (joint_parents[i] == parent_index) {
-            //std::cout << "Found " << i << " for " << parent_index << std::endl;
+void SkeletonNode::RecursiveAddJoints(SceneNode& parent, int parent_index) {
+    for (int i = 0; i < joint_parents_.size(); i++) {
+        if (joint_parents_[i] == parent_index) {
             auto joint_node = make_unique<SceneNode>();
-            joint_node->GetTransform().SetPosition(positions[i]);
-            joint_ptrs_[i] = joint_node.get();
+            joint_node->GetTransform().SetPosition(
+                character_.joint_positions[i]);
+            // parent may hold other children, e.g. the loading placeholder.
+            SceneNode* joint_ptr = joint_node.get();
+            joint_ptrs_[i] = joint_ptr;
+            joint_order_.push_back(i);
             parent.AddChild(std::move(joint_node));
-            auto& new_ptr = parent.GetChild(current_child);
-            current_child++;
-            RecursiveAddJoints(new_ptr, i, positions, joint_parents);
+            RecursiveAddJoints(*joint_ptr, i);
         }
     }
 }
 
-void SkeletonNode::LoadMeshFile(const std::string& filename) {
-  std::shared_ptr<VertexObject> vtx_obj =
-      MeshLoader::Import(filename).vertex_obj;
-  bind_pose_mesh_ = vtx_obj;
-  orig_positions_ = bind_pose_mesh_->GetPositions();
-  FindIncidentTriangles();
-  CalculateNormals();
-  CalculateBMatrices();
-}
-
-void SkeletonNode::LoadAttachmentWeights(const std::string& path) {
-    std::vector<std::vector<float>> weights;
-    std::ifstream infile(path);
-    float single_weight;
-    
-    std::vector<float> single_line;
-    while (infile >> single_weight) {
-        single_line.push_back(single_weight);
-        //std::cout << single_weight << " ";
-
-        if (single_line.size() == joint_ptrs_.size() - 1) {
-            //std::cout << single_line.size() << std::endl;
-
-            weights.push_back(single_line);
-            single_line.clear();
+void SkeletonNode::CheckJointPositions() {
+    const float kTolerance = 1e-4f;
+    std::vector<glm::vec3> offset_sums(joint_parents_.size());
+    for (int joint : joint_order_) {
+        int parent = joint_parents_[joint];
+        offset_sums[joint] = character_.joint_positions[joint];
+        if (parent != -1)
+            offset_sums[joint] += offset_sums[parent];
+        glm::vec3 position = glm::vec3(
+            joint_ptrs_[joint]->GetTransform().GetLocalToAncestorMatrix(
+                this)[3]);
+        if (glm::length(position - offset_sums[joint]) > kTolerance) {
+            throw std::runtime_error("Joint " + std::to_string(joint) +
+                                     " is misplaced in the scene graph!");
         }
     }
-    //std::cout << weights.size() << std::endl;
-    vertex_weights_ = weights;
-
-
 }
 
-void SkeletonNode::LoadAllFiles(const std::string& prefix) {
-  std::string prefix_full = GetAssetDir() + prefix;
-  LoadSkeletonFile(prefix_full + ".skel");
-  LoadMeshFile(prefix + ".obj");
-  LoadAttachmentWeights(prefix_full + ".attach");
+void SkeletonNode::LoadMesh() {
+  // Only uploaded by the first node showing the character; the others, and
+  // the skinned meshes, reuse its buffers.
+  bind_mesh_ = MeshLoader::ImportCharacterMesh(*loaded_character_);
 }
 }  // namespace GLOO
@@ -1,14 +1,30 @@
 #ifndef SKELETON_NODE_H_
 #define SKELETON_NODE_H_
 
+#include "gloo/animation/Pose.hpp"
+#include "gloo/animation/PoseBuffer.hpp"
+#include "gloo/LoadProgress.hpp"
+#include "gloo/MeshLoader.hpp"
 #include "gloo/SceneNode.hpp"
+#include "gloo/SphereBVH.hpp"
+#include "gloo/TriangleBVH.hpp"
+#include "gloo/TripleBuffer.hpp"
+#include "gloo/UploadQueue.hpp"
 #include "gloo/VertexObject.hpp"
 #include "gloo/shaders/ShaderProgram.hpp"
 
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace GLOO {
+class SkeletonBatchNode;
+
 class SkeletonNode : public SceneNode {
  public:
   enum class DrawMode { Skeleton, SSD };
@@ -16,43 +32,153 @@ class SkeletonNode : public SceneNode {
     float rx, ry, rz;
   };
 
+  // Starts loading the character in the background. Until it is loaded
+  // and uploaded, the node shows a placeholder and ignores poses.
   SkeletonNode(const std::string& filename);
+  ~SkeletonNode();
+  // The skeleton view is drawn by batches, shared with the other nodes
+  // registered with it; nullptr hides it.
+  void SetBatches(SkeletonBatchNode* batches);
+  // Appends the instances of the joints, bones and visible gizmos to
+  // batches, in its space, unless the node shows the mesh.
+  void AppendInstances(SkeletonBatchNode& batches);
+  bool IsLoaded() const {
+    return loaded_;
+  }
+  // Shared with the other nodes loading the same files.
+  const LoadProgress& GetLoadProgress() const {
+    return *load_progress_;
+  }
+  // Blocks until the character is loaded, uploaded and skinned, for
+  // callers that render it right away.
+  void WaitForLoad();
+  // Joints without a linked angle keep their rotation.
   void LinkRotationControl(const std::vector<EulerAngle*>& angles);
+  // Zero until the character is loaded.
+  size_t GetNumJoints() const {
+    return joint_ptrs_.size();
+  }
+  // Continues loading, or uploads the newest mesh the skinning thread
+  // finished, if any.
   void Update(double delta_time) override;
+  // Hands the new pose to the skinning thread and returns without waiting
+  // for the skinned mesh.
   void OnJointChanged(bool from_gizmo);
-  std::vector<SceneNode*> GetSpherePtrs();
+  // Every joint at its offset from the parent in the .skel file, without
+  // rotation. Empty until the character is loaded.
+  void GetBindPose(Pose& pose) const;
+  // Moves the joints to pose, e.g. one sampled from a clip, and skins it
+  // like OnJointChanged. The sliders take over again once they change.
+  void ApplyPose(const Pose& pose);
+  // The same for a pose blended by PoseBlender.
+  void ApplyPose(const PoseBuffer& pose);
+  // Blocks until the last pose passed to OnJointChanged is skinned and
+  // uploaded, for callers that render a pose right after setting it.
+  void WaitForSkinning();
+  const std::vector<SceneNode*>& GetSpherePtrs() const {
+    return sphere_nodes_ptrs_;
+  }
+  // Casts a world-space ray against the joint spheres as of the last
+  // Update and returns the closest one hit, or nullptr.
+  SceneNode* PickJointSphere(const glm::vec3& origin,
+                             const glm::vec3& direction) const;
+  // Casts a world-space ray against the skinned mesh in SSD mode and
+  // returns the joint sphere of the joint with the largest skinning weight
+  // at the hit point, or nullptr if the mesh is not hit.
+  SceneNode* PickMeshJoint(const glm::vec3& origin,
+                           const glm::vec3& direction) const;
   
 
  private:
-  void LoadAllFiles(const std::string& prefix);
-  void LoadSkeletonFile(const std::string& path);
-  void LoadMeshFile(const std::string& filename);
-  void LoadAttachmentWeights(const std::string& path);
-  void RecursiveAddJoints(SceneNode& parent, int parent_index, std::vector<glm::vec3> positions, std::vector<int> joint_parents);
+  // Input of the skinning thread: one matrix per bone, taking bind pose
+  // positions to posed ones.
+  struct PoseSnapshot {
+    uint64_t pose_id;
+    std::vector<glm::mat4> skinning_matrices;
+  };
+  // Output of the skinning thread, immutable once published.
+  struct SkinnedSnapshot {
+    uint64_t pose_id;
+    PositionArray positions;
+    NormalArray normals;
+    // Over positions; built once per snapshot buffer, then refit.
+    TriangleBVH bvh;
+    float skinning_ms;
+  };
+
+  void StartSkinningThread();
+  void StopSkinningThread();
+  void SkinningLoop();
+  void UploadSkinnedSnapshot();
+  // Picks up the finished load, if any, and runs this frame's share of the
+  // uploads.
+  void PollLoading();
+  // Queues the scene graph and GL setup of the loaded character.
+  void QueueUploads();
+  void LoadSkeleton();
+  void LoadMesh();
+  void RecursiveAddJoints(SceneNode& parent, int parent_index);
+  // Throws if a joint node is not where the summed .skel offsets put it.
+  void CheckJointPositions();
   void ToggleDrawMode();
   void DecorateTree();
-  void CalculateNormals();
-  void CalculateBMatrices();
+  // Recomputes joint_matrices_ from the joint transforms.
+  void UpdateJointMatrices();
+  // Rebuilds picking_bvh_ from joint_matrices_.
+  void UpdatePickingSpheres();
+  // These two run on the skinning thread and only read data that is fixed
+  // after loading.
+  void CalculateNormals(const PositionArray& positions,
+                        NormalArray& normals) const;
+  void ComputeNewPositions(const std::vector<glm::mat4>& skinning_matrices,
+                           PositionArray& positions) const;
   void CalculateTMatrices();
-  void ComputeNewPositions();
-  void FindIncidentTriangles();
-  float FindTriArea(glm::vec3 a, glm::vec3 b, glm::vec3 c);
   DrawMode draw_mode_;
   // Euler angles of the UI sliders.
   std::vector<EulerAngle*> linked_angles_;
   std::vector<SceneNode*> joint_ptrs_;
+  std::vector<int> joint_parents_;
+  // Joint indices in an order where parents precede their children.
+  std::vector<int> joint_order_;
+  std::vector<glm::mat4> joint_matrices_;
   std::vector<SceneNode*> sphere_nodes_ptrs_;
+  std::vector<int> sphere_joint_indices_;
+  // World-space joint spheres, indexed like sphere_nodes_ptrs_.
+  std::vector<BoundingSphere> picking_spheres_;
+  SphereBVH picking_bvh_;
   std::vector<SceneNode*> cylinder_nodes_ptrs_;
-  std::vector<std::vector<float>> vertex_weights_;
+  std::vector<int> cylinder_joint_indices_;
   std::vector<glm::mat4> b_matrices;
   std::vector<glm::mat4> t_matrices;
-  PositionArray orig_positions_;
-  std::shared_ptr<VertexObject> sphere_mesh_;
-  std::shared_ptr<VertexObject> cylinder_mesh_;
-  std::shared_ptr<VertexObject> bind_pose_mesh_;
-  std::vector<std::vector<int>> incident_triangles_;
+  // Shared by all nodes showing the character, and drawn until the first
+  // pose is skinned into skinned_mesh_, which shares its indices.
+  std::shared_ptr<VertexObject> bind_mesh_;
+  std::shared_ptr<VertexObject> skinned_mesh_;
   SceneNode*  ssd_ptr_;
+  SkeletonBatchNode* batches_;
   std::shared_ptr<ShaderProgram> shader_;
+  // Bind pose, weights and adjacency, read by the skinning thread. They
+  // live in loaded_character_.
+  CharacterView character_;
+  std::shared_ptr<const LoadedCharacter> loaded_character_;
+  std::future<std::shared_ptr<const LoadedCharacter>> pending_character_;
+  std::shared_ptr<LoadProgress> load_progress_;
+  UploadQueue uploads_;
+  SceneNode* placeholder_ptr_;
+  bool loaded_;
+
+  TripleBuffer<PoseSnapshot> poses_;
+  TripleBuffer<SkinnedSnapshot> skinned_meshes_;
+  uint64_t last_pose_id_;
+  std::thread skinning_thread_;
+  // Only used to sleep and wake up; snapshots go through the triple
+  // buffers.
+  std::mutex skinning_mutex_;
+  std::condition_variable pose_posted_;
+  std::condition_variable pose_skinned_;
+  uint64_t skinned_pose_id_;
+  bool pose_pending_;
+  bool stop_skinning_;
 
 };
 }  // namespace GLOO
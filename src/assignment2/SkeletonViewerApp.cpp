@@ -1,14 +1,27 @@
 #include "SkeletonViewerApp.hpp"
 
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
 #include "gloo/external.hpp"
 #include "gloo/cameras/ArcBallCameraNode.hpp"
 #include "gloo/lights/AmbientLight.hpp"
 #include "gloo/lights/DirectionalLight.hpp"
 #include "gloo/components/LightComponent.hpp"
 #include "gloo/shaders/PhongShader.hpp"
+#include "gloo/shaders/ShaderRegistry.hpp"
 #include "gloo/components/ShadingComponent.hpp"
 #include "gloo/components/MaterialComponent.hpp"
 #include "gloo/debug/PrimitiveFactory.hpp"
+#include "gloo/debug/Profiler.hpp"
+#include "gloo/parsers/AnimationParser.hpp"
+#include "gloo/gl_wrapper/ReadbackRing.hpp"
 
 namespace {
 const std::vector<std::string> kJointNames = {"Root",
@@ -35,14 +48,19 @@ namespace GLOO {
 
 SkeletonViewerApp::SkeletonViewerApp(const std::string& app_name,
                                      glm::ivec2 window_size,
-                                     const std::string& model_prefix)
-    : Application(app_name, window_size),
-      slider_values_(kJointNames.size(), {0.f, 0.f, 0.f}),
-      model_prefix_(model_prefix) {
+                                     const std::string& model_prefix,
+                                     bool headless)
+    : Application(app_name, window_size, headless),
+      model_prefix_(model_prefix),
+      clustered_lighting_(true),
+      clip_time_(0.0f),
+      playing_clip_(false) {
 }
 
 void SkeletonViewerApp::SetupScene() {
   SceneNode& root = scene_->GetRootNode();
+  GetRenderer().SetLightingMode(clustered_lighting_ ? LightingMode::Clustered
+                                                    : LightingMode::MultiPass);
 
   auto camera_node = make_unique<ArcBallCameraNode>(45.f, 1.6f, 3.0f);
   scene_->ActivateCamera(camera_node->GetComponentPtr<CameraComponent>());
@@ -61,24 +79,119 @@ void SkeletonViewerApp::SetupScene() {
   sun_light_node->CreateComponent<LightComponent>(sun_light);
   root.AddChild(std::move(sun_light_node));
 
+  // Shared by all skeletons, which it draws in four draw calls.
+  auto skeleton_batches = make_unique<SkeletonBatchNode>();
+  skeleton_batches_ptr_ = skeleton_batches.get();
+
   auto skeletal_node = make_unique<SkeletonNode>(model_prefix_);
   skeletal_node_ptr_ = skeletal_node.get();
+  skeletal_node_ptr_->SetBatches(skeleton_batches_ptr_);
   root.AddChild(std::move(skeletal_node));
 
+  auto mouse_picker_node = make_unique<MousePicker>(scene_.get(), camera_ptr,skeletal_node_ptr_);
+  root.AddChild(std::move(mouse_picker_node));
+
+  auto quad_node = make_unique<SceneNode>();
+  quad_node->CreateComponent<ShadingComponent>(
+      ShaderRegistry::Get<PhongShader>());
+  quad_node->CreateComponent<RenderingComponent>(PrimitiveFactory::GetQuad());
+  quad_node->GetTransform().SetRotation(glm::vec3(1.0f,0.f,0.f), 90);
+  root.AddChild(std::move(quad_node));
+
+  // Last, so that it collects the joints after the picker moved them.
+  root.AddChild(std::move(skeleton_batches));
+
+  if (AnimationParser::Parse(GetAssetDir() + model_prefix_ + ".anim", clip_)) {
+    clip_sampler_ = make_unique<ClipSampler>(clip_);
+  }
+}
+
+void SkeletonViewerApp::LinkSliders() {
+  // Characters imported from glTF files may have any number of joints.
+  slider_values_.resize(skeletal_node_ptr_->GetNumJoints(), {0.f, 0.f, 0.f});
   std::vector<SkeletonNode::EulerAngle*> angles;
   for (size_t i = 0; i < slider_values_.size(); i++) {
     angles.push_back(&slider_values_[i]);
   }
   skeletal_node_ptr_->LinkRotationControl(angles);
+}
 
-  auto mouse_picker_node = make_unique<MousePicker>(scene_.get(), camera_ptr,skeletal_node_ptr_);
-  root.AddChild(std::move(mouse_picker_node));
+void SkeletonViewerApp::LoadBatchFile(const std::string& filename,
+                                      std::vector<BatchView>& views,
+                                      std::vector<BatchPose>& poses) const {
+  std::ifstream file(filename);
+  if (!file) {
+    throw std::runtime_error("Cannot open batch file " + filename + "!");
+  }
+  std::string line;
+  for (size_t line_number = 1; std::getline(file, line); line_number++) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream ss(line);
+    std::string type;
+    if (!(ss >> type))
+      continue;
+    bool ok;
+    if (type == "view") {
+      BatchView view;
+      ok = bool(ss >> view.name >> view.eye.x >> view.eye.y >> view.eye.z >>
+                view.target.x >> view.target.y >> view.target.z);
+      views.push_back(view);
+    } else if (type == "pose") {
+      BatchPose pose;
+      pose.angles.resize(slider_values_.size());
+      ok = bool(ss >> pose.name);
+      for (auto& angle : pose.angles) {
+        ok = ok && (ss >> angle.rx >> angle.ry >> angle.rz);
+      }
+      poses.push_back(pose);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      throw std::runtime_error("Malformed line " + std::to_string(line_number) +
+                               " in batch file " + filename + "!");
+    }
+  }
+}
 
-  auto quad_node = make_unique<SceneNode>();
-  quad_node->CreateComponent<ShadingComponent>(std::make_shared<PhongShader>());
-  quad_node->CreateComponent<RenderingComponent>(PrimitiveFactory::CreateQuad());
-  quad_node->GetTransform().SetRotation(glm::vec3(1.0f,0.f,0.f), 90);
-  root.AddChild(std::move(quad_node));
+void SkeletonViewerApp::RenderBatch(const std::string& batch_filename,
+                                    const std::string& output_dir) {
+  // The number of angles per pose depends on the character.
+  skeletal_node_ptr_->WaitForLoad();
+  LinkSliders();
+  std::vector<BatchView> views;
+  std::vector<BatchPose> poses;
+  LoadBatchFile(batch_filename, views, poses);
+
+  glm::ivec2 size = GetWindowSize();
+  CameraComponent* camera = scene_->GetActiveCameraPtr();
+  camera->SetAspectRatio(float(size.x) / float(size.y));
+
+  // Frame N is encoded while the GPU renders frame N + 1 and later ones.
+  ReadbackRing readback(size);
+  auto save_oldest = [&readback]() {
+    std::string filename = readback.GetOldestLabel();
+    readback.Pop()->SavePNG(filename);
+  };
+  for (const BatchPose& pose : poses) {
+    slider_values_ = pose.angles;
+    skeletal_node_ptr_->OnJointChanged(false);
+    skeletal_node_ptr_->WaitForSkinning();
+    // The scene is not updated between these frames.
+    skeleton_batches_ptr_->UpdateInstances();
+    for (const BatchView& view : views) {
+      camera->SetViewMatrix(make_unique<glm::mat4>(
+          glm::lookAt(view.eye, view.target, glm::vec3(0.0f, 1.0f, 0.0f))));
+      RenderOffscreen();
+      if (readback.IsFull()) {
+        save_oldest();
+      }
+      readback.Read(output_dir + "/" + pose.name + "_" + view.name + ".png");
+    }
+  }
+  while (!readback.IsEmpty()) {
+    save_oldest();
+  }
 }
 
 void SkeletonViewerApp::DrawGUI() {
@@ -86,8 +199,27 @@ void SkeletonViewerApp::DrawGUI() {
   ImGui::Begin("Control Panel");
   ImGui::Text("Click on a joint to show rotation gizmo, then click and drag on an axis handle to rotate joint.");
   ImGui::Text("Esc deselects the joint");
-  for (size_t i = 0; i < kJointNames.size(); i++) {
-    ImGui::Text("%s", kJointNames[i].c_str());
+  if (!skeletal_node_ptr_->IsLoaded()) {
+    std::string stage;
+    float fraction;
+    skeletal_node_ptr_->GetLoadProgress().Get(stage, fraction);
+    ImGui::Text("Loading %s: %s", model_prefix_.c_str(), stage.c_str());
+    ImGui::ProgressBar(fraction);
+  } else if (slider_values_.size() != skeletal_node_ptr_->GetNumJoints()) {
+    LinkSliders();
+  }
+  if (ImGui::Checkbox("Clustered lighting", &clustered_lighting_)) {
+    GetRenderer().SetLightingMode(clustered_lighting_
+                                      ? LightingMode::Clustered
+                                      : LightingMode::MultiPass);
+  }
+  ImGui::Text("Objects drawn: %zu, culled: %zu",
+              GetRenderer().GetNumVisible(), GetRenderer().GetNumCulled());
+  DrawClipGUI();
+  for (size_t i = 0; i < slider_values_.size(); i++) {
+    std::string name = i < kJointNames.size() ? kJointNames[i]
+                                              : "Joint " + std::to_string(i);
+    ImGui::Text("%s", name.c_str());
     ImGui::PushID((int)i);
     modified |= ImGui::SliderFloat("x", &slider_values_[i].rx, -kPi, kPi);
     modified |= ImGui::SliderFloat("y", &slider_values_[i].ry, -kPi, kPi);
@@ -99,5 +231,45 @@ void SkeletonViewerApp::DrawGUI() {
   if (modified) {
     skeletal_node_ptr_->OnJointChanged(false);
   }
+
+  DrawTimingGUI();
+}
+
+void SkeletonViewerApp::DrawClipGUI() {
+  if (clip_sampler_ == nullptr || clip_.IsEmpty() ||
+      !skeletal_node_ptr_->IsLoaded()) {
+    return;
+  }
+  ImGui::Checkbox("Play animation", &playing_clip_);
+  bool scrubbed =
+      ImGui::SliderFloat("Time", &clip_time_, 0.0f, clip_.duration, "%.2f s");
+  if (playing_clip_ && clip_.duration > 0.0f) {
+    clip_time_ =
+        std::fmod(clip_time_ + ImGui::GetIO().DeltaTime, clip_.duration);
+  }
+  if (!playing_clip_ && !scrubbed)
+    return;
+  if (clip_pose_.GetNumJoints() != skeletal_node_ptr_->GetNumJoints()) {
+    skeletal_node_ptr_->GetBindPose(clip_pose_);
+  }
+  clip_sampler_->Sample(clip_time_, clip_pose_);
+  skeletal_node_ptr_->ApplyPose(clip_pose_);
+}
+
+void SkeletonViewerApp::DrawTimingGUI() {
+  ImGui::Begin("Frame Timing");
+  ImGui::Text("%.1f FPS", ImGui::GetIO().Framerate);
+  for (const TimingSeries& series : Profiler::GetInstance().GetSeries()) {
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "%.3f ms (avg %.3f ms)",
+             series.GetLatest(), series.GetAverage());
+    ImGui::Text("%s %s", series.gpu ? "[GPU]" : "[CPU]", series.name.c_str());
+    ImGui::PushID(series.name.c_str());
+    ImGui::PlotLines("", series.samples.data(), (int)series.samples.size(),
+                     (int)series.next_sample, overlay, 0.0f, FLT_MAX,
+                     ImVec2(0.0f, 40.0f));
+    ImGui::PopID();
+  }
+  ImGui::End();
 }
 }  // namespace GLOO
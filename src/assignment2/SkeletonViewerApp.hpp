@@ -1,8 +1,14 @@
 #ifndef SKELETON_VIEWER_APP_H_
 #define SKELETON_VIEWER_APP_H_
 
+#include <string>
+#include <vector>
+
 #include "gloo/Application.hpp"
+#include "gloo/animation/AnimationClip.hpp"
+#include "gloo/animation/ClipSampler.hpp"
 
+#include "SkeletonBatchNode.hpp"
 #include "SkeletonNode.hpp"
 #include "MousePicker.hpp"
 
@@ -11,16 +17,54 @@ class SkeletonViewerApp : public Application {
  public:
   SkeletonViewerApp(const std::string& app_name,
                     glm::ivec2 window_size,
-                    const std::string& model_prefix);
+                    const std::string& model_prefix,
+                    bool headless = false);
   void SetupScene() override;
 
+  // Renders every pose of a batch file from every view and writes the
+  // frames to output_dir as <pose>_<view>.png. The app must be headless.
+  // Batch files hold one entry per line ('#' starts a comment):
+  //   view NAME EYE_X EYE_Y EYE_Z TARGET_X TARGET_Y TARGET_Z
+  //   pose NAME followed by rx ry rz in radians for each joint
+  void RenderBatch(const std::string& batch_filename,
+                   const std::string& output_dir);
+
  protected:
   void DrawGUI() override;
 
  private:
+  // Rolling graphs of the profiled CPU sections and GPU render passes.
+  void DrawTimingGUI();
+  // Gives every joint of the loaded character a set of sliders.
+  void LinkSliders();
+  // Play controls of the character's clip, PREFIX.anim, if it has one.
+  void DrawClipGUI();
+
+  struct BatchView {
+    std::string name;
+    glm::vec3 eye;
+    glm::vec3 target;
+  };
+  struct BatchPose {
+    std::string name;
+    std::vector<SkeletonNode::EulerAngle> angles;
+  };
+  void LoadBatchFile(const std::string& filename,
+                     std::vector<BatchView>& views,
+                     std::vector<BatchPose>& poses) const;
+
   SkeletonNode* skeletal_node_ptr_;
+  SkeletonBatchNode* skeleton_batches_ptr_;
   std::vector<SkeletonNode::EulerAngle> slider_values_;
   std::string model_prefix_;
+  bool clustered_lighting_;
+
+  AnimationClip clip_;
+  std::unique_ptr<ClipSampler> clip_sampler_;
+  // Starts out as the bind pose, so that joints without a track stay put.
+  Pose clip_pose_;
+  float clip_time_;
+  bool playing_clip_;
 };
 }  // namespace GLOO
 
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <chrono>
+#include <string>
 
 #include "SkeletonViewerApp.hpp"
 
@@ -14,8 +15,22 @@ int main(int argc, char** argv) {
     std::cout << "For example, if you're trying to load "
                  "Model1.skel, Model1.obj, and Model1.attach, run with: "
               << argv[0] << " Model1" << std::endl;
+    std::cout << "To render poses offscreen instead, run with: " << argv[0]
+              << " PREFIX --batch BATCH_FILE OUTPUT_DIR" << std::endl;
     return -1;
   }
+  if (argc >= 5 && std::string(argv[2]) == "--batch") {
+    SkeletonViewerApp app("Assignment2", glm::ivec2(1440, 900),
+                          "assignment2/" + std::string(argv[1]), true);
+    app.SetupScene();
+    try {
+      app.RenderBatch(argv[3], argv[4]);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+    return 0;
+  }
   std::unique_ptr<SkeletonViewerApp> app =
       make_unique<SkeletonViewerApp>("Assignment2", glm::ivec2(1440, 900),
                                      "assignment2/" + std::string(argv[1]));
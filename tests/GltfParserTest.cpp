@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gloo/parsers/GltfParser.hpp"
+
+using namespace GLOO;
+
+namespace {
+const char kTestFile[] = "GltfParserTest.glb";
+
+int num_failures = 0;
+
+void AppendUint32(std::vector<char>& bytes, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    bytes.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+// A GLB header declaring length bytes, then a 24-byte JSON chunk holding
+// an empty object.
+std::vector<char> MakeGlb(uint32_t length) {
+  std::vector<char> bytes;
+  AppendUint32(bytes, 0x46546c67);  // "glTF"
+  AppendUint32(bytes, 2);
+  AppendUint32(bytes, length);
+  AppendUint32(bytes, 4);
+  AppendUint32(bytes, 0x4e4f534a);  // "JSON"
+  for (char c : std::string("{}  ")) {
+    bytes.push_back(c);
+  }
+  return bytes;
+}
+
+// Checks that parsing bytes throws an error mentioning reason, rather than
+// succeeding or reading past the file.
+void ExpectRejected(const std::string& name,
+                    const std::vector<char>& bytes,
+                    const std::string& reason) {
+  {
+    std::ofstream fs(kTestFile, std::ios::binary);
+    fs.write(bytes.data(), bytes.size());
+  }
+  CharacterData data;
+  try {
+    GltfParser::Parse(kTestFile, data);
+    std::cerr << "FAILED: " << name << ": accepted" << std::endl;
+    num_failures++;
+  } catch (const std::runtime_error& e) {
+    if (std::string(e.what()).find(reason) == std::string::npos) {
+      std::cerr << "FAILED: " << name << ": expected \"" << reason
+                << "\", got \"" << e.what() << "\"" << std::endl;
+      num_failures++;
+    }
+  }
+}
+}  // namespace
+
+// Feeds GltfParser GLB files with broken headers and chunks. Returns
+// nonzero if any of them is not rejected as expected.
+int main() {
+  ExpectRejected("length within the header", MakeGlb(8), "invalid length");
+  ExpectRejected("length without a chunk header", MakeGlb(16),
+                 "invalid length");
+  ExpectRejected("length past the end of the file", MakeGlb(1000),
+                 "invalid length");
+  std::vector<char> truncated = MakeGlb(24);
+  truncated.resize(16);
+  ExpectRejected("file shorter than a header", truncated, "not a GLB file");
+  ExpectRejected("chunk past the declared length", MakeGlb(22),
+                 "truncated chunk");
+  // A valid header gets as far as the JSON contents.
+  ExpectRejected("empty JSON document", MakeGlb(24), "no skinned mesh");
+  std::remove(kTestFile);
+
+  if (num_failures > 0) {
+    std::cerr << num_failures << " checks failed." << std::endl;
+    return 1;
+  }
+  std::cout << "All checks passed." << std::endl;
+  return 0;
+}
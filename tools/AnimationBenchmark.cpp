@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gloo/CharacterData.hpp"
+#include "gloo/animation/ClipCompressor.hpp"
+#include "gloo/animation/ClipSampler.hpp"
+#include "gloo/animation/CompressedClipSampler.hpp"
+#include "gloo/animation/PoseBlender.hpp"
+#include "gloo/animation/SkinningRig.hpp"
+#include "gloo/parsers/AnimationParser.hpp"
+#include "gloo/parsers/CharacterParser.hpp"
+
+using namespace GLOO;
+
+namespace {
+const float kPi = 3.14159265f;
+const int kNumSyntheticJoints = 200;
+const float kSyntheticDuration = 10.0f;
+
+double GetSeconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// A random skeleton with a mix of tracks as motion capture has them: still
+// joints, smooth motion, and smooth motion with sensor noise, keyed at the
+// sample rate.
+void MakeSyntheticCharacter(float sample_rate,
+                            CharacterData& data,
+                            AnimationClip& clip) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  data.joint_positions.push_back(glm::vec3(0.0f));
+  data.joint_parents.push_back(-1);
+  for (int j = 1; j < kNumSyntheticJoints; j++) {
+    data.joint_positions.push_back(
+        glm::vec3(unit(rng) - 0.5f, 0.1f + 0.1f * unit(rng), 0.0f) * 0.2f);
+    data.joint_parents.push_back(
+        std::uniform_int_distribution<int>(std::max(0, j - 4), j - 1)(rng));
+  }
+  ComputeBindMatrices(data.joint_positions, data.joint_parents,
+                      data.bind_matrices);
+
+  std::normal_distribution<float> noise(0.0f, 0.002f);
+  int num_keys = static_cast<int>(kSyntheticDuration * sample_rate) + 1;
+  clip.duration = (num_keys - 1) / sample_rate;
+  for (int j = 0; j < kNumSyntheticJoints; j++) {
+    float kind = unit(rng);
+    glm::vec3 amplitude = glm::vec3(unit(rng), unit(rng), unit(rng));
+    glm::vec3 frequency = glm::vec3(unit(rng), unit(rng), unit(rng));
+    glm::vec3 phase = glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f * kPi;
+    RotationTrack track;
+    track.joint = j;
+    for (int k = 0; k < num_keys; k++) {
+      float time = k / sample_rate;
+      glm::vec3 angles = phase;
+      if (kind > 0.3f) {
+        for (int c = 0; c < 3; c++) {
+          angles[c] += amplitude[c] *
+                       std::sin(2.0f * kPi * frequency[c] * time + phase[c]);
+        }
+      }
+      if (kind > 0.85f)
+        angles += glm::vec3(noise(rng), noise(rng), noise(rng));
+      track.times.push_back(time);
+      track.values.push_back(glm::quat(angles));
+    }
+    clip.rotation_tracks.push_back(track);
+  }
+}
+
+// Blends five layers per character, as for locomotion with upper body
+// layers, for 100 characters with poses of their own, and then computes
+// their skinning matrices.
+void BenchmarkBlending(const AnimationClip& clip, const SkinningRig& rig) {
+  const int kNumCharacters = 100;
+  const int kNumLayers = 5;
+  const int kNumFrames = 200;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> clip_time(0.0f, clip.duration);
+  ClipSampler sampler(clip);
+  Pose pose;
+  rig.GetRestPose(pose);
+  PoseBuffer rest;
+  rest.CopyFrom(pose);
+  // The base pose and one per layer.
+  std::vector<std::vector<PoseBuffer>> poses(
+      kNumCharacters, std::vector<PoseBuffer>(kNumLayers + 1));
+  for (std::vector<PoseBuffer>& character_poses : poses) {
+    for (PoseBuffer& character_pose : character_poses) {
+      sampler.Sample(clip_time(rng), pose);
+      character_pose.CopyFrom(pose);
+    }
+  }
+
+  // The first joint below the root stands in for the spine.
+  int num_joints = static_cast<int>(rig.GetNumJoints());
+  JointMask upper_body =
+      JointMask::FromSubtree(rig.joint_parents, std::min(1, num_joints - 1));
+  std::vector<std::vector<PoseBlender::Layer>> layers(kNumCharacters);
+  for (int i = 0; i < kNumCharacters; i++) {
+    std::vector<PoseBuffer>& p = poses[i];
+    PoseBuffer sampled = p[4];
+    PoseBlender::MakeAdditive(sampled, rest, p[4]);
+    sampled = p[5];
+    PoseBlender::MakeAdditive(sampled, rest, p[5]);
+    layers[i].emplace_back(p[1], PoseBlender::Mode::Nlerp, 0.5f);
+    layers[i].emplace_back(p[2], PoseBlender::Mode::Slerp, 0.3f);
+    layers[i].emplace_back(p[3], PoseBlender::Mode::Nlerp, 0.8f, &upper_body);
+    layers[i].emplace_back(p[4], PoseBlender::Mode::Additive, 0.6f,
+                           &upper_body);
+    layers[i].emplace_back(p[5], PoseBlender::Mode::Additive, 0.2f);
+  }
+
+  std::vector<PoseBuffer> results(kNumCharacters);
+  std::vector<glm::mat4> joints, skinning;
+  double blend_seconds = 0.0;
+  double hierarchy_seconds = 0.0;
+  for (int f = 0; f < kNumFrames; f++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kNumCharacters; i++) {
+      PoseBlender::Evaluate(poses[i][0], layers[i], results[i]);
+    }
+    blend_seconds += GetSeconds(start);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kNumCharacters; i++) {
+      rig.ComputeSkinningMatrices(results[i], joints, skinning);
+    }
+    hierarchy_seconds += GetSeconds(start);
+  }
+  std::cout << "Blending: " << kNumLayers << " layers for " << kNumCharacters
+            << " characters in " << blend_seconds / kNumFrames * 1e3
+            << " ms per frame, their hierarchies in "
+            << hierarchy_seconds / kNumFrames * 1e3 << " ms" << std::endl;
+}
+
+bool LoadCharacter(const std::string& prefix,
+                   CharacterData& data,
+                   AnimationClip& clip) {
+  if (!CharacterParser::Parse(prefix, data)) {
+    std::cerr << "Unable to load character " << prefix << "!" << std::endl;
+    return false;
+  }
+  if (!AnimationParser::Parse(prefix + ".anim", clip) || clip.IsEmpty()) {
+    std::cerr << "Unable to load animation " << prefix << ".anim!"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+// Compresses a clip and reports how small the compressed clip is, how fast
+// it decompresses into skinning matrices and how far its joints end up
+// from the original's, then how fast poses sampled from it blend. Uses a
+// synthetic 200-joint character by default.
+int main(int argc, char** argv) {
+  if (argc >= 2 && std::string(argv[1]) == "--help") {
+    std::cout << "Usage: " << argv[0] << " [PREFIX [MAX_ERROR_DEGREES]]"
+              << std::endl;
+    std::cout << "For example, to compress assets/assignment2/Model1.anim "
+                 "for the skeleton in Model1.skel, run with: "
+              << argv[0] << " assets/assignment2/Model1" << std::endl;
+    return 0;
+  }
+  ClipCompressor::Settings settings;
+  if (argc >= 3)
+    settings.max_error = std::atof(argv[2]) * kPi / 180.0f;
+
+  CharacterData data;
+  AnimationClip clip;
+  CompressedClip compressed;
+  double compress_seconds;
+  try {
+    if (argc >= 2) {
+      if (!LoadCharacter(argv[1], data, clip))
+        return -1;
+    } else {
+      MakeSyntheticCharacter(settings.sample_rate, data, clip);
+    }
+    auto start = std::chrono::steady_clock::now();
+    compressed = ClipCompressor::Compress(clip, settings);
+    compress_seconds = GetSeconds(start);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  SkinningRig rig = SkinningRig::FromCharacter(data.GetView());
+  size_t num_joints = rig.GetNumJoints();
+
+  // Uncompressed, every track is a float quaternion per frame.
+  size_t raw_bytes = compressed.rotation_tracks.size() *
+                     compressed.num_frames * sizeof(glm::quat);
+  size_t compressed_bytes = compressed.GetRotationBytes();
+  std::cout << compressed.rotation_tracks.size() << " rotation tracks, "
+            << compressed.num_frames << " frames at "
+            << compressed.sample_rate << " Hz, compressed in "
+            << compress_seconds << " s" << std::endl;
+  std::cout << "Size: " << raw_bytes << " bytes raw, " << compressed_bytes
+            << " compressed (" << compressed.keys.size() << " keyframes), "
+            << "ratio " << double(raw_bytes) / compressed_bytes << std::endl;
+
+  // Compares both clips at every frame, on the joints and after the
+  // transform hierarchy.
+  ClipSampler sampler(clip);
+  CompressedClipSampler compressed_sampler(compressed);
+  Pose pose;
+  Pose compressed_pose;
+  rig.GetRestPose(pose);
+  rig.GetRestPose(compressed_pose);
+  std::vector<glm::mat4> joints, skinning;
+  std::vector<glm::mat4> compressed_joints, compressed_skinning;
+  float max_angle = 0.0f;
+  float max_distance = 0.0f;
+  for (uint32_t f = 0; f < compressed.num_frames; f++) {
+    float time = std::min(f / compressed.sample_rate, compressed.duration);
+    sampler.Sample(time, pose);
+    compressed_sampler.Sample(time, compressed_pose);
+    for (size_t j = 0; j < num_joints; j++) {
+      float angle = ClipCompressor::GetAngle(pose.rotations[j],
+                                             compressed_pose.rotations[j]);
+      max_angle = std::max(max_angle, angle);
+    }
+    rig.ComputeSkinningMatrices(pose, joints, skinning);
+    compressed_sampler.SampleSkinningMatrices(time, rig, compressed_joints,
+                                              compressed_skinning);
+    for (size_t j = 0; j < num_joints; j++) {
+      max_distance = std::max(
+          max_distance,
+          glm::length(glm::vec3(joints[j][3] - compressed_joints[j][3])));
+    }
+  }
+  std::cout << "Max joint error: " << max_angle * 180.0f / kPi
+            << " degrees, " << max_distance << " units in model space"
+            << std::endl;
+
+  // Playback at 60 frames per second, looping.
+  const int kNumPalettes = 20000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kNumPalettes; i++) {
+    float time = std::fmod(i / 60.0f, compressed.duration + 1.0f / 60.0f);
+    compressed_sampler.SampleSkinningMatrices(time, rig, compressed_joints,
+                                              compressed_skinning);
+  }
+  double seconds = GetSeconds(start);
+  std::cout << "Decompression: " << seconds / kNumPalettes * 1e6
+            << " us per palette, "
+            << kNumPalettes * num_joints / seconds / 1e6
+            << " M joints/s" << std::endl;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kNumPalettes; i++) {
+    float time = std::fmod(i / 60.0f, compressed.duration + 1.0f / 60.0f);
+    sampler.Sample(time, pose);
+    rig.ComputeSkinningMatrices(pose, joints, skinning);
+  }
+  seconds = GetSeconds(start);
+  std::cout << "Uncompressed: " << seconds / kNumPalettes * 1e6
+            << " us per palette" << std::endl;
+
+  BenchmarkBlending(clip, rig);
+  return 0;
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "gloo/CharacterBundle.hpp"
+#include "gloo/parsers/CharacterParser.hpp"
+#include "gloo/parsers/GltfParser.hpp"
+
+using namespace GLOO;
+
+// Compiles PREFIX.glb, or else PREFIX.skel, PREFIX.obj and PREFIX.attach,
+// into a character bundle, which SkeletonNode then maps instead of parsing
+// the source files.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " PREFIX [OUTPUT]" << std::endl;
+    std::cout << "For example, to compile assets/assignment2/Model1.skel, "
+                 "Model1.obj and Model1.attach into Model1.chr next to "
+                 "them, run with: "
+              << argv[0] << " assets/assignment2/Model1" << std::endl;
+    return -1;
+  }
+  std::string prefix = argv[1];
+  std::string output = argc >= 3 ? argv[2] : prefix + ".chr";
+
+  CharacterData data;
+  try {
+    if (!GltfParser::Parse(prefix + ".glb", data) &&
+        !CharacterParser::Parse(prefix, data)) {
+      std::cerr << "Unable to load character " << prefix << "!" << std::endl;
+      return -1;
+    }
+    CharacterBundle::Write(output, data.GetView());
+    // Make sure the bundle loads before anyone relies on it.
+    CharacterBundle bundle;
+    CharacterView view;
+    bundle.Open(output, view);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  std::cout << "Wrote " << output << ": " << data.joint_positions.size()
+            << " joints, " << data.positions.size() << " vertices, "
+            << data.indices.size() / 3 << " triangles, "
+            << data.influences.size() << " weights" << std::endl;
+  return 0;
+}